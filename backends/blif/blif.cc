@@ -93,7 +93,7 @@ struct BlifDumper
 
 		std::map<int, RTLIL::Wire*> inputs, outputs;
 
-		for (auto &wire_it : module->wires) {
+		for (auto &wire_it : RTLIL::sorted_by_name(module->wires)) {
 			RTLIL::Wire *wire = wire_it.second;
 			if (wire->port_input)
 				inputs[wire->port_id] = wire;
@@ -128,7 +128,7 @@ struct BlifDumper
 				fprintf(f, ".names $true\n1\n");
 		}
 
-		for (auto &cell_it : module->cells)
+		for (auto &cell_it : RTLIL::sorted_by_name(module->cells))
 		{
 			RTLIL::Cell *cell = cell_it.second;
 
@@ -176,7 +176,7 @@ struct BlifDumper
 			}
 
 			fprintf(f, ".subckt %s", cstr(cell->type));
-			for (auto &conn : cell->connections)
+			for (auto &conn : RTLIL::sorted_by_name(cell->connections))
 			for (int i = 0; i < conn.second.width; i++) {
 				if (conn.second.width == 1)
 					fprintf(f, " %s", cstr(conn.first));
@@ -129,12 +129,12 @@ struct EdifBackend : public Backend {
 			if (module->memories.size() != 0)
 				log_error("Found munmapped emories in module %s: unmapped memories are not supported in EDIF backend!\n", RTLIL::id2cstr(module->name));
 
-			for (auto cell_it : module->cells)
+			for (auto cell_it : RTLIL::sorted_by_name(module->cells))
 			{
 				RTLIL::Cell *cell = cell_it.second;
 				if (!design->modules.count(cell->type) || design->modules.at(cell->type)->get_bool_attribute("\\placeholder")) {
 					lib_cell_ports[cell->type];
-					for (auto p : cell->connections) {
+					for (auto p : RTLIL::sorted_by_name(cell->connections)) {
 						if (p.second.width > 1)
 							log_error("Found multi-bit port %s on library cell %s.%s (%s): not supported in EDIF backend!\n",
 									RTLIL::id2cstr(p.first), RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
@@ -211,7 +211,7 @@ struct EdifBackend : public Backend {
 			fprintf(f, "      (view VIEW_NETLIST\n");
 			fprintf(f, "        (viewType NETLIST)\n");
 			fprintf(f, "        (interface\n");
-			for (auto &wire_it : module->wires) {
+			for (auto &wire_it : RTLIL::sorted_by_name(module->wires)) {
 				RTLIL::Wire *wire = wire_it.second;
 				if (wire->port_id == 0)
 					continue;
@@ -236,12 +236,12 @@ struct EdifBackend : public Backend {
 			fprintf(f, "        (contents\n");
 			fprintf(f, "          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n");
 			fprintf(f, "          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n");
-			for (auto &cell_it : module->cells) {
+			for (auto &cell_it : RTLIL::sorted_by_name(module->cells)) {
 				RTLIL::Cell *cell = cell_it.second;
 				fprintf(f, "          (instance %s\n", EDIF_NAME(cell->name));
 				fprintf(f, "            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_NAME(cell->type),
 						lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
-				for (auto &p : cell->parameters)
+				for (auto &p : RTLIL::sorted_by_name(cell->parameters))
 					if (!p.second.str.empty())
 						fprintf(f, "\n            (property %s (string \"%s\"))", EDIF_NAME(p.first), p.second.str.c_str());
 					else if (p.second.bits.size() <= 32 && RTLIL::SigSpec(p.second).is_fully_def())
@@ -260,7 +260,7 @@ struct EdifBackend : public Backend {
 						fprintf(f, "\n            (property %s (string \"%s\"))", EDIF_NAME(p.first), hex_string.c_str());
 					}
 				fprintf(f, ")\n");
-				for (auto &p : cell->connections) {
+				for (auto &p : RTLIL::sorted_by_name(cell->connections)) {
 					RTLIL::SigSpec sig = sigmap(p.second);
 					sig.expand();
 					for (int i = 0; i < sig.width; i++) {
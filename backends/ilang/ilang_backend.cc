@@ -112,7 +112,8 @@ void ILANG_BACKEND::dump_sigspec(FILE *f, const RTLIL::SigSpec &sig, bool autoin
 
 void ILANG_BACKEND::dump_wire(FILE *f, std::string indent, const RTLIL::Wire *wire)
 {
-	for (auto it = wire->attributes.begin(); it != wire->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(wire->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
@@ -135,7 +136,8 @@ void ILANG_BACKEND::dump_wire(FILE *f, std::string indent, const RTLIL::Wire *wi
 
 void ILANG_BACKEND::dump_memory(FILE *f, std::string indent, const RTLIL::Memory *memory)
 {
-	for (auto it = memory->attributes.begin(); it != memory->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(memory->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
@@ -150,18 +152,21 @@ void ILANG_BACKEND::dump_memory(FILE *f, std::string indent, const RTLIL::Memory
 
 void ILANG_BACKEND::dump_cell(FILE *f, std::string indent, const RTLIL::Cell *cell)
 {
-	for (auto it = cell->attributes.begin(); it != cell->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(cell->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
 	}
 	fprintf(f, "%s" "cell %s %s\n", indent.c_str(), cell->type.c_str(), cell->name.c_str());
-	for (auto it = cell->parameters.begin(); it != cell->parameters.end(); it++) {
+	auto sorted_parameters = RTLIL::sorted_by_name(cell->parameters);
+	for (auto it = sorted_parameters.begin(); it != sorted_parameters.end(); it++) {
 		fprintf(f, "%s  parameter %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
 	}
-	for (auto it = cell->connections.begin(); it != cell->connections.end(); it++) {
+	auto sorted_connections = RTLIL::sorted_by_name(cell->connections);
+	for (auto it = sorted_connections.begin(); it != sorted_connections.end(); it++) {
 		fprintf(f, "%s  connect %s ", indent.c_str(), it->first.c_str());
 		dump_sigspec(f, it->second);
 		fprintf(f, "\n");
@@ -186,7 +191,8 @@ void ILANG_BACKEND::dump_proc_case_body(FILE *f, std::string indent, const RTLIL
 
 void ILANG_BACKEND::dump_proc_switch(FILE *f, std::string indent, const RTLIL::SwitchRule *sw)
 {
-	for (auto it = sw->attributes.begin(); it != sw->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(sw->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
@@ -238,7 +244,8 @@ void ILANG_BACKEND::dump_proc_sync(FILE *f, std::string indent, const RTLIL::Syn
 
 void ILANG_BACKEND::dump_proc(FILE *f, std::string indent, const RTLIL::Process *proc)
 {
-	for (auto it = proc->attributes.begin(); it != proc->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(proc->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
@@ -261,7 +268,8 @@ void ILANG_BACKEND::dump_conn(FILE *f, std::string indent, const RTLIL::SigSpec
 
 void ILANG_BACKEND::dump_module(FILE *f, std::string indent, const RTLIL::Module *module, const RTLIL::Design *design, bool only_selected)
 {
-	for (auto it = module->attributes.begin(); it != module->attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(module->attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "attribute %s ", indent.c_str(), it->first.c_str());
 		dump_const(f, it->second);
 		fprintf(f, "\n");
@@ -269,28 +277,32 @@ void ILANG_BACKEND::dump_module(FILE *f, std::string indent, const RTLIL::Module
 
 	fprintf(f, "%s" "module %s\n", indent.c_str(), module->name.c_str());
 
-	for (auto it = module->wires.begin(); it != module->wires.end(); it++)
+	auto sorted_wires = RTLIL::sorted_by_name(module->wires);
+	for (auto it = sorted_wires.begin(); it != sorted_wires.end(); it++)
 		if (!only_selected || design->selected(module, it->second)) {
 			if (only_selected)
 				fprintf(f, "\n");
 			dump_wire(f, indent + "  ", it->second);
 		}
 
-	for (auto it = module->memories.begin(); it != module->memories.end(); it++)
+	auto sorted_memories = RTLIL::sorted_by_name(module->memories);
+	for (auto it = sorted_memories.begin(); it != sorted_memories.end(); it++)
 		if (!only_selected || design->selected(module, it->second)) {
 			if (only_selected)
 				fprintf(f, "\n");
 			dump_memory(f, indent + "  ", it->second);
 		}
 
-	for (auto it = module->cells.begin(); it != module->cells.end(); it++)
+	auto sorted_cells = RTLIL::sorted_by_name(module->cells);
+	for (auto it = sorted_cells.begin(); it != sorted_cells.end(); it++)
 		if (!only_selected || design->selected(module, it->second)) {
 			if (only_selected)
 				fprintf(f, "\n");
 			dump_cell(f, indent + "  ", it->second);
 		}
 
-	for (auto it = module->processes.begin(); it != module->processes.end(); it++)
+	auto sorted_processes = RTLIL::sorted_by_name(module->processes);
+	for (auto it = sorted_processes.begin(); it != sorted_processes.end(); it++)
 		if (!only_selected || design->selected(module, it->second)) {
 			if (only_selected)
 				fprintf(f, "\n");
@@ -369,7 +381,7 @@ struct IlangBackend : public Backend {
 } IlangBackend;
 
 struct DumpPass : public Pass {
-	DumpPass() : Pass("dump", "print parts of the design in ilang format") { }
+	DumpPass() : Pass("dump", "print parts of the design in ilang format") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
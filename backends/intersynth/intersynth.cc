@@ -151,7 +151,7 @@ struct IntersynthBackend : public Backend {
 			std::set<std::string> constcells_code;
 			netlists_code += stringf("netlist %s\n", RTLIL::id2cstr(module->name));
 
-			for (auto wire_it : module->wires) {
+			for (auto wire_it : RTLIL::sorted_by_name(module->wires)) {
 				RTLIL::Wire *wire = wire_it.second;
 				if (wire->port_input || wire->port_output) {
 					celltypes_code.insert(stringf("celltype !%s b%d %sPORT\n" "%s %s %d %s PORT\n",
@@ -162,7 +162,7 @@ struct IntersynthBackend : public Backend {
 				}
 			}
 
-			for (auto cell_it : module->cells)
+			for (auto cell_it : RTLIL::sorted_by_name(module->cells))
 			{
 				RTLIL::Cell *cell = cell_it.second;
 				std::string celltype_code, node_code;
@@ -172,13 +172,13 @@ struct IntersynthBackend : public Backend {
 
 				celltype_code = stringf("celltype %s", RTLIL::id2cstr(cell->type));
 				node_code = stringf("node %s %s", RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
-				for (auto &port : cell->connections) {
+				for (auto &port : RTLIL::sorted_by_name(cell->connections)) {
 					RTLIL::SigSpec sig = sigmap(port.second);
 					conntypes_code.insert(stringf("conntype b%d %d 2 %d\n", sig.width, sig.width, sig.width));
 					celltype_code += stringf(" b%d %s%s", sig.width, ct.cell_output(cell->type, port.first) ? "*" : "", RTLIL::id2cstr(port.first));
 					node_code += stringf(" %s %s", RTLIL::id2cstr(port.first), netname(conntypes_code, celltypes_code, constcells_code, sig).c_str());
 				}
-				for (auto &param : cell->parameters) {
+				for (auto &param : RTLIL::sorted_by_name(cell->parameters)) {
 					celltype_code += stringf(" cfg:%d %s", int(param.second.bits.size()), RTLIL::id2cstr(param.first));
 					if (param.second.bits.size() != 32) {
 						node_code += stringf(" %s '", RTLIL::id2cstr(param.first));
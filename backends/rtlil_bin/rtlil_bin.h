@@ -0,0 +1,68 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Binary RTLIL checkpoint format, written by the 'rtlil_bin' backend and
+ *  read by the 'rtlil_bin' frontend.
+ *
+ *  A file starts with a fixed size header:
+ *
+ *      char     magic[8]        "YSRTLBIN"
+ *      uint32   version         RTLIL_BIN_VERSION
+ *      uint32   reserved        0
+ *      uint64   modtab_offset   offset of the module table
+ *      uint64   module_count    number of entries in the module table
+ *      uint64   strtab_offset   offset of the string table
+ *      uint64   string_count    number of entries in the string table
+ *
+ *  All fixed size integers are little endian. The module table holds a
+ *  uint64 file offset for each module section. The string table holds all
+ *  identifiers and string constants of the design, each one stored as a
+ *  varint length, the characters and a terminating zero byte, so the reader
+ *  can use the strings directly from the mapped file.
+ *
+ *  Everything else is encoded as unsigned LEB128 varints (signed values are
+ *  zigzag encoded). Strings are referenced by their string table index.
+ *  Constants are stored as a kind followed by the data:
+ *
+ *      CONST_BITS01    varint width, 1 bit per state (only 0 and 1 bits)
+ *      CONST_BITS      varint width, 4 bits per state
+ *      CONST_STRING    string index (for constants created from strings)
+ *
+ *  A module section contains the module name and attributes, followed by
+ *  the wires, memories, cells, processes and connections of the module.
+ *  Signals reference wires by their position in the wire list.
+ *
+ */
+
+#ifndef RTLIL_BIN_H
+#define RTLIL_BIN_H
+
+#define RTLIL_BIN_MAGIC "YSRTLBIN"
+#define RTLIL_BIN_VERSION 1
+#define RTLIL_BIN_HEADER_SIZE 48
+
+namespace RTLIL_BIN {
+	enum ConstKind {
+		CONST_BITS01 = 0,
+		CONST_BITS = 1,
+		CONST_STRING = 2
+	};
+}
+
+#endif
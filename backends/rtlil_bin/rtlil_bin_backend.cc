@@ -0,0 +1,316 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Backend for the binary RTLIL checkpoint format (see rtlil_bin.h).
+ *
+ */
+
+#include "rtlil_bin.h"
+#include "kernel/register.h"
+#include "kernel/log.h"
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <string.h>
+#include <stdint.h>
+
+using namespace RTLIL_BIN;
+
+namespace {
+
+struct RtlilBinWriter
+{
+	std::string buffer;
+	// the strings in the order of their indices (the insertion order)
+	hashlib::dict<std::string, int> string_index;
+	hashlib::dict<RTLIL::Wire*, int> wire_index;
+
+	void put_u32(uint32_t v)
+	{
+		for (int i = 0; i < 4; i++)
+			buffer.push_back(char(v >> (8*i)));
+	}
+
+	void put_u64(uint64_t v)
+	{
+		for (int i = 0; i < 8; i++)
+			buffer.push_back(char(v >> (8*i)));
+	}
+
+	void set_u64(size_t pos, uint64_t v)
+	{
+		for (int i = 0; i < 8; i++)
+			buffer[pos+i] = char(v >> (8*i));
+	}
+
+	void put_varint(uint64_t v)
+	{
+		while (v >= 0x80) {
+			buffer.push_back(char(v | 0x80));
+			v = v >> 7;
+		}
+		buffer.push_back(char(v));
+	}
+
+	void put_signed(int v)
+	{
+		put_varint((uint32_t(v) << 1) ^ uint32_t(v >> 31));
+	}
+
+	void put_string(const std::string &str)
+	{
+		auto it = string_index.find(str);
+		if (it != string_index.end()) {
+			put_varint(it->second);
+			return;
+		}
+		int idx = string_index.size();
+		string_index[str] = idx;
+		put_varint(idx);
+	}
+
+	void put_const(const RTLIL::Const &data)
+	{
+		int width = data.bits.size();
+
+		if (!data.str.empty() && width == 8*int(data.str.size())) {
+			put_varint(CONST_STRING);
+			put_string(data.str);
+			return;
+		}
+
+		bool only01 = true;
+		for (auto bit : data.bits)
+			if (bit != RTLIL::S0 && bit != RTLIL::S1) {
+				only01 = false;
+				break;
+			}
+
+		put_varint(only01 ? CONST_BITS01 : CONST_BITS);
+		put_varint(width);
+
+		int bits_per_state = only01 ? 1 : 4;
+		unsigned char byte = 0;
+		int shift = 0;
+		for (auto bit : data.bits) {
+			byte |= (unsigned char)bit << shift;
+			shift += bits_per_state;
+			if (shift == 8) {
+				buffer.push_back(char(byte));
+				byte = 0, shift = 0;
+			}
+		}
+		if (shift != 0)
+			buffer.push_back(char(byte));
+	}
+
+	void put_attributes(const hashlib::dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		put_varint(attributes.size());
+		for (auto &it : attributes) {
+			put_string(it.first);
+			put_const(it.second);
+		}
+	}
+
+	void put_sigspec(const RTLIL::SigSpec &sig)
+	{
+		put_varint(sig.chunks.size());
+		for (auto &chunk : sig.chunks) {
+			put_varint(chunk.wire ? wire_index.at(chunk.wire) + 1 : 0);
+			put_varint(chunk.width);
+			put_varint(chunk.offset);
+			if (chunk.wire == NULL)
+				put_const(chunk.data);
+		}
+	}
+
+	void put_sigsig_list(const std::vector<RTLIL::SigSig> &list)
+	{
+		put_varint(list.size());
+		for (auto &it : list) {
+			put_sigspec(it.first);
+			put_sigspec(it.second);
+		}
+	}
+
+	void put_case(const RTLIL::CaseRule *cs)
+	{
+		put_varint(cs->compare.size());
+		for (auto &sig : cs->compare)
+			put_sigspec(sig);
+		put_sigsig_list(cs->actions);
+		put_varint(cs->switches.size());
+		for (auto sw : cs->switches) {
+			put_attributes(sw->attributes);
+			put_sigspec(sw->signal);
+			put_varint(sw->cases.size());
+			for (auto it : sw->cases)
+				put_case(it);
+		}
+	}
+
+	void put_module(const RTLIL::Module *module)
+	{
+		put_string(module->name);
+		put_attributes(module->attributes);
+
+		wire_index.clear();
+		put_varint(module->wires.size());
+		for (auto &it : module->wires) {
+			RTLIL::Wire *wire = it.second;
+			int idx = wire_index.size();
+			wire_index[wire] = idx;
+			put_string(wire->name);
+			put_attributes(wire->attributes);
+			put_varint(wire->width);
+			put_signed(wire->start_offset);
+			put_varint(wire->port_id);
+			put_varint((wire->port_input ? 1 : 0) | (wire->port_output ? 2 : 0) | (wire->auto_width ? 4 : 0));
+		}
+
+		put_varint(module->memories.size());
+		for (auto &it : module->memories) {
+			RTLIL::Memory *memory = it.second;
+			put_string(memory->name);
+			put_attributes(memory->attributes);
+			put_varint(memory->width);
+			put_signed(memory->start_offset);
+			put_varint(memory->size);
+		}
+
+		put_varint(module->cells.size());
+		for (auto &it : module->cells) {
+			RTLIL::Cell *cell = it.second;
+			put_string(cell->name);
+			put_string(cell->type);
+			put_attributes(cell->attributes);
+			put_varint(cell->parameters.size());
+			for (auto &it2 : cell->parameters) {
+				put_string(it2.first);
+				put_const(it2.second);
+			}
+			put_varint(cell->connections.size());
+			for (auto &it2 : cell->connections) {
+				put_string(it2.first);
+				put_sigspec(it2.second);
+			}
+		}
+
+		put_varint(module->processes.size());
+		for (auto &it : module->processes) {
+			RTLIL::Process *proc = it.second;
+			put_string(proc->name);
+			put_attributes(proc->attributes);
+			put_case(&proc->root_case);
+			put_varint(proc->syncs.size());
+			for (auto sync : proc->syncs) {
+				put_varint(sync->type);
+				put_sigspec(sync->signal);
+				put_sigsig_list(sync->actions);
+			}
+		}
+
+		put_sigsig_list(module->connections);
+	}
+
+	void write_design(FILE *f, const RTLIL::Design *design, bool only_selected)
+	{
+		std::vector<const RTLIL::Module*> modules;
+		for (auto &it : design->modules)
+			if (!only_selected || design->selected_whole_module(it.first))
+				modules.push_back(it.second);
+			else if (design->selected(it.second))
+				log_cmd_error("Can't write partially selected module %s.\n", RTLIL::id2cstr(it.first));
+
+		buffer.append(RTLIL_BIN_MAGIC, 8);
+		put_u32(RTLIL_BIN_VERSION);
+		put_u32(0);
+		size_t header_offsets = buffer.size();
+		put_u64(0);
+		put_u64(modules.size());
+		put_u64(0);
+		put_u64(0);
+		assert(buffer.size() == RTLIL_BIN_HEADER_SIZE);
+
+		std::vector<uint64_t> module_offsets;
+		for (auto module : modules) {
+			module_offsets.push_back(buffer.size());
+			put_module(module);
+		}
+
+		set_u64(header_offsets, buffer.size());
+		for (auto offset : module_offsets)
+			put_u64(offset);
+
+		set_u64(header_offsets + 16, buffer.size());
+		set_u64(header_offsets + 24, string_index.size());
+		for (auto &it : string_index) {
+			put_varint(it.first.size());
+			buffer.append(it.first);
+			buffer.push_back(0);
+		}
+
+		if (fwrite(buffer.data(), 1, buffer.size(), f) != buffer.size())
+			log_error("Writing binary RTLIL file failed.\n");
+		log("Wrote %d modules, %d strings, %d bytes.\n", int(modules.size()), int(string_index.size()), int(buffer.size()));
+	}
+};
+
+} /* namespace */
+
+struct RtlilBinBackend : public Backend {
+	RtlilBinBackend() : Backend("rtlil_bin", "write design to binary RTLIL file") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    write_rtlil_bin [options] [filename]\n");
+		log("\n");
+		log("Write the current design to a binary RTLIL file. This is a compact checkpoint\n");
+		log("format for passing designs between yosys runs that can be loaded much faster\n");
+		log("than ilang files (see 'help read_rtlil_bin').\n");
+		log("\n");
+		log("    -selected\n");
+		log("        only write selected modules. partially selected modules are\n");
+		log("        not supported.\n");
+		log("\n");
+	}
+	virtual void execute(FILE *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		bool selected = false;
+
+		log_header("Executing binary RTLIL backend.\n");
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++) {
+			std::string arg = args[argidx];
+			if (arg == "-selected") {
+				selected = true;
+				continue;
+			}
+			break;
+		}
+		extra_args(f, filename, args, argidx);
+
+		log("Output filename: %s\n", filename.c_str());
+		RtlilBinWriter writer;
+		writer.write_design(f, design, selected);
+	}
+} RtlilBinBackend;
@@ -76,15 +76,18 @@ void reset_auto_counter(RTLIL::Module *module)
 
 	reset_auto_counter_id(module->name, false);
 
-	for (auto it = module->wires.begin(); it != module->wires.end(); it++)
+	auto sorted_wires = RTLIL::sorted_by_name(module->wires);
+	for (auto it = sorted_wires.begin(); it != sorted_wires.end(); it++)
 		reset_auto_counter_id(it->second->name, true);
 
-	for (auto it = module->cells.begin(); it != module->cells.end(); it++) {
+	auto sorted_cells = RTLIL::sorted_by_name(module->cells);
+	for (auto it = sorted_cells.begin(); it != sorted_cells.end(); it++) {
 		reset_auto_counter_id(it->second->name, true);
 		reset_auto_counter_id(it->second->type, false);
 	}
 
-	for (auto it = module->processes.begin(); it != module->processes.end(); it++)
+	auto sorted_processes = RTLIL::sorted_by_name(module->processes);
+	for (auto it = sorted_processes.begin(); it != sorted_processes.end(); it++)
 		reset_auto_counter_id(it->second->name, false);
 
 	auto_name_digits = 1;
@@ -230,11 +233,12 @@ void dump_sigspec(FILE *f, RTLIL::SigSpec &sig)
 	}
 }
 
-void dump_attributes(FILE *f, std::string indent, std::map<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n')
+void dump_attributes(FILE *f, std::string indent, hashlib::dict<RTLIL::IdString, RTLIL::Const> &attributes, char term = '\n')
 {
 	if (noattr)
 		return;
-	for (auto it = attributes.begin(); it != attributes.end(); it++) {
+	auto sorted_attributes = RTLIL::sorted_by_name(attributes);
+	for (auto it = sorted_attributes.begin(); it != sorted_attributes.end(); it++) {
 		fprintf(f, "%s" "%s %s", indent.c_str(), attr2comment ? "/*" : "(*", id(it->first).c_str());
 		fprintf(f, " = ");
 		dump_const(f, it->second);
@@ -591,8 +595,9 @@ void dump_cell(FILE *f, std::string indent, RTLIL::Cell *cell)
 
 	if (cell->parameters.size() > 0) {
 		fprintf(f, " #(");
-		for (auto it = cell->parameters.begin(); it != cell->parameters.end(); it++) {
-			if (it != cell->parameters.begin())
+		auto sorted_parameters = RTLIL::sorted_by_name(cell->parameters);
+		for (auto it = sorted_parameters.begin(); it != sorted_parameters.end(); it++) {
+			if (it != sorted_parameters.begin())
 				fprintf(f, ",");
 			fprintf(f, "\n%s  .%s(", indent.c_str(), id(it->first).c_str());
 			dump_const(f, it->second);
@@ -608,11 +613,12 @@ void dump_cell(FILE *f, std::string indent, RTLIL::Cell *cell)
 		fprintf(f, " %s (", cell_name.c_str());
 
 	bool first_arg = true;
+	auto sorted_connections = RTLIL::sorted_by_name(cell->connections);
 	std::set<std::string> numbered_ports;
 	for (int i = 1; true; i++) {
 		char str[16];
 		snprintf(str, 16, "$%d", i);
-		for (auto it = cell->connections.begin(); it != cell->connections.end(); it++) {
+		for (auto it = sorted_connections.begin(); it != sorted_connections.end(); it++) {
 			if (it->first != str)
 				continue;
 			if (!first_arg)
@@ -626,7 +632,7 @@ void dump_cell(FILE *f, std::string indent, RTLIL::Cell *cell)
 		break;
 	found_numbered_port:;
 	}
-	for (auto it = cell->connections.begin(); it != cell->connections.end(); it++) {
+	for (auto it = sorted_connections.begin(); it != sorted_connections.end(); it++) {
 		if (numbered_ports.count(it->first))
 			continue;
 		if (!first_arg)
@@ -803,7 +809,8 @@ void dump_module(FILE *f, std::string indent, RTLIL::Module *module)
 	reset_auto_counter(module);
 	active_module = module;
 
-	for (auto it = module->processes.begin(); it != module->processes.end(); it++)
+	auto sorted_processes = RTLIL::sorted_by_name(module->processes);
+	for (auto it = sorted_processes.begin(); it != sorted_processes.end(); it++)
 		dump_process(f, indent + "  ", it->second, true);
 
 	if (!noexpr)
@@ -835,10 +842,11 @@ void dump_module(FILE *f, std::string indent, RTLIL::Module *module)
 
 	dump_attributes(f, indent, module->attributes);
 	fprintf(f, "%s" "module %s(", indent.c_str(), id(module->name, false).c_str());
+	auto sorted_wires = RTLIL::sorted_by_name(module->wires);
 	bool keep_running = true;
 	for (int port_id = 1; keep_running; port_id++) {
 		keep_running = false;
-		for (auto it = module->wires.begin(); it != module->wires.end(); it++) {
+		for (auto it = sorted_wires.begin(); it != sorted_wires.end(); it++) {
 			RTLIL::Wire *wire = it->second;
 			if (wire->port_id == port_id) {
 				if (port_id != 1)
@@ -851,16 +859,18 @@ void dump_module(FILE *f, std::string indent, RTLIL::Module *module)
 	}
 	fprintf(f, ");\n");
 
-	for (auto it = module->wires.begin(); it != module->wires.end(); it++)
+	for (auto it = sorted_wires.begin(); it != sorted_wires.end(); it++)
 		dump_wire(f, indent + "  ", it->second);
 
-	for (auto it = module->memories.begin(); it != module->memories.end(); it++)
+	auto sorted_memories = RTLIL::sorted_by_name(module->memories);
+	for (auto it = sorted_memories.begin(); it != sorted_memories.end(); it++)
 		dump_memory(f, indent + "  ", it->second);
 
-	for (auto it = module->cells.begin(); it != module->cells.end(); it++)
+	auto sorted_cells = RTLIL::sorted_by_name(module->cells);
+	for (auto it = sorted_cells.begin(); it != sorted_cells.end(); it++)
 		dump_cell(f, indent + "  ", it->second);
 
-	for (auto it = module->processes.begin(); it != module->processes.end(); it++)
+	for (auto it = sorted_processes.begin(); it != sorted_processes.end(); it++)
 		dump_process(f, indent + "  ", it->second);
 
 	for (auto it = module->connections.begin(); it != module->connections.end(); it++)
@@ -921,9 +931,9 @@ struct VerilogBackend : public Backend {
 
 		reg_ct.clear();
 		reg_ct.setup_stdcells_mem();
-		reg_ct.cell_types.insert("$sr");
-		reg_ct.cell_types.insert("$dff");
-		reg_ct.cell_types.insert("$adff");
+		reg_ct.cell_types.set(CT_sr);
+		reg_ct.cell_types.set(CT_dff);
+		reg_ct.cell_types.set(CT_adff);
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -229,6 +229,7 @@ AstNode::~AstNode()
 void AstNode::dumpAst(FILE *f, std::string indent)
 {
 	if (f == NULL) {
+		log_flush();
 		for (auto f : log_files)
 			dumpAst(f, indent);
 		return;
@@ -291,6 +292,7 @@ void AstNode::dumpVlog(FILE *f, std::string indent)
 	std::vector<AstNode*> rem_children1, rem_children2;
 
 	if (f == NULL) {
+		log_flush();
 		for (auto f : log_files)
 			dumpVlog(f, indent);
 		return;
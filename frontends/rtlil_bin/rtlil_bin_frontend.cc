@@ -0,0 +1,413 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Frontend for the binary RTLIL checkpoint format (see rtlil_bin.h).
+ *
+ *  Regular files are mapped into memory and decoded in place. Strings are
+ *  taken directly from the mapped string table and each identifier is only
+ *  interned once, when it is first used.
+ *
+ */
+
+#include "backends/rtlil_bin/rtlil_bin.h"
+#include "kernel/register.h"
+#include "kernel/log.h"
+#include <string>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace RTLIL_BIN;
+
+#define RTLIL_BIN_MAX_CASE_DEPTH 10000
+
+namespace {
+
+struct RtlilBinReader
+{
+	const unsigned char *begin, *ptr, *end;
+	std::vector<const char*> strings;
+	std::vector<size_t> string_sizes;
+	std::vector<RTLIL::IdString> ids;
+	std::vector<RTLIL::Wire*> wires;
+
+	RtlilBinReader(const unsigned char *data, size_t size) : begin(data), ptr(data), end(data + size) { }
+
+	void corrupt()
+	{
+		log_error("Binary RTLIL file is truncated or corrupt (at offset %d).\n", int(ptr - begin));
+	}
+
+	void seek(uint64_t offset)
+	{
+		if (offset > uint64_t(end - begin))
+			corrupt();
+		ptr = begin + offset;
+	}
+
+	uint64_t get_fixed(int bytes)
+	{
+		if (end - ptr < bytes)
+			corrupt();
+		uint64_t v = 0;
+		for (int i = 0; i < bytes; i++)
+			v |= uint64_t(*ptr++) << (8*i);
+		return v;
+	}
+
+	uint64_t get_varint()
+	{
+		uint64_t v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (ptr == end)
+				corrupt();
+			unsigned char byte = *ptr++;
+			v |= uint64_t(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0)
+				return v;
+		}
+		corrupt();
+		return 0;
+	}
+
+	int get_int()
+	{
+		uint64_t v = get_varint();
+		if (v > 0x7fffffff)
+			corrupt();
+		return v;
+	}
+
+	// element count for a list of elements that take at least min_bytes each,
+	// so that a corrupt count can not cause a huge allocation
+	int get_count(int min_bytes)
+	{
+		int count = get_int();
+		if (count > (end - ptr) / min_bytes)
+			corrupt();
+		return count;
+	}
+
+	int get_signed()
+	{
+		uint32_t v = get_varint();
+		return int(v >> 1) ^ -int(v & 1);
+	}
+
+	int get_string_index()
+	{
+		uint64_t idx = get_varint();
+		if (idx >= strings.size())
+			corrupt();
+		return idx;
+	}
+
+	std::string get_string()
+	{
+		int idx = get_string_index();
+		return std::string(strings[idx], string_sizes[idx]);
+	}
+
+	RTLIL::IdString get_id()
+	{
+		int idx = get_string_index();
+		if (ids[idx].empty()) {
+			if (string_sizes[idx] < 2 || (strings[idx][0] != '\\' && strings[idx][0] != '$'))
+				corrupt();
+			ids[idx] = RTLIL::IdString(strings[idx]);
+		}
+		return ids[idx];
+	}
+
+	RTLIL::Const get_const()
+	{
+		int kind = get_int();
+		if (kind == CONST_STRING)
+			return RTLIL::Const(get_string());
+		if (kind != CONST_BITS01 && kind != CONST_BITS)
+			corrupt();
+
+		int width = get_int();
+		int bits_per_state = kind == CONST_BITS01 ? 1 : 4;
+		int states_per_byte = 8 / bits_per_state;
+		if ((end - ptr) < (width + states_per_byte - 1) / states_per_byte)
+			corrupt();
+
+		RTLIL::Const data;
+		data.bits.resize(width);
+		unsigned char mask = (1 << bits_per_state) - 1;
+		for (int i = 0; i < width; i++) {
+			unsigned char state = (ptr[i / states_per_byte] >> (bits_per_state * (i % states_per_byte))) & mask;
+			if (state > RTLIL::Sm)
+				corrupt();
+			data.bits[i] = RTLIL::State(state);
+		}
+		ptr += (width + states_per_byte - 1) / states_per_byte;
+		return data;
+	}
+
+	void get_attributes(hashlib::dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		int count = get_int();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString name = get_id();
+			attributes[name] = get_const();
+		}
+	}
+
+	RTLIL::SigSpec get_sigspec()
+	{
+		RTLIL::SigSpec sig;
+		int count = get_count(3);
+		sig.chunks.resize(count);
+		for (auto &chunk : sig.chunks) {
+			uint64_t wire_idx = get_varint();
+			chunk.width = get_int();
+			chunk.offset = get_int();
+			if (wire_idx == 0) {
+				chunk.wire = NULL;
+				chunk.data = get_const();
+				if (chunk.offset != 0 || size_t(chunk.width) != chunk.data.bits.size())
+					corrupt();
+			} else {
+				if (wire_idx > wires.size())
+					corrupt();
+				chunk.wire = wires[wire_idx - 1];
+				if (chunk.offset > chunk.wire->width || chunk.width > chunk.wire->width - chunk.offset)
+					corrupt();
+			}
+			if (chunk.width > 0x7fffffff - sig.width)
+				corrupt();
+			sig.width += chunk.width;
+		}
+		sig.check();
+		return sig;
+	}
+
+	void get_sigsig_list(std::vector<RTLIL::SigSig> &list)
+	{
+		int count = get_count(2);
+		list.reserve(list.size() + count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::SigSpec first = get_sigspec();
+			RTLIL::SigSpec second = get_sigspec();
+			if (first.width != second.width)
+				corrupt();
+			list.push_back(RTLIL::SigSig(first, second));
+		}
+	}
+
+	// the nesting depth is limited so that a corrupt file can't overflow the
+	// stack, this is far more than any real design uses
+	void get_case(RTLIL::CaseRule *cs, int depth = 0)
+	{
+		if (depth > RTLIL_BIN_MAX_CASE_DEPTH)
+			corrupt();
+		int count = get_count(1);
+		for (int i = 0; i < count; i++)
+			cs->compare.push_back(get_sigspec());
+		get_sigsig_list(cs->actions);
+		count = get_count(3);
+		for (int i = 0; i < count; i++) {
+			RTLIL::SwitchRule *sw = new RTLIL::SwitchRule;
+			cs->switches.push_back(sw);
+			get_attributes(sw->attributes);
+			sw->signal = get_sigspec();
+			int case_count = get_count(3);
+			for (int j = 0; j < case_count; j++) {
+				RTLIL::CaseRule *rule = new RTLIL::CaseRule;
+				sw->cases.push_back(rule);
+				get_case(rule, depth + 1);
+			}
+		}
+	}
+
+	void get_module(RTLIL::Design *design)
+	{
+		RTLIL::IdString name = get_id();
+		if (design->modules.count(name) != 0)
+			log_error("Re-definition of module %s!\n", RTLIL::id2cstr(name));
+
+		RTLIL::Module *module = new RTLIL::Module;
+		module->name = name;
+		design->modules[name] = module;
+		get_attributes(module->attributes);
+
+		int count = get_count(6);
+		wires.clear();
+		wires.reserve(count);
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString wire_name = get_id();
+			if (module->count_id(wire_name) != 0)
+				corrupt();
+			RTLIL::Wire *wire = module->addWire(wire_name);
+			get_attributes(wire->attributes);
+			wire->width = get_int();
+			wire->start_offset = get_signed();
+			wire->port_id = get_int();
+			int flags = get_int();
+			wire->port_input = (flags & 1) != 0;
+			wire->port_output = (flags & 2) != 0;
+			wire->auto_width = (flags & 4) != 0;
+			wires.push_back(wire);
+		}
+
+		count = get_int();
+		for (int i = 0; i < count; i++) {
+			RTLIL::Memory *memory = new RTLIL::Memory;
+			memory->name = get_id();
+			if (module->count_id(memory->name) != 0)
+				corrupt();
+			module->memories[memory->name] = memory;
+			get_attributes(memory->attributes);
+			memory->width = get_int();
+			memory->start_offset = get_signed();
+			memory->size = get_int();
+		}
+
+		count = get_int();
+		for (int i = 0; i < count; i++) {
+			RTLIL::IdString cell_name = get_id();
+			if (module->count_id(cell_name) != 0)
+				corrupt();
+			RTLIL::Cell *cell = module->addCell(cell_name, get_id());
+			get_attributes(cell->attributes);
+			int param_count = get_int();
+			for (int j = 0; j < param_count; j++) {
+				RTLIL::IdString param_name = get_id();
+				cell->parameters[param_name] = get_const();
+			}
+			int conn_count = get_int();
+			for (int j = 0; j < conn_count; j++) {
+				RTLIL::IdString port_name = get_id();
+				cell->connections[port_name] = get_sigspec();
+			}
+		}
+
+		count = get_int();
+		for (int i = 0; i < count; i++) {
+			RTLIL::Process *proc = new RTLIL::Process;
+			proc->name = get_id();
+			if (module->count_id(proc->name) != 0)
+				corrupt();
+			module->processes[proc->name] = proc;
+			get_attributes(proc->attributes);
+			get_case(&proc->root_case);
+			int sync_count = get_int();
+			for (int j = 0; j < sync_count; j++) {
+				RTLIL::SyncRule *sync = new RTLIL::SyncRule;
+				proc->syncs.push_back(sync);
+				int type = get_int();
+				if (type > RTLIL::STa)
+					corrupt();
+				sync->type = RTLIL::SyncType(type);
+				sync->signal = get_sigspec();
+				get_sigsig_list(sync->actions);
+			}
+		}
+
+		get_sigsig_list(module->connections);
+	}
+
+	void read_design(RTLIL::Design *design)
+	{
+		if (end - begin < RTLIL_BIN_HEADER_SIZE || memcmp(begin, RTLIL_BIN_MAGIC, 8))
+			log_error("Input file is not a binary RTLIL file.\n");
+		ptr += 8;
+
+		int version = get_fixed(4);
+		if (version != RTLIL_BIN_VERSION)
+			log_error("Unsupported binary RTLIL version %d (expected %d).\n", version, RTLIL_BIN_VERSION);
+		get_fixed(4);
+
+		uint64_t modtab_offset = get_fixed(8);
+		uint64_t module_count = get_fixed(8);
+		uint64_t strtab_offset = get_fixed(8);
+		uint64_t string_count = get_fixed(8);
+
+		if (string_count > uint64_t(end - begin))
+			corrupt();
+		seek(strtab_offset);
+		strings.reserve(string_count);
+		string_sizes.reserve(string_count);
+		for (uint64_t i = 0; i < string_count; i++) {
+			uint64_t len = get_varint();
+			if (len >= uint64_t(end - ptr) || ptr[len] != 0)
+				corrupt();
+			strings.push_back((const char*)ptr);
+			string_sizes.push_back(len);
+			ptr += len + 1;
+		}
+		ids.resize(string_count);
+
+		if (module_count > uint64_t(end - begin) / 8)
+			corrupt();
+		for (uint64_t i = 0; i < module_count; i++) {
+			seek(modtab_offset + 8*i);
+			seek(get_fixed(8));
+			get_module(design);
+		}
+
+		log("Read %d modules, %d strings.\n", int(module_count), int(string_count));
+	}
+};
+
+} /* namespace */
+
+struct RtlilBinFrontend : public Frontend {
+	RtlilBinFrontend() : Frontend("rtlil_bin", "read modules from binary RTLIL file") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    read_rtlil_bin [filename]\n");
+		log("\n");
+		log("Load modules from a binary RTLIL file (as written by 'write_rtlil_bin') to the\n");
+		log("current design. Regular files are mapped into memory and decoded without a\n");
+		log("parser, so this is much faster than reading an ilang file.\n");
+		log("\n");
+	}
+	virtual void execute(FILE *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Executing binary RTLIL frontend.\n");
+		extra_args(f, filename, args, 1);
+		log("Input filename: %s\n", filename.c_str());
+
+		struct stat st;
+		void *mapped = MAP_FAILED;
+		if (fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+			mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+
+		if (mapped != MAP_FAILED) {
+			RtlilBinReader reader((const unsigned char*)mapped, st.st_size);
+			reader.read_design(design);
+			munmap(mapped, st.st_size);
+		} else {
+			std::vector<unsigned char> buffer;
+			unsigned char chunk[65536];
+			size_t n;
+			while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+				buffer.insert(buffer.end(), chunk, chunk + n);
+			RtlilBinReader reader(buffer.data(), buffer.size());
+			reader.read_design(design);
+		}
+	}
+} RtlilBinFrontend;
@@ -0,0 +1,153 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Pool allocator for the objects owned by an RTLIL::Module.
+ *
+ *  An Arena hands out memory from large blocks and keeps freed objects on
+ *  per-size free lists. Every object carries a small header that points back
+ *  to its arena (or is NULL for objects allocated from the heap), so objects
+ *  can always be freed with a plain 'delete', no matter where they have been
+ *  allocated or which module they ended up in.
+ *
+ *  Arenas are reference counted: the owner holds one reference and every
+ *  live object holds another one. The blocks are released when the owner
+ *  has called release() and the last object has been freed.
+ *
+ *  An object that has been moved to another module is still freed into the
+ *  arena it was allocated from, possibly while another thread allocates from
+ *  that arena for its own module (see Pass::execute_modules()). So the
+ *  reference count is atomic and the blocks and free lists are protected by
+ *  a (practically always uncontended) mutex.
+ *
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+struct Arena
+{
+	struct header_t {
+		Arena *arena;
+		size_t size;
+	};
+
+	std::atomic<int> refcount;
+	std::mutex mutex;
+	size_t total_size;
+	size_t next_block_size;
+	char *block_ptr;
+	size_t block_avail;
+	std::vector<char*> blocks;
+	std::vector<void*> free_lists;
+
+	Arena() : refcount(1), total_size(0), next_block_size(4096), block_ptr(NULL), block_avail(0) { }
+
+	~Arena()
+	{
+		for (auto block : blocks)
+			::free(block);
+	}
+
+	void release()
+	{
+		if (--refcount == 0)
+			delete this;
+	}
+
+	static void *alloc(Arena *arena, size_t size)
+	{
+		size = (size + sizeof(header_t) + 15) & ~size_t(15);
+		header_t *hdr = (header_t*)(arena ? arena->alloc_block(size) : malloc(size));
+		if (hdr == NULL)
+			throw std::bad_alloc();
+		hdr->arena = arena;
+		hdr->size = size;
+		return hdr + 1;
+	}
+
+	static void free(void *ptr)
+	{
+		if (ptr == NULL)
+			return;
+		header_t *hdr = (header_t*)ptr - 1;
+		if (hdr->arena == NULL) {
+			::free(hdr);
+			return;
+		}
+		Arena *arena = hdr->arena;
+		size_t idx = hdr->size / 16;
+		{
+			std::lock_guard<std::mutex> lock(arena->mutex);
+			*(void**)hdr = arena->free_lists[idx];
+			arena->free_lists[idx] = hdr;
+		}
+		arena->release();
+	}
+
+private:
+	void *alloc_block(size_t size)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		size_t idx = size / 16;
+		if (idx >= free_lists.size())
+			free_lists.resize(idx + 1, NULL);
+
+		void *ptr = free_lists[idx];
+		if (ptr != NULL) {
+			free_lists[idx] = *(void**)ptr;
+		} else {
+			if (block_avail < size) {
+				size_t block_size = std::max(next_block_size, size);
+				if (next_block_size < (1 << 20))
+					next_block_size *= 2;
+				block_ptr = (char*)malloc(block_size);
+				if (block_ptr == NULL)
+					return NULL;
+				blocks.push_back(block_ptr);
+				block_avail = block_size;
+				total_size += block_size;
+			}
+			ptr = block_ptr;
+			block_ptr += size;
+			block_avail -= size;
+		}
+
+		refcount++;
+		return ptr;
+	}
+};
+
+// Base class for objects that can be allocated from an Arena using
+// 'new (arena) T(...)'. A plain 'new T(...)' allocates from the heap.
+struct ArenaObject
+{
+	static void *operator new(size_t size) { return Arena::alloc(NULL, size); }
+	static void *operator new(size_t size, Arena *arena) { return Arena::alloc(arena, size); }
+	static void operator delete(void *ptr) { Arena::free(ptr); }
+	static void operator delete(void *ptr, Arena*) { Arena::free(ptr); }
+};
+
+#endif
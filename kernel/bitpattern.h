@@ -29,21 +29,17 @@ struct BitPatternPool
 	typedef std::vector<RTLIL::State> bits_t;
 	std::set<bits_t> pool;
 
-	BitPatternPool(RTLIL::SigSpec sig)
+	BitPatternPool(const RTLIL::SigSpec &sig)
 	{
 		width = sig.width;
 		if (width > 0) {
-			std::vector<RTLIL::State> pattern(width);
-			sig.optimize();
-			for (int i = 0; i < width; i++) {
-				RTLIL::SigSpec s = sig.extract(i, 1);
-				s.optimize();
-				assert(s.chunks.size() == 1);
-				if (s.chunks[0].wire == NULL && s.chunks[0].data.bits[0] <= RTLIL::State::S1)
-					pattern[i] = s.chunks[0].data.bits[0];
+			std::vector<RTLIL::State> pattern;
+			pattern.reserve(width);
+			for (auto bit : sig)
+				if (bit.wire == NULL && bit.data <= RTLIL::State::S1)
+					pattern.push_back(bit.data);
 				else
-					pattern[i] = RTLIL::State::Sa;
-			}
+					pattern.push_back(RTLIL::State::Sa);
 			pool.insert(pattern);
 		}
 	}
@@ -59,19 +55,18 @@ struct BitPatternPool
 		}
 	}
 
-	bits_t sig2bits(RTLIL::SigSpec sig)
+	bits_t sig2bits(const RTLIL::SigSpec &sig)
 	{
-		sig.optimize();
-		assert(sig.is_fully_const());
-		assert(sig.chunks.size() == 1);
-		bits_t bits = sig.chunks[0].data.bits;
-		for (auto &b : bits)
-			if (b > RTLIL::State::S1)
-				b = RTLIL::State::Sa;
+		bits_t bits;
+		bits.reserve(sig.width);
+		for (auto bit : sig) {
+			assert(bit.wire == NULL);
+			bits.push_back(bit.data > RTLIL::State::S1 ? RTLIL::State::Sa : bit.data);
+		}
 		return bits;
 	}
 
-	bool match(bits_t a, bits_t b)
+	bool match(const bits_t &a, const bits_t &b)
 	{
 		assert(int(a.size()) == width);
 		assert(int(b.size()) == width);
@@ -81,7 +76,7 @@ struct BitPatternPool
 		return true;
 	}
 
-	bool has_any(RTLIL::SigSpec sig)
+	bool has_any(const RTLIL::SigSpec &sig)
 	{
 		bits_t bits = sig2bits(sig);
 		for (auto &it : pool)
@@ -90,7 +85,7 @@ struct BitPatternPool
 		return false;
 	}
 
-	bool has_all(RTLIL::SigSpec sig)
+	bool has_all(const RTLIL::SigSpec &sig)
 	{
 		bits_t bits = sig2bits(sig);
 		for (auto &it : pool)
@@ -104,7 +99,7 @@ struct BitPatternPool
 		return false;
 	}
 
-	bool take(RTLIL::SigSpec sig)
+	bool take(const RTLIL::SigSpec &sig)
 	{
 		bool status = false;
 		bits_t bits = sig2bits(sig);
@@ -112,7 +107,7 @@ struct BitPatternPool
 		for (auto &it : pool)
 			if (match(it, bits))
 				pattern_list.push_back(it);
-		for (auto pattern : pattern_list) {
+		for (auto &pattern : pattern_list) {
 			pool.erase(pattern);
 			for (int i = 0; i < width; i++) {
 				if (pattern[i] != RTLIL::State::Sa || bits[i] == RTLIL::State::Sa)
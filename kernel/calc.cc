@@ -20,6 +20,7 @@
 #include "kernel/rtlil.h"
 #include "libs/bigint/BigIntegerLibrary.hh"
 #include <assert.h>
+#include <stdint.h>
 
 static BigInteger const2big(const RTLIL::Const &val, bool as_signed, int &undef_bit_pos)
 {
@@ -67,35 +68,245 @@ static RTLIL::Const big2const(const BigInteger &val, int result_len, int undef_b
 	return result;
 }
 
-static RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
+// Fully defined operands that fit into a native signed integer type are
+// evaluated without BigInteger. There is one instance for operands of up
+// to 64 bits and, if the compiler has the __int128 extension, one for
+// operands of up to 128 bits. The native_* functions return false if an
+// operand has undef bits, does not fit into T or if the result would
+// overflow T. The caller then falls back to the BigInteger implementation.
+
+#ifdef __SIZEOF_INT128__
+typedef __int128 int128_t;
+typedef unsigned __int128 uint128_t;
+#endif
+
+template<typename T> struct native_traits { };
+template<> struct native_traits<int64_t> { typedef uint64_t unsigned_t; };
+#ifdef __SIZEOF_INT128__
+template<> struct native_traits<int128_t> { typedef uint128_t unsigned_t; };
+#endif
+
+// overflow checked arithmetic, using the compiler builtins where available
+// (gcc 5, clang 3.8) and plain two's complement arithmetic otherwise
+
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_add_overflow)
+#    define CALC_HAVE_OVERFLOW_BUILTINS
+#  endif
+#elif defined(__GNUC__) && __GNUC__ >= 5
+#  define CALC_HAVE_OVERFLOW_BUILTINS
+#endif
+
+template<typename T>
+static inline bool native_add_overflow(T a, T b, T *y)
+{
+#ifdef CALC_HAVE_OVERFLOW_BUILTINS
+	return __builtin_add_overflow(a, b, y);
+#else
+	typedef typename native_traits<T>::unsigned_t U;
+	*y = T(U(a) + U(b));
+	return ((a ^ *y) & (b ^ *y)) < 0;
+#endif
+}
+
+template<typename T>
+static inline bool native_sub_overflow(T a, T b, T *y)
+{
+#ifdef CALC_HAVE_OVERFLOW_BUILTINS
+	return __builtin_sub_overflow(a, b, y);
+#else
+	typedef typename native_traits<T>::unsigned_t U;
+	*y = T(U(a) - U(b));
+	return ((a ^ b) & (a ^ *y)) < 0;
+#endif
+}
+
+template<typename T>
+static inline bool native_mul_overflow(T a, T b, T *y)
+{
+#ifdef CALC_HAVE_OVERFLOW_BUILTINS
+	return __builtin_mul_overflow(a, b, y);
+#else
+	typedef typename native_traits<T>::unsigned_t U;
+	const T min_value = T(U(1) << (8*sizeof(T)-1));
+	*y = T(U(a) * U(b));
+	if (a == 0 || b == 0)
+		return false;
+	if ((a == -1 && b == min_value) || (b == -1 && a == min_value))
+		return true;
+	return *y / b != a;
+#endif
+}
+
+template<typename T>
+static inline bool native_fits(const RTLIL::Const &val, bool as_signed)
+{
+	return int(val.bits.size()) < 8*int(sizeof(T)) || (as_signed && int(val.bits.size()) == 8*int(sizeof(T)));
+}
+
+template<typename T>
+static bool const2native(const RTLIL::Const &val, bool as_signed, T &result)
+{
+	typedef typename native_traits<T>::unsigned_t U;
+	U bits = 0;
+	int width = val.bits.size();
+	for (int i = 0; i < width; i++) {
+		if (val.bits[i] == RTLIL::State::S1)
+			bits |= U(1) << i;
+		else if (val.bits[i] != RTLIL::State::S0)
+			return false;
+	}
+	if (as_signed && width > 0 && width < 8*int(sizeof(T)) && val.bits[width-1] == RTLIL::State::S1)
+		bits |= ~U(0) << width;
+	result = T(bits);
+	return true;
+}
+
+template<typename T>
+static RTLIL::Const native2const(T val, int result_len)
+{
+	typedef typename native_traits<T>::unsigned_t U;
+	RTLIL::Const result(RTLIL::State::S0, result_len);
+	U bits = U(val);
+	for (int i = 0; i < result_len; i++)
+		if (i < 8*int(sizeof(T)) ? ((bits >> i) & 1) != 0 : val < 0)
+			result.bits[i] = RTLIL::State::S1;
+	return result;
+}
+
+enum native_op_t { NATIVE_ADD, NATIVE_SUB, NATIVE_MUL, NATIVE_DIV, NATIVE_MOD, NATIVE_POW };
+
+// returns 1 on success, 0 if the operands or the result do not fit into
+// T and -1 for undef operands and division by zero
+template<typename T>
+static int native_arith(native_op_t op, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, RTLIL::Const &result)
+{
+	typedef typename native_traits<T>::unsigned_t U;
+	const T min_value = T(U(1) << (8*sizeof(T)-1));
+	T a, b, y = 0;
+
+	if (!native_fits<T>(arg1, signed1) || !native_fits<T>(arg2, signed2))
+		return 0;
+	if (!const2native(arg1, signed1, a) || !const2native(arg2, signed2, b))
+		return -1;
+
+	switch (op)
+	{
+	case NATIVE_ADD:
+		if (native_add_overflow(a, b, &y))
+			return 0;
+		break;
+	case NATIVE_SUB:
+		if (native_sub_overflow(a, b, &y))
+			return 0;
+		break;
+	case NATIVE_MUL:
+		if (native_mul_overflow(a, b, &y))
+			return 0;
+		break;
+	case NATIVE_DIV:
+	case NATIVE_MOD:
+		if (b == 0)
+			return -1;
+		if (a == min_value && b == -1)
+			return 0;
+		y = op == NATIVE_DIV ? a / b : a % b;
+		break;
+	case NATIVE_POW:
+		if (b < 0 || a == 0) {
+			y = 0;
+		} else if (a == 1 || (a == -1 && (b & 1) == 0)) {
+			y = 1;
+		} else if (a == -1) {
+			y = -1;
+		} else {
+			// |a| >= 2, so larger exponents always overflow
+			if (b >= T(8*sizeof(T)))
+				return 0;
+			for (y = 1; b > 0; b--)
+				if (native_mul_overflow(y, a, &y))
+					return 0;
+		}
+		break;
+	}
+
+	result = native2const(y, result_len >= 0 ? result_len : std::max(arg1.bits.size(), arg2.bits.size()));
+	return 1;
+}
+
+static bool native_arith(native_op_t op, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len, RTLIL::Const &result)
+{
+	int ret = native_arith<int64_t>(op, arg1, arg2, signed1, signed2, result_len, result);
+#ifdef __SIZEOF_INT128__
+	if (ret == 0)
+		ret = native_arith<int128_t>(op, arg1, arg2, signed1, signed2, result_len, result);
+#endif
+	return ret > 0;
+}
+
+// The bitwise, reduce and logic ops work directly on the State vectors. A
+// constant is not stored packed, so packing the operands into words costs
+// a loop over all bits already, and for these ops that is as much work as
+// evaluating them bit by bit (see const_* in tests/bench/rtlil_bench).
+
+// bit i of c, extended to any width with the sign bit or zeros
+static inline RTLIL::State ext_bit(const RTLIL::Const &c, int i, bool is_signed)
+{
+	if (i < int(c.bits.size()))
+		return c.bits[i];
+	return is_signed && c.bits.size() ? c.bits.back() : RTLIL::State::S0;
+}
+
+static inline bool is_undef(RTLIL::State s)
 {
-	if (a == RTLIL::State::S0) return RTLIL::State::S0;
-	if (b == RTLIL::State::S0) return RTLIL::State::S0;
-	if (a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S1) return RTLIL::State::Sx;
-	return RTLIL::State::S1;
+	return s != RTLIL::State::S0 && s != RTLIL::State::S1;
 }
 
-static RTLIL::State logic_or(RTLIL::State a, RTLIL::State b)
+static bool any_bit(const RTLIL::Const &c, RTLIL::State state)
 {
-	if (a == RTLIL::State::S1) return RTLIL::State::S1;
-	if (b == RTLIL::State::S1) return RTLIL::State::S1;
-	if (a != RTLIL::State::S0) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0) return RTLIL::State::Sx;
-	return RTLIL::State::S0;
+	for (auto bit : c.bits)
+		if (bit == state)
+			return true;
+	return false;
 }
 
-static RTLIL::State logic_xor(RTLIL::State a, RTLIL::State b)
+static bool any_undef(const RTLIL::Const &c)
 {
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
+	for (auto bit : c.bits)
+		if (is_undef(bit))
+			return true;
+	return false;
+}
+
+static inline RTLIL::State logic_and(RTLIL::State a, RTLIL::State b)
+{
+	if (a == RTLIL::State::S0 || b == RTLIL::State::S0)
+		return RTLIL::State::S0;
+	if (a == RTLIL::State::S1 && b == RTLIL::State::S1)
+		return RTLIL::State::S1;
+	return RTLIL::State::Sx;
+}
+
+static inline RTLIL::State logic_or(RTLIL::State a, RTLIL::State b)
+{
+	if (a == RTLIL::State::S1 || b == RTLIL::State::S1)
+		return RTLIL::State::S1;
+	if (a == RTLIL::State::S0 && b == RTLIL::State::S0)
+		return RTLIL::State::S0;
+	return RTLIL::State::Sx;
+}
+
+static inline RTLIL::State logic_xor(RTLIL::State a, RTLIL::State b)
+{
+	if (is_undef(a) || is_undef(b))
+		return RTLIL::State::Sx;
 	return a != b ? RTLIL::State::S1 : RTLIL::State::S0;
 }
 
-static RTLIL::State logic_xnor(RTLIL::State a, RTLIL::State b)
+static inline RTLIL::State logic_xnor(RTLIL::State a, RTLIL::State b)
 {
-	if (a != RTLIL::State::S0 && a != RTLIL::State::S1) return RTLIL::State::Sx;
-	if (b != RTLIL::State::S0 && b != RTLIL::State::S1) return RTLIL::State::Sx;
+	if (is_undef(a) || is_undef(b))
+		return RTLIL::State::Sx;
 	return a == b ? RTLIL::State::S1 : RTLIL::State::S0;
 }
 
@@ -104,110 +315,111 @@ RTLIL::Const RTLIL::const_not(const RTLIL::Const &arg1, const RTLIL::Const&, boo
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
-	RTLIL::Const arg1_ext = arg1;
-	while (int(arg1_ext.bits.size()) < result_len)
-		arg1_ext.bits.push_back(signed1 && arg1_ext.bits.size() ? arg1_ext.bits.back() : RTLIL::State::S0);
-
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		if (i >= arg1_ext.bits.size())
-			result.bits[i] = RTLIL::State::S0;
-		else if (arg1_ext.bits[i] == RTLIL::State::S0)
-			result.bits[i] = RTLIL::State::S1;
-		else if (arg1_ext.bits[i] == RTLIL::State::S1)
-			result.bits[i] = RTLIL::State::S0;
+	RTLIL::Const result;
+	result.bits.resize(result_len);
+	for (int i = 0; i < result_len; i++) {
+		RTLIL::State a = ext_bit(arg1, i, signed1);
+		result.bits[i] = a == RTLIL::State::S0 ? RTLIL::State::S1 : a == RTLIL::State::S1 ? RTLIL::State::S0 : RTLIL::State::Sx;
 	}
 
 	return result;
 }
 
-static RTLIL::Const logic_wrapper(RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State),
-		RTLIL::Const arg1, RTLIL::Const arg2, bool signed1, bool signed2, int result_len = -1)
+template<RTLIL::State (*logic_func)(RTLIL::State, RTLIL::State)>
+static RTLIL::Const logic_wrapper(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
 	if (result_len < 0)
 		result_len = std::max(arg1.bits.size(), arg2.bits.size());
 
-	while (int(arg1.bits.size()) < result_len)
-		arg1.bits.push_back(signed1 && arg1.bits.size() ? arg1.bits.back() : RTLIL::State::S0);
-
-	while (int(arg2.bits.size()) < result_len)
-		arg2.bits.push_back(signed2 && arg2.bits.size() ? arg2.bits.back() : RTLIL::State::S0);
-
-	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	for (size_t i = 0; i < size_t(result_len); i++) {
-		RTLIL::State a = i < arg1.bits.size() ? arg1.bits[i] : RTLIL::State::S0;
-		RTLIL::State b = i < arg2.bits.size() ? arg2.bits[i] : RTLIL::State::S0;
-		result.bits[i] = logic_func(a, b);
-	}
+	RTLIL::Const result;
+	result.bits.resize(result_len);
+	for (int i = 0; i < result_len; i++)
+		result.bits[i] = logic_func(ext_bit(arg1, i, signed1), ext_bit(arg2, i, signed2));
 
 	return result;
 }
 
 RTLIL::Const RTLIL::const_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_and, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<logic_and>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_or, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<logic_or>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<logic_xor>(arg1, arg2, signed1, signed2, result_len);
 }
 
 RTLIL::Const RTLIL::const_xnor(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_wrapper(logic_xnor, arg1, arg2, signed1, signed2, result_len);
+	return logic_wrapper<logic_xnor>(arg1, arg2, signed1, signed2, result_len);
 }
 
-static RTLIL::Const logic_reduce_wrapper(RTLIL::State initial, RTLIL::State(*logic_func)(RTLIL::State, RTLIL::State), const RTLIL::Const &arg1)
+// returns 'dominant' if any bit is 'dominant', else Sx if any bit is undefined,
+// else 'neutral'
+static RTLIL::State reduce_bit(const RTLIL::Const &arg1, RTLIL::State dominant, RTLIL::State neutral)
 {
-	RTLIL::State temp = initial;
-
-	for (size_t i = 0; i < arg1.bits.size(); i++)
-		temp = logic_func(temp, arg1.bits[i]);
-
-	return RTLIL::Const(temp);
+	RTLIL::State result = neutral;
+	for (auto bit : arg1.bits) {
+		if (bit == dominant)
+			return dominant;
+		if (is_undef(bit))
+			result = RTLIL::State::Sx;
+	}
+	return result;
 }
 
 RTLIL::Const RTLIL::const_reduce_and(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
 {
-	return logic_reduce_wrapper(RTLIL::State::S1, logic_and, arg1);
+	return RTLIL::Const(reduce_bit(arg1, RTLIL::State::S0, RTLIL::State::S1));
 }
 
 RTLIL::Const RTLIL::const_reduce_or(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1);
+	return RTLIL::Const(reduce_bit(arg1, RTLIL::State::S1, RTLIL::State::S0));
+}
+
+// returns the parity of the one bits, or -1 if any bit is undefined
+static int const_parity(const RTLIL::Const &arg1)
+{
+	int parity = 0;
+	for (auto bit : arg1.bits) {
+		if (is_undef(bit))
+			return -1;
+		parity ^= bit == RTLIL::State::S1;
+	}
+	return parity;
 }
 
 RTLIL::Const RTLIL::const_reduce_xor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1);
+	int parity = const_parity(arg1);
+	if (parity < 0)
+		return RTLIL::Const(RTLIL::State::Sx);
+	return RTLIL::Const(parity ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_reduce_xnor(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
 {
-	RTLIL::Const not_y = logic_reduce_wrapper(RTLIL::State::S0, logic_xor, arg1);
-	if (not_y.bits.front() == RTLIL::State::S0) return RTLIL::State::S1;
-	if (not_y.bits.front() == RTLIL::State::S1) return RTLIL::State::S0;
-	return RTLIL::State::Sx;
+	int parity = const_parity(arg1);
+	if (parity < 0)
+		return RTLIL::Const(RTLIL::State::Sx);
+	return RTLIL::Const(parity ? RTLIL::State::S0 : RTLIL::State::S1);
 }
 
-RTLIL::Const RTLIL::const_reduce_bool(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
+RTLIL::Const RTLIL::const_reduce_bool(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
-	return logic_reduce_wrapper(RTLIL::State::S0, logic_or, arg1);
+	return RTLIL::const_reduce_or(arg1, arg2, signed1, signed2, result_len);
 }
 
-RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool signed1, bool, int)
+RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const&, bool, bool, int)
 {
-	int undef_bit_pos_a = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-
-	if (a.isZero()) {
-		if (undef_bit_pos_a >= 0)
+	if (!any_bit(arg1, RTLIL::State::S1)) {
+		if (any_undef(arg1))
 			return RTLIL::Const(RTLIL::State::Sx);
 		return RTLIL::Const(RTLIL::State::S1);
 	}
@@ -215,14 +427,13 @@ RTLIL::Const RTLIL::const_logic_not(const RTLIL::Const &arg1, const RTLIL::Const
 	return RTLIL::Const(RTLIL::State::S0);
 }
 
-RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
+RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
+	bool a_zero = !any_bit(arg1, RTLIL::State::S1);
+	bool b_zero = !any_bit(arg2, RTLIL::State::S1);
 
-	if (a.isZero() || b.isZero()) {
-		if (undef_bit_pos_a >= 0 && undef_bit_pos_b >= 0)
+	if (a_zero || b_zero) {
+		if (any_undef(arg1) && any_undef(arg2))
 			return RTLIL::Const(RTLIL::State::Sx);
 		return RTLIL::Const(RTLIL::State::S0);
 	}
@@ -230,14 +441,10 @@ RTLIL::Const RTLIL::const_logic_and(const RTLIL::Const &arg1, const RTLIL::Const
 	return RTLIL::Const(RTLIL::State::S1);
 }
 
-RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
+RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool, bool, int)
 {
-	int undef_bit_pos_a = -1, undef_bit_pos_b = -1;
-	BigInteger a = const2big(arg1, signed1, undef_bit_pos_a);
-	BigInteger b = const2big(arg2, signed2, undef_bit_pos_b);
-
-	if (a.isZero() && b.isZero()) {
-		if (undef_bit_pos_a >= 0 || undef_bit_pos_b >= 0)
+	if (!any_bit(arg1, RTLIL::State::S1) && !any_bit(arg2, RTLIL::State::S1)) {
+		if (any_undef(arg1) || any_undef(arg2))
 			return RTLIL::Const(RTLIL::State::Sx);
 		return RTLIL::Const(RTLIL::State::S0);
 	}
@@ -247,24 +454,28 @@ RTLIL::Const RTLIL::const_logic_or(const RTLIL::Const &arg1, const RTLIL::Const
 
 static RTLIL::Const const_shift(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool sign_ext, int direction, int result_len)
 {
-	int undef_bit_pos = -1;
-	BigInteger offset = const2big(arg2, false, undef_bit_pos) * direction;
-
 	if (result_len < 0)
 		result_len = arg1.bits.size();
 
 	RTLIL::Const result(RTLIL::State::Sx, result_len);
-	if (undef_bit_pos >= 0)
+	if (any_undef(arg2))
 		return result;
 
+	// shifting by result_len + arg1.bits.size() or more moves all bits out
+	uint64_t limit = uint64_t(result_len) + arg1.bits.size(), amount = 0;
+	for (int i = int(arg2.bits.size())-1; i >= 0 && amount < limit; i--)
+		amount = 2*amount + (arg2.bits[i] == RTLIL::State::S1);
+	int64_t offset = std::min(amount, limit) * direction;
+
+	RTLIL::State padding = sign_ext && arg1.bits.size() ? arg1.bits.back() : RTLIL::State::S0;
 	for (int i = 0; i < result_len; i++) {
-		BigInteger pos = BigInteger(i) + offset;
+		int64_t pos = i + offset;
 		if (pos < 0)
 			result.bits[i] = RTLIL::State::S0;
-		else if (pos >= arg1.bits.size())
-			result.bits[i] = sign_ext ? arg1.bits.back() : RTLIL::State::S0;
+		else if (pos >= int64_t(arg1.bits.size()))
+			result.bits[i] = padding;
 		else
-			result.bits[i] = arg1.bits[pos.toInt()];
+			result.bits[i] = arg1.bits[pos];
 	}
 
 	return result;
@@ -296,50 +507,114 @@ RTLIL::Const RTLIL::const_sshr(const RTLIL::Const &arg1, const RTLIL::Const &arg
 	return const_shift(arg1, arg2, true, +1, result_len);
 }
 
+// Packed representation of a constant for the comparisons, which then
+// compare a word at a time: bit i is set in 'val' for S1 and in 'undef' for
+// Sx, Sz, Sa and Sm. Bits beyond 'width' are zero in both planes. Constants
+// of up to 64 bits are packed without allocating memory.
+struct PackedConst
+{
+	int width, num_words;
+	uint64_t *val, *undef;
+	uint64_t inline_val, inline_undef;
+	std::vector<uint64_t> storage;
+
+	PackedConst(const RTLIL::Const &c, int width, bool is_signed) : width(width), num_words((width+63) / 64)
+	{
+		if (num_words <= 1) {
+			inline_val = 0, inline_undef = 0;
+			val = &inline_val, undef = &inline_undef;
+		} else {
+			storage.resize(2*num_words);
+			val = storage.data(), undef = storage.data() + num_words;
+		}
+
+		for (int i = 0; i < width; i++) {
+			RTLIL::State bit = ext_bit(c, i, is_signed);
+			if (bit == RTLIL::State::S1)
+				val[i / 64] |= uint64_t(1) << (i % 64);
+			else if (bit != RTLIL::State::S0)
+				undef[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+
+	PackedConst(const PackedConst&) = delete;
+	PackedConst &operator=(const PackedConst&) = delete;
+
+	bool any_undef() const {
+		for (int i = 0; i < num_words; i++)
+			if (undef[i])
+				return true;
+		return false;
+	}
+
+	// compare as two's complement numbers of the same width
+	int compare_signed(const PackedConst &other) const {
+		assert(width == other.width && width > 0);
+		uint64_t sign_bit = uint64_t(1) << ((width-1) % 64);
+		for (int i = num_words-1; i >= 0; i--) {
+			uint64_t a = val[i], b = other.val[i];
+			if (i == num_words-1)
+				a ^= sign_bit, b ^= sign_bit;
+			if (a != b)
+				return a < b ? -1 : +1;
+		}
+		return 0;
+	}
+};
+
+// returns -1, 0 or +1, or -2 if any bit is undefined
+static int const_compare(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2)
+{
+	// one extra bit so that all values are representable as signed numbers
+	int width = std::max(arg1.bits.size(), arg2.bits.size()) + 1;
+	PackedConst a(arg1, width, signed1), b(arg2, width, signed2);
+	if (a.any_undef() || b.any_undef())
+		return -2;
+	return a.compare_signed(b);
+}
+
 RTLIL::Const RTLIL::const_lt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) < const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp < 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_le(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) <= const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp <= 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_eq(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) == const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp == 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_ne(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) != const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp != 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_ge(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) >= const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp >= 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_gt(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int)
 {
-	int undef_bit_pos = -1;
-	bool y = const2big(arg1, signed1, undef_bit_pos) > const2big(arg2, signed2, undef_bit_pos);
-	return RTLIL::Const(undef_bit_pos >= 0 ? RTLIL::State::Sx : y ? RTLIL::State::S1 : RTLIL::State::S0);
+	int cmp = const_compare(arg1, arg2, signed1, signed2);
+	return RTLIL::Const(cmp == -2 ? RTLIL::State::Sx : cmp > 0 ? RTLIL::State::S1 : RTLIL::State::S0);
 }
 
 RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_ADD, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) + const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : std::max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
@@ -347,6 +622,10 @@ RTLIL::Const RTLIL::const_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_SUB, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) - const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : std::max(arg1.bits.size(), arg2.bits.size()), undef_bit_pos);
@@ -354,6 +633,10 @@ RTLIL::Const RTLIL::const_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_MUL, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger y = const2big(arg1, signed1, undef_bit_pos) * const2big(arg2, signed2, undef_bit_pos);
 	return big2const(y, result_len >= 0 ? result_len : std::max(arg1.bits.size(), arg2.bits.size()), std::min(undef_bit_pos, 0));
@@ -361,6 +644,10 @@ RTLIL::Const RTLIL::const_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_DIV, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -374,6 +661,10 @@ RTLIL::Const RTLIL::const_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_MOD, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
 	BigInteger b = const2big(arg2, signed2, undef_bit_pos);
@@ -387,6 +678,10 @@ RTLIL::Const RTLIL::const_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2
 
 RTLIL::Const RTLIL::const_pow(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 {
+	RTLIL::Const result;
+	if (native_arith(NATIVE_POW, arg1, arg2, signed1, signed2, result_len, result))
+		return result;
+
 	int undef_bit_pos = -1;
 
 	BigInteger a = const2big(arg1, signed1, undef_bit_pos);
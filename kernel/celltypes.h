@@ -20,16 +20,149 @@
 #ifndef CELLTYPES_H
 #define CELLTYPES_H
 
-#include <set>
+#include <bitset>
 #include <string>
 #include <stdlib.h>
 
 #include <kernel/rtlil.h>
 #include <kernel/log.h>
 
+// The table of built-in cell types with their category, their output port
+// and the const_* function that evaluates them (if any). All other ports of
+// the built-in cell types are inputs.
+//
+// The names of the cell types and of the output ports are the first entries
+// of the IdString pool, in the order of this table (see IdString::get_index()),
+// so the CellTypeId of a cell type is just the index of its IdString and
+// looking up a type or comparing a port name costs no string operations.
+//
+// X(name without '$', category, output port, evaluation function)
+#define CELLTYPE_TABLE(X) \
+	X(not,          INTERNAL,     Y,        RTLIL::const_not) \
+	X(pos,          INTERNAL,     Y,        RTLIL::const_pos) \
+	X(neg,          INTERNAL,     Y,        RTLIL::const_neg) \
+	X(and,          INTERNAL,     Y,        RTLIL::const_and) \
+	X(or,           INTERNAL,     Y,        RTLIL::const_or) \
+	X(xor,          INTERNAL,     Y,        RTLIL::const_xor) \
+	X(xnor,         INTERNAL,     Y,        RTLIL::const_xnor) \
+	X(reduce_and,   INTERNAL,     Y,        RTLIL::const_reduce_and) \
+	X(reduce_or,    INTERNAL,     Y,        RTLIL::const_reduce_or) \
+	X(reduce_xor,   INTERNAL,     Y,        RTLIL::const_reduce_xor) \
+	X(reduce_xnor,  INTERNAL,     Y,        RTLIL::const_reduce_xnor) \
+	X(reduce_bool,  INTERNAL,     Y,        RTLIL::const_reduce_bool) \
+	X(shl,          INTERNAL,     Y,        RTLIL::const_shl) \
+	X(shr,          INTERNAL,     Y,        RTLIL::const_shr) \
+	X(sshl,         INTERNAL,     Y,        RTLIL::const_sshl) \
+	X(sshr,         INTERNAL,     Y,        RTLIL::const_sshr) \
+	X(lt,           INTERNAL,     Y,        RTLIL::const_lt) \
+	X(le,           INTERNAL,     Y,        RTLIL::const_le) \
+	X(eq,           INTERNAL,     Y,        RTLIL::const_eq) \
+	X(ne,           INTERNAL,     Y,        RTLIL::const_ne) \
+	X(ge,           INTERNAL,     Y,        RTLIL::const_ge) \
+	X(gt,           INTERNAL,     Y,        RTLIL::const_gt) \
+	X(add,          INTERNAL,     Y,        RTLIL::const_add) \
+	X(sub,          INTERNAL,     Y,        RTLIL::const_sub) \
+	X(mul,          INTERNAL,     Y,        RTLIL::const_mul) \
+	X(div,          INTERNAL,     Y,        RTLIL::const_div) \
+	X(mod,          INTERNAL,     Y,        RTLIL::const_mod) \
+	X(pow,          INTERNAL,     Y,        RTLIL::const_pow) \
+	X(logic_not,    INTERNAL,     Y,        RTLIL::const_logic_not) \
+	X(logic_and,    INTERNAL,     Y,        RTLIL::const_logic_and) \
+	X(logic_or,     INTERNAL,     Y,        RTLIL::const_logic_or) \
+	X(mux,          INTERNAL,     Y,        NULL) \
+	X(pmux,         INTERNAL,     Y,        NULL) \
+	X(safe_pmux,    INTERNAL,     Y,        NULL) \
+	X(lut,          INTERNAL,     O,        NULL) \
+	X(sr,           INTERNAL_MEM, Q,        NULL) \
+	X(dff,          INTERNAL_MEM, Q,        NULL) \
+	X(dffsr,        INTERNAL_MEM, Q,        NULL) \
+	X(adff,         INTERNAL_MEM, Q,        NULL) \
+	X(dlatch,       INTERNAL_MEM, Q,        NULL) \
+	X(memrd,        INTERNAL_MEM, DATA,     NULL) \
+	X(memwr,        INTERNAL_MEM, NONE,     NULL) \
+	X(mem,          INTERNAL_MEM, RD_DATA,  NULL) \
+	X(fsm,          INTERNAL_MEM, CTRL_OUT, NULL) \
+	X(_INV_,        STDCELL,      Y,        RTLIL::const_not) \
+	X(_AND_,        STDCELL,      Y,        RTLIL::const_and) \
+	X(_OR_,         STDCELL,      Y,        RTLIL::const_or) \
+	X(_XOR_,        STDCELL,      Y,        RTLIL::const_xor) \
+	X(_MUX_,        STDCELL,      Y,        NULL) \
+	X(_SR_NN_,      STDCELL_MEM,  Q,        NULL) \
+	X(_SR_NP_,      STDCELL_MEM,  Q,        NULL) \
+	X(_SR_PN_,      STDCELL_MEM,  Q,        NULL) \
+	X(_SR_PP_,      STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_N_,      STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_P_,      STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_NN0_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_NN1_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_NP0_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_NP1_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_PN0_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_PN1_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_PP0_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFF_PP1_,    STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_NNN_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_NNP_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_NPN_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_NPP_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_PNN_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_PNP_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_PPN_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DFFSR_PPP_,  STDCELL_MEM,  Q,        NULL) \
+	X(_DLATCH_N_,   STDCELL_MEM,  Q,        NULL) \
+	X(_DLATCH_P_,   STDCELL_MEM,  Q,        NULL)
+
+#define CELLTYPE_OUTPUT_PORTS(X) \
+	X(Y) X(Q) X(O) X(RD_DATA) X(DATA) X(CTRL_OUT)
+
+enum CellTypeId {
+	CT_UNKNOWN = 0,
+#define X(_name, _category, _port, _func) CT_ ## _name,
+	CELLTYPE_TABLE(X)
+#undef X
+	CT_NUM
+};
+
+// CP_NONE is the index of the empty IdString, which is never a port name
+enum CellPortId {
+	CP_NONE = 0,
+	CP_FIRST = CT_NUM - 1,
+#define X(_port) CP_ ## _port,
+	CELLTYPE_OUTPUT_PORTS(X)
+#undef X
+	CP_END
+};
+
+enum CellTypeCategory {
+	CTC_NONE, CTC_INTERNAL, CTC_INTERNAL_MEM, CTC_STDCELL, CTC_STDCELL_MEM
+};
+
+struct CellTypeInfo
+{
+	typedef RTLIL::Const (*eval_func_t)(const RTLIL::Const&, const RTLIL::Const&, bool, bool, int);
+
+	const char *name;
+	CellTypeCategory category;
+	CellPortId output_port;
+	eval_func_t eval_func;
+};
+
+// indexed by CellTypeId, the entry for CT_UNKNOWN has no name and no category
+extern const CellTypeInfo cell_type_table[CT_NUM];
+
+static inline CellTypeId cell_type_id(const RTLIL::IdString &type)
+{
+	return type.index_ < CT_NUM ? CellTypeId(type.index_) : CT_UNKNOWN;
+}
+
+static inline const CellTypeInfo &cell_type_info(const RTLIL::IdString &type)
+{
+	return cell_type_table[cell_type_id(type)];
+}
+
 struct CellTypes
 {
-	std::set<std::string> cell_types;
+	std::bitset<CT_NUM> cell_types;
 	std::vector<const RTLIL::Design*> designs;
 
 	CellTypes()
@@ -56,104 +189,42 @@ struct CellTypes
 		designs.push_back(design);
 	}
 
+	void setup_category(CellTypeCategory category)
+	{
+		for (int i = 0; i < CT_NUM; i++)
+			if (cell_type_table[i].category == category)
+				cell_types.set(i);
+	}
+
 	void setup_internals()
 	{
-		cell_types.insert("$not");
-		cell_types.insert("$pos");
-		cell_types.insert("$neg");
-		cell_types.insert("$and");
-		cell_types.insert("$or");
-		cell_types.insert("$xor");
-		cell_types.insert("$xnor");
-		cell_types.insert("$reduce_and");
-		cell_types.insert("$reduce_or");
-		cell_types.insert("$reduce_xor");
-		cell_types.insert("$reduce_xnor");
-		cell_types.insert("$reduce_bool");
-		cell_types.insert("$shl");
-		cell_types.insert("$shr");
-		cell_types.insert("$sshl");
-		cell_types.insert("$sshr");
-		cell_types.insert("$lt");
-		cell_types.insert("$le");
-		cell_types.insert("$eq");
-		cell_types.insert("$ne");
-		cell_types.insert("$ge");
-		cell_types.insert("$gt");
-		cell_types.insert("$add");
-		cell_types.insert("$sub");
-		cell_types.insert("$mul");
-		cell_types.insert("$div");
-		cell_types.insert("$mod");
-		cell_types.insert("$pow");
-		cell_types.insert("$logic_not");
-		cell_types.insert("$logic_and");
-		cell_types.insert("$logic_or");
-		cell_types.insert("$mux");
-		cell_types.insert("$pmux");
-		cell_types.insert("$safe_pmux");
-		cell_types.insert("$lut");
+		setup_category(CTC_INTERNAL);
 	}
 
 	void setup_internals_mem()
 	{
-		cell_types.insert("$sr");
-		cell_types.insert("$dff");
-		cell_types.insert("$dffsr");
-		cell_types.insert("$adff");
-		cell_types.insert("$dlatch");
-		cell_types.insert("$memrd");
-		cell_types.insert("$memwr");
-		cell_types.insert("$mem");
-		cell_types.insert("$fsm");
+		setup_category(CTC_INTERNAL_MEM);
 	}
 
 	void setup_stdcells()
 	{
-		cell_types.insert("$_INV_");
-		cell_types.insert("$_AND_");
-		cell_types.insert("$_OR_");
-		cell_types.insert("$_XOR_");
-		cell_types.insert("$_MUX_");
+		setup_category(CTC_STDCELL);
 	}
 
 	void setup_stdcells_mem()
 	{
-		cell_types.insert("$_SR_NN_");
-		cell_types.insert("$_SR_NP_");
-		cell_types.insert("$_SR_PN_");
-		cell_types.insert("$_SR_PP_");
-		cell_types.insert("$_DFF_N_");
-		cell_types.insert("$_DFF_P_");
-		cell_types.insert("$_DFF_NN0_");
-		cell_types.insert("$_DFF_NN1_");
-		cell_types.insert("$_DFF_NP0_");
-		cell_types.insert("$_DFF_NP1_");
-		cell_types.insert("$_DFF_PN0_");
-		cell_types.insert("$_DFF_PN1_");
-		cell_types.insert("$_DFF_PP0_");
-		cell_types.insert("$_DFF_PP1_");
-		cell_types.insert("$_DFFSR_NNN_");
-		cell_types.insert("$_DFFSR_NNP_");
-		cell_types.insert("$_DFFSR_NPN_");
-		cell_types.insert("$_DFFSR_NPP_");
-		cell_types.insert("$_DFFSR_PNN_");
-		cell_types.insert("$_DFFSR_PNP_");
-		cell_types.insert("$_DFFSR_PPN_");
-		cell_types.insert("$_DFFSR_PPP_");
-		cell_types.insert("$_DLATCH_N_");
-		cell_types.insert("$_DLATCH_P_");
+		setup_category(CTC_STDCELL_MEM);
 	}
 
 	void clear()
 	{
-		cell_types.clear();
+		cell_types.reset();
 		designs.clear();
 	}
 
-	bool cell_known(std::string type)
+	bool cell_known(const RTLIL::IdString &type) const
 	{
-		if (cell_types.count(type) > 0)
+		if (cell_types[cell_type_id(type)])
 			return true;
 		for (auto design : designs)
 			if (design->modules.count(type) > 0)
@@ -161,9 +232,10 @@ struct CellTypes
 		return false;
 	}
 
-	bool cell_output(std::string type, std::string port)
+	bool cell_output(const RTLIL::IdString &type, const RTLIL::IdString &port) const
 	{
-		if (cell_types.count(type) == 0) {
+		CellTypeId id = cell_type_id(type);
+		if (!cell_types[id]) {
 			for (auto design : designs)
 				if (design->modules.count(type) > 0) {
 					if (design->modules.at(type)->wires.count(port))
@@ -172,21 +244,13 @@ struct CellTypes
 				}
 			return false;
 		}
-
-		if (port == "\\Y" || port == "\\Q" || port == "\\RD_DATA")
-			return true;
-		if (type == "$memrd" && port == "\\DATA")
-			return true;
-		if (type == "$fsm" && port == "\\CTRL_OUT")
-			return true;
-		if (type == "$lut" && port == "\\O")
-			return true;
-		return false;
+		return port.index_ == cell_type_table[id].output_port;
 	}
 
-	bool cell_input(std::string type, std::string port)
+	bool cell_input(const RTLIL::IdString &type, const RTLIL::IdString &port) const
 	{
-		if (cell_types.count(type) == 0) {
+		CellTypeId id = cell_type_id(type);
+		if (!cell_types[id]) {
 			for (auto design : designs)
 				if (design->modules.count(type) > 0) {
 					if (design->modules.at(type)->wires.count(port))
@@ -195,70 +259,44 @@ struct CellTypes
 				}
 			return false;
 		}
-
-		if (cell_types.count(type) > 0)
-			return !cell_output(type, port);
-
-		return false;
+		return port.index_ != cell_type_table[id].output_port;
 	}
 
-	static RTLIL::Const eval(std::string type, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+	static RTLIL::Const eval(const RTLIL::IdString &type, const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
 	{
-		if (type == "$sshr" && !signed1)
-			type = "$shr";
-		if (type == "$sshl" && !signed1)
-			type = "$shl";
+		CellTypeId id = cell_type_id(type);
 
-		if (type != "$sshr" && type != "$sshl" && type != "$shr" && type != "$shl" &&
-				type != "$pos" && type != "$neg" && type != "$not") {
+		switch (id)
+		{
+		case CT_sshr:
+			if (!signed1)
+				id = CT_shr;
+			break;
+		case CT_sshl:
+			if (!signed1)
+				id = CT_shl;
+			break;
+		case CT_shr:
+		case CT_shl:
+		case CT_pos:
+		case CT_neg:
+		case CT_not:
+			break;
+		case CT__INV_:
+		case CT__AND_:
+		case CT__OR_:
+		case CT__XOR_:
+			signed1 = false, signed2 = false, result_len = 1;
+			break;
+		default:
 			if (!signed1 || !signed2)
 				signed1 = false, signed2 = false;
+			break;
 		}
 
-#define HANDLE_CELL_TYPE(_t) if (type == "$" #_t) return const_ ## _t(arg1, arg2, signed1, signed2, result_len);
-		HANDLE_CELL_TYPE(not)
-		HANDLE_CELL_TYPE(and)
-		HANDLE_CELL_TYPE(or)
-		HANDLE_CELL_TYPE(xor)
-		HANDLE_CELL_TYPE(xnor)
-		HANDLE_CELL_TYPE(reduce_and)
-		HANDLE_CELL_TYPE(reduce_or)
-		HANDLE_CELL_TYPE(reduce_xor)
-		HANDLE_CELL_TYPE(reduce_xnor)
-		HANDLE_CELL_TYPE(reduce_bool)
-		HANDLE_CELL_TYPE(logic_not)
-		HANDLE_CELL_TYPE(logic_and)
-		HANDLE_CELL_TYPE(logic_or)
-		HANDLE_CELL_TYPE(shl)
-		HANDLE_CELL_TYPE(shr)
-		HANDLE_CELL_TYPE(sshl)
-		HANDLE_CELL_TYPE(sshr)
-		HANDLE_CELL_TYPE(lt)
-		HANDLE_CELL_TYPE(le)
-		HANDLE_CELL_TYPE(eq)
-		HANDLE_CELL_TYPE(ne)
-		HANDLE_CELL_TYPE(ge)
-		HANDLE_CELL_TYPE(gt)
-		HANDLE_CELL_TYPE(add)
-		HANDLE_CELL_TYPE(sub)
-		HANDLE_CELL_TYPE(mul)
-		HANDLE_CELL_TYPE(div)
-		HANDLE_CELL_TYPE(mod)
-		HANDLE_CELL_TYPE(pow)
-		HANDLE_CELL_TYPE(pos)
-		HANDLE_CELL_TYPE(neg)
-#undef HANDLE_CELL_TYPE
-
-		if (type == "$_INV_")
-			return const_not(arg1, arg2, false, false, 1);
-		if (type == "$_AND_")
-			return const_and(arg1, arg2, false, false, 1);
-		if (type == "$_OR_")
-			return const_or(arg1, arg2, false, false, 1);
-		if (type == "$_XOR_")
-			return const_xor(arg1, arg2, false, false, 1);
-
-		log_abort();
+		if (cell_type_table[id].eval_func == NULL)
+			log_abort();
+		return cell_type_table[id].eval_func(arg1, arg2, signed1, signed2, result_len);
 	}
 
 	static RTLIL::Const eval(RTLIL::Cell *cell, const RTLIL::Const &arg1, const RTLIL::Const &arg2)
@@ -271,7 +309,8 @@ struct CellTypes
 
 	static RTLIL::Const eval(RTLIL::Cell *cell, const RTLIL::Const &arg1, const RTLIL::Const &arg2, const RTLIL::Const &sel)
 	{
-		if (cell->type == "$mux" || cell->type == "$pmux" || cell->type == "$safe_pmux" || cell->type == "$_MUX_") {
+		CellTypeId id = cell_type_id(cell->type);
+		if (id == CT_mux || id == CT_pmux || id == CT_safe_pmux || id == CT__MUX_) {
 			RTLIL::Const ret = arg1;
 			for (size_t i = 0; i < sel.bits.size(); i++)
 				if (sel.bits[i] == RTLIL::State::S1) {
@@ -290,4 +329,3 @@ struct CellTypes
 };
 
 #endif
-
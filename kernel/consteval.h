@@ -29,12 +29,13 @@ struct ConstEval
 	RTLIL::Module *module;
 	SigMap assign_map;
 	SigMap values_map;
-	SigPool stop_signals;
-	SigSet<RTLIL::Cell*> sig2driver;
+	SigBitIndex bit_index;
+	DenseSigPool stop_signals;
+	DenseSigSet<RTLIL::Cell*> sig2driver;
 	std::set<RTLIL::Cell*> busy;
 	std::vector<SigMap> stack;
 
-	ConstEval(RTLIL::Module *module) : module(module), assign_map(module)
+	ConstEval(RTLIL::Module *module) : module(module), assign_map(module), bit_index(module), stop_signals(&bit_index), sig2driver(&bit_index)
 	{
 		CellTypes ct;
 		ct.setup_internals();
@@ -97,13 +98,16 @@ struct ConstEval
 		if (sig_y.is_fully_const())
 			return true;
 
+		CellTypeId type = cell_type_id(cell->type);
+		bool is_mux = type == CT_mux || type == CT_pmux || type == CT_safe_pmux || type == CT__MUX_;
+
 		if (cell->connections.count("\\S") > 0) {
 			sig_s = cell->connections["\\S"];
 			if (!eval(sig_s, undef, cell))
 				return false;
 		}
 
-		if (cell->type == "$mux" || cell->type == "$pmux" || cell->type == "$safe_pmux" || cell->type == "$_MUX_") {
+		if (is_mux) {
 			bool found_collision = false;
 			for (int i = 0; i < sig_s.width; i++)
 				if (sig_s.extract(i, 1).as_bool()) {
@@ -111,7 +115,7 @@ struct ConstEval
 						found_collision = true;
 					sig_b_shift = i;
 					ignore_sig_a = true;
-					if (cell->type != "$safe_pmux")
+					if (type != CT_safe_pmux)
 						break;
 				}
 			if (found_collision) {
@@ -136,7 +140,7 @@ struct ConstEval
 				return false;
 		}
 
-		if (cell->type == "$mux" || cell->type == "$pmux" || cell->type == "$safe_pmux" || cell->type == "$_MUX_")
+		if (is_mux)
 			set(sig_y, sig_s.as_bool() ? sig_b.as_const() : sig_a.as_const());
 		else
 			set(sig_y, CellTypes::eval(cell, sig_a.as_const(), sig_b.as_const()));
@@ -30,6 +30,7 @@
 #include "kernel/rtlil.h"
 #include "kernel/register.h"
 #include "kernel/log.h"
+#include "kernel/threadpool.h"
 
 // from kernel/version_*.o (cc source generated from Makefile)
 extern const char *yosys_version_str;
@@ -165,7 +166,7 @@ static char *readline_obj_generator(const char *text, int state)
 		{
 			for (auto &it : design->modules)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
-					obj_names.push_back(strdup(RTLIL::id2cstr(it.first.c_str())));
+					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 		}
 		else
 		if (design->modules.count(design->selected_active_module) > 0)
@@ -174,19 +175,19 @@ static char *readline_obj_generator(const char *text, int state)
 
 			for (auto &it : module->wires)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
-					obj_names.push_back(strdup(RTLIL::id2cstr(it.first.c_str())));
+					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 
 			for (auto &it : module->memories)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
-					obj_names.push_back(strdup(RTLIL::id2cstr(it.first.c_str())));
+					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 
 			for (auto &it : module->cells)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
-					obj_names.push_back(strdup(RTLIL::id2cstr(it.first.c_str())));
+					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 
 			for (auto &it : module->processes)
 				if (RTLIL::unescape_id(it.first).substr(0, len) == text)
-					obj_names.push_back(strdup(RTLIL::id2cstr(it.first.c_str())));
+					obj_names.push_back(strdup(RTLIL::id2cstr(it.first)));
 		}
 
 		std::sort(obj_names.begin(), obj_names.end());
@@ -241,6 +242,7 @@ static void shell(RTLIL::Design *design)
 	rl_basic_word_break_characters = " \t\n";
 
 	char *command = NULL;
+	log_flush();
 	while ((command = readline(create_prompt(design, recursion_counter))) != NULL)
 	{
 		if (command[strspn(command, " \t\r\n")] == 0)
@@ -263,6 +265,7 @@ static void shell(RTLIL::Design *design)
 				design->selection_stack.pop_back();
 			log_reset_stack();
 		}
+		log_flush();
 	}
 	if (command == NULL)
 		printf("exit\n");
@@ -272,7 +275,7 @@ static void shell(RTLIL::Design *design)
 }
 
 struct ShellPass : public Pass {
-	ShellPass() : Pass("shell", "enter interactive command mode") { }
+	ShellPass() : Pass("shell", "enter interactive command mode") { modifies_design = false; }
 	virtual void help() {
 		log("\n");
 		log("    shell\n");
@@ -312,7 +315,7 @@ struct ShellPass : public Pass {
 } ShellPass;
 
 struct ScriptPass : public Pass {
-	ScriptPass() : Pass("script", "execute commands from script file") { }
+	ScriptPass() : Pass("script", "execute commands from script file") { modifies_design = false; }
 	virtual void help() {
 		log("\n");
 		log("    script <filename>\n");
@@ -373,7 +376,7 @@ extern Tcl_Interp *yosys_get_tcl_interp()
 }
 
 struct TclPass : public Pass {
-	TclPass() : Pass("tcl", "execute a TCL script file") { }
+	TclPass() : Pass("tcl", "execute a TCL script file") { modifies_design = false; }
 	virtual void help() {
 		log("\n");
 		log("    tcl <filename>\n");
@@ -453,6 +456,8 @@ int main(int argc, char **argv)
 	std::string scriptfile = "";
 	bool scriptfile_tcl = false;
 	bool got_output_filename = false;
+	std::string profile_filename;
+	std::string trace_filename;
 
 	int history_offset = 0;
 	std::string history_file;
@@ -463,7 +468,7 @@ int main(int argc, char **argv)
 	}
 
 	int opt;
-	while ((opt = getopt(argc, argv, "VSm:f:b:o:p:l:qts:c:")) != -1)
+	while ((opt = getopt(argc, argv, "VSm:f:b:o:p:l:qdts:c:j:P:T:")) != -1)
 	{
 		switch (opt)
 		{
@@ -509,6 +514,9 @@ int main(int argc, char **argv)
 		case 'q':
 			log_errfile = stderr;
 			break;
+		case 'd':
+			log_level = LOG_LEVEL_DEBUG;
+			break;
 		case 't':
 			log_time = true;
 			break;
@@ -520,17 +528,45 @@ int main(int argc, char **argv)
 			scriptfile = optarg;
 			scriptfile_tcl = true;
 			break;
+		case 'T':
+			trace_filename = optarg;
+			break;
+		case 'P':
+			profile_filename = optarg;
+			break;
+		case 'j':
+			ThreadPool::num_threads = atoi(optarg);
+			if (ThreadPool::num_threads < 1) {
+				fprintf(stderr, "Invalid number of threads `%s'!\n", optarg);
+				exit(1);
+			}
+			break;
 		default:
 			fprintf(stderr, "\n");
-			fprintf(stderr, "Usage: %s [-V] [-S] [-q] [-t] [-l logfile] [-o <outfile>] [-f <frontend>] [{-s|-c} <scriptfile>]\n", argv[0]);
+			fprintf(stderr, "Usage: %s [-V] [-S] [-q] [-d] [-t] [-j <threads>] [-P <profile_file>] [-T <trace_file>] [-l logfile] [-o <outfile>] [-f <frontend>] [{-s|-c} <scriptfile>]\n", argv[0]);
 			fprintf(stderr, "       %*s[-p <pass> [-p ..]] [-b <backend>] [-m <module_file>] [<infile> [..]]\n", int(strlen(argv[0])+1), "");
 			fprintf(stderr, "\n");
 			fprintf(stderr, "    -q\n");
 			fprintf(stderr, "        quiet operation. only write error messages to console\n");
 			fprintf(stderr, "\n");
+			fprintf(stderr, "    -d\n");
+			fprintf(stderr, "        also log debug messages, such as one line per removed or mapped cell\n");
+			fprintf(stderr, "\n");
 			fprintf(stderr, "    -t\n");
 			fprintf(stderr, "        annotate all log messages with a time stamp\n");
 			fprintf(stderr, "\n");
+			fprintf(stderr, "    -j threads\n");
+			fprintf(stderr, "        use up to the specified number of threads for passes that can process\n");
+			fprintf(stderr, "        modules in parallel (default: 1)\n");
+			fprintf(stderr, "\n");
+			fprintf(stderr, "    -P profile_file\n");
+			fprintf(stderr, "        write the time and memory spent per command as JSON to the specified\n");
+			fprintf(stderr, "        file on exit (a summary table is always printed to the log)\n");
+			fprintf(stderr, "\n");
+			fprintf(stderr, "    -T trace_file\n");
+			fprintf(stderr, "        write a timeline of all commands (and of the modules processed by\n");
+			fprintf(stderr, "        each command) to the specified file in Chrome trace-event format\n");
+			fprintf(stderr, "\n");
 			fprintf(stderr, "    -l logfile\n");
 			fprintf(stderr, "        write log messages to the specified file\n");
 			fprintf(stderr, "\n");
@@ -579,6 +615,8 @@ int main(int argc, char **argv)
 	if (log_errfile == NULL)
 		log_files.push_back(stderr);
 
+	log_install_crash_handlers();
+
 	log("\n");
 	log(" /-----------------------------------------------------------------------------\\\n");
 	log(" |                                                                             |\n");
@@ -605,6 +643,9 @@ int main(int argc, char **argv)
 
 	Pass::init_register();
 
+	if (!trace_filename.empty())
+		Pass::trace_open(trace_filename);
+
 	yosys_design = new RTLIL::Design;
 	yosys_design->selection_stack.push_back(RTLIL::Selection());
 	log_push();
@@ -639,6 +680,16 @@ int main(int argc, char **argv)
 	delete yosys_design;
 	yosys_design = NULL;
 
+	Pass::trace_close();
+	Pass::log_profile();
+	if (!profile_filename.empty()) {
+		FILE *f = fopen(profile_filename.c_str(), "w");
+		if (f == NULL)
+			log_error("Can't open profile file `%s' for writing: %s\n", profile_filename.c_str(), strerror(errno));
+		Pass::write_profile_json(f);
+		fclose(f);
+	}
+
 	log("\nREADY.\n");
 	log_pop();
 
@@ -0,0 +1,868 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Hash-indexed containers with deterministic iteration order.
+ *
+ *  dict<K, T> stores its elements by value in insertion order in a vector
+ *  and uses an open addressing hash table (linear probing, backward shift
+ *  deletion) of indices into that vector for lookups. Iterating over a dict
+ *  therefore visits the elements in the order they were inserted, independent
+ *  of the hash function and of pointer values.
+ *
+ *  Unlike with std::map, inserting an element invalidates all references and
+ *  pointers to elements of the dict (the vector may be reallocated). Erasing
+ *  an element does not invalidate references to other elements or iterators.
+ *  Erasing leaves an empty slot in the element vector. Inserts reuse the empty
+ *  slots at the end of the vector, and when more than half of the slots are
+ *  empty an insert removes the empty slots (keeping the order) and rebuilds
+ *  the hash table. Iterators stay valid on insert, and elements inserted
+ *  while iterating over a dict are visited by the running iteration, unless
+ *  the insert removes empty slots. So inserting while iterating is only
+ *  supported when no elements were erased before.
+ *
+ *  flat_dict<K, T, N> has the same interface and the same guarantees as dict
+ *  but is meant for the small containers every cell has (ports, parameters).
+ *  The first N elements are stored inside the container object itself and
+ *  lookups are a linear search over the elements, so a small flat_dict does
+ *  not allocate any memory. Elements beyond the first N are allocated one by
+ *  one, and a hash index is built once the container grows larger than a few
+ *  dozen elements (e.g. the ports of a big instance). Unlike with dict, moving
+ *  or swapping a flat_dict moves the inline elements to a new address.
+ *
+ *  A flat_dict reclaims erased slots on insert, so erasing and re-inserting
+ *  ports does not grow it: erased elements at the end are dropped (freeing
+ *  their inline slots for the next inserts), and when more than half of the
+ *  slots are erased the overflow elements are compacted. The compaction keeps
+ *  the order and the addresses of the elements, but it invalidates iterators,
+ *  so unlike with dict, inserting elements while iterating over a large
+ *  flat_dict with many erased elements is not supported.
+ *
+ */
+
+#ifndef HASHLIB_H
+#define HASHLIB_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <stdexcept>
+#include <new>
+#include <stdint.h>
+
+namespace hashlib
+{
+	static inline unsigned int mkhash(unsigned int a, unsigned int b) {
+		return ((a << 5) + a) ^ b;
+	}
+
+	// hash_ops<T> provides the hash function and the equality check used by
+	// the containers in this file. The default implementation uses T::hash().
+	template<typename T> struct hash_ops {
+		static bool cmp(const T &a, const T &b) {
+			return a == b;
+		}
+		static unsigned int hash(const T &a) {
+			return a.hash();
+		}
+	};
+
+	template<> struct hash_ops<int> {
+		static bool cmp(int a, int b) {
+			return a == b;
+		}
+		static unsigned int hash(int a) {
+			return a;
+		}
+	};
+
+	template<> struct hash_ops<std::string> {
+		static bool cmp(const std::string &a, const std::string &b) {
+			return a == b;
+		}
+		static unsigned int hash(const std::string &a) {
+			unsigned int v = 5381;
+			for (auto c : a)
+				v = mkhash(v, c);
+			return v;
+		}
+	};
+
+	template<typename T> struct hash_ops<T*> {
+		static bool cmp(const T *a, const T *b) {
+			return a == b;
+		}
+		static unsigned int hash(const T *a) {
+			uintptr_t v = uintptr_t(a);
+			return (unsigned int)(v >> 4) ^ (unsigned int)(v >> 32 >> 4);
+		}
+	};
+
+	template<typename P, typename Q> struct hash_ops<std::pair<P, Q>> {
+		static bool cmp(const std::pair<P, Q> &a, const std::pair<P, Q> &b) {
+			return a == b;
+		}
+		static unsigned int hash(const std::pair<P, Q> &a) {
+			return mkhash(hash_ops<P>::hash(a.first), hash_ops<Q>::hash(a.second));
+		}
+	};
+
+	template<typename K, typename T, typename OPS = hash_ops<K>>
+	class dict
+	{
+		// erased elements are reset to default values to free their memory
+		struct entry_t {
+			std::pair<K, T> udata;
+			bool live;
+			entry_t(const std::pair<K, T> &udata) : udata(udata), live(true) { }
+		};
+
+		std::vector<int> hashtable;
+		std::vector<entry_t> entries;
+		int num_deleted;
+
+		int hash_slot(const K &key) const
+		{
+			return OPS::hash(key) & (hashtable.size() - 1);
+		}
+
+		void do_rehash()
+		{
+			size_t new_size = 16;
+			while (new_size < 2 * (entries.size() - num_deleted))
+				new_size *= 2;
+			hashtable.assign(new_size, -1);
+
+			for (int i = 0; i < int(entries.size()); i++) {
+				if (!entries[i].live)
+					continue;
+				int slot = hash_slot(entries[i].udata.first);
+				while (hashtable[slot] >= 0)
+					slot = (slot + 1) & (hashtable.size() - 1);
+				hashtable[slot] = i;
+			}
+		}
+
+		// returns the entry index for key (or -1) and sets slot to the hash
+		// table slot holding that index (or the empty slot ending the probe)
+		int do_lookup(const K &key, int &slot) const
+		{
+			if (hashtable.empty()) {
+				slot = -1;
+				return -1;
+			}
+
+			slot = hash_slot(key);
+			while (hashtable[slot] >= 0) {
+				int index = hashtable[slot];
+				if (OPS::cmp(entries[index].udata.first, key))
+					return index;
+				slot = (slot + 1) & (hashtable.size() - 1);
+			}
+			return -1;
+		}
+
+		// drops the erased elements at the end, and removes all erased
+		// elements when they are more than half of the vector. returns false
+		// if the element indices have changed.
+		bool do_reclaim()
+		{
+			while (!entries.empty() && !entries.back().live) {
+				entries.pop_back();
+				num_deleted--;
+			}
+			if (num_deleted <= 8 || 2 * num_deleted <= int(entries.size()))
+				return true;
+
+			int new_size = 0;
+			for (int i = 0; i < int(entries.size()); i++)
+				if (entries[i].live) {
+					if (i != new_size)
+						entries[new_size] = std::move(entries[i]);
+					new_size++;
+				}
+			entries.erase(entries.begin() + new_size, entries.end());
+			num_deleted = 0;
+			return false;
+		}
+
+		int do_insert(const std::pair<K, T> &value, int slot)
+		{
+			if (num_deleted > 0 && !do_reclaim())
+				slot = -1;
+			entries.push_back(entry_t(value));
+			if (slot < 0 || 2 * (entries.size() - num_deleted) > hashtable.size())
+				do_rehash();
+			else
+				hashtable[slot] = entries.size() - 1;
+			return entries.size() - 1;
+		}
+
+		void do_erase(int index, int slot)
+		{
+			int mask = hashtable.size() - 1;
+			int i = slot, j = slot;
+			while (1) {
+				j = (j + 1) & mask;
+				if (hashtable[j] < 0)
+					break;
+				int k = hash_slot(entries[hashtable[j]].udata.first);
+				if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+					continue;
+				hashtable[i] = hashtable[j];
+				i = j;
+			}
+			hashtable[i] = -1;
+
+			entries[index].udata = std::pair<K, T>();
+			entries[index].live = false;
+			num_deleted++;
+		}
+
+	public:
+		typedef K key_type;
+		typedef T mapped_type;
+		typedef std::pair<K, T> value_type;
+
+		class const_iterator;
+
+		// an iterator is an index into the element vector, with -1 for end()
+		class iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
+		{
+			friend class dict;
+			friend class const_iterator;
+		protected:
+			dict *ptr;
+			int index;
+			iterator(dict *ptr, int index) : ptr(ptr), index(index) { skip(); }
+			void skip() {
+				while (index >= 0 && index < int(ptr->entries.size()) && !ptr->entries[index].live)
+					index++;
+				if (index >= int(ptr->entries.size()))
+					index = -1;
+			}
+		public:
+			iterator() : ptr(NULL), index(-1) { }
+			iterator operator++() { index++; skip(); return *this; }
+			iterator operator++(int) { iterator tmp = *this; index++; skip(); return tmp; }
+			bool operator==(const iterator &other) const { return index == other.index; }
+			bool operator!=(const iterator &other) const { return index != other.index; }
+			std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+			std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+		};
+
+		class const_iterator : public std::iterator<std::forward_iterator_tag, const std::pair<K, T>>
+		{
+			friend class dict;
+		protected:
+			const dict *ptr;
+			int index;
+			const_iterator(const dict *ptr, int index) : ptr(ptr), index(index) { skip(); }
+			void skip() {
+				while (index >= 0 && index < int(ptr->entries.size()) && !ptr->entries[index].live)
+					index++;
+				if (index >= int(ptr->entries.size()))
+					index = -1;
+			}
+		public:
+			const_iterator() : ptr(NULL), index(-1) { }
+			const_iterator(const iterator &it) : ptr(it.ptr), index(it.index) { }
+			const_iterator operator++() { index++; skip(); return *this; }
+			const_iterator operator++(int) { const_iterator tmp = *this; index++; skip(); return tmp; }
+			bool operator==(const const_iterator &other) const { return index == other.index; }
+			bool operator!=(const const_iterator &other) const { return index != other.index; }
+			const std::pair<K, T> &operator*() const { return ptr->entries[index].udata; }
+			const std::pair<K, T> *operator->() const { return &ptr->entries[index].udata; }
+		};
+
+		dict() : num_deleted(0)
+		{
+		}
+
+		dict(const dict &other) : num_deleted(0)
+		{
+			*this = other;
+		}
+
+		dict(dict &&other) : num_deleted(0)
+		{
+			swap(other);
+		}
+
+		template<class InputIterator>
+		dict(InputIterator first, InputIterator last) : num_deleted(0)
+		{
+			insert(first, last);
+		}
+
+		~dict()
+		{
+			clear();
+		}
+
+		dict &operator=(const dict &other)
+		{
+			if (this != &other) {
+				clear();
+				entries.reserve(other.size());
+				for (auto &e : other.entries)
+					if (e.live)
+						entries.push_back(e);
+				do_rehash();
+			}
+			return *this;
+		}
+
+		dict &operator=(dict &&other)
+		{
+			clear();
+			swap(other);
+			return *this;
+		}
+
+		size_t size() const
+		{
+			return entries.size() - num_deleted;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		// bytes allocated by the container itself, not counting the memory
+		// that is owned by the keys and values
+		size_t memory_usage() const
+		{
+			return hashtable.capacity() * sizeof(int) + entries.capacity() * sizeof(entry_t);
+		}
+
+		void clear()
+		{
+			hashtable.clear();
+			entries.clear();
+			num_deleted = 0;
+		}
+
+		void swap(dict &other)
+		{
+			hashtable.swap(other.hashtable);
+			entries.swap(other.entries);
+			std::swap(num_deleted, other.num_deleted);
+		}
+
+		std::pair<iterator, bool> insert(const std::pair<K, T> &value)
+		{
+			int slot, index = do_lookup(value.first, slot);
+			if (index >= 0)
+				return std::pair<iterator, bool>(iterator(this, index), false);
+			index = do_insert(value, slot);
+			return std::pair<iterator, bool>(iterator(this, index), true);
+		}
+
+		template<class InputIterator>
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		size_t erase(const K &key)
+		{
+			int slot, index = do_lookup(key, slot);
+			if (index < 0)
+				return 0;
+			do_erase(index, slot);
+			return 1;
+		}
+
+		iterator erase(iterator it)
+		{
+			int slot, index = do_lookup(it->first, slot);
+			do_erase(index, slot);
+			return ++it;
+		}
+
+		size_t count(const K &key) const
+		{
+			int slot;
+			return do_lookup(key, slot) < 0 ? 0 : 1;
+		}
+
+		iterator find(const K &key)
+		{
+			int slot, index = do_lookup(key, slot);
+			return iterator(this, index);
+		}
+
+		const_iterator find(const K &key) const
+		{
+			int slot, index = do_lookup(key, slot);
+			return const_iterator(this, index);
+		}
+
+		T &at(const K &key)
+		{
+			int slot, index = do_lookup(key, slot);
+			if (index < 0)
+				throw std::out_of_range("dict::at()");
+			return entries[index].udata.second;
+		}
+
+		const T &at(const K &key) const
+		{
+			int slot, index = do_lookup(key, slot);
+			if (index < 0)
+				throw std::out_of_range("dict::at()");
+			return entries[index].udata.second;
+		}
+
+		T &operator[](const K &key)
+		{
+			int slot, index = do_lookup(key, slot);
+			if (index < 0)
+				index = do_insert(std::pair<K, T>(key, T()), slot);
+			return entries[index].udata.second;
+		}
+
+		// comparison does not depend on the order of the elements
+		bool operator==(const dict &other) const
+		{
+			if (size() != other.size())
+				return false;
+			for (auto &e : entries) {
+				if (!e.live)
+					continue;
+				int slot, index = other.do_lookup(e.udata.first, slot);
+				if (index < 0 || !(other.entries[index].udata.second == e.udata.second))
+					return false;
+			}
+			return true;
+		}
+
+		bool operator!=(const dict &other) const
+		{
+			return !(*this == other);
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, -1); }
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, -1); }
+	};
+
+	template<typename K, typename T, int N, typename OPS = hash_ops<K>>
+	class flat_dict
+	{
+		static_assert(N > 0 && N <= 32, "flat_dict: N must be between 1 and 32");
+		static const int index_threshold = 32;
+
+		// elements that do not fit in the inline storage, and the index
+		// from the keys to the element positions for large containers
+		struct overflow_t {
+			std::vector<std::pair<K, T>*> entries;
+			dict<K, int, OPS> index;
+			bool indexed;
+			overflow_t() : indexed(false) { }
+		};
+
+		// positions 0 .. N-1 are the inline slots, further positions are
+		// the overflow entries; inline_live has one bit per live inline slot
+		alignas(std::pair<K, T>) unsigned char inline_storage[N * sizeof(std::pair<K, T>)];
+		int inline_used, num_deleted;
+		uint32_t inline_live;
+		overflow_t *overflow;
+
+		std::pair<K, T> *entry(int pos) const
+		{
+			if (pos < N) {
+				if (pos >= inline_used || ((inline_live >> pos) & 1) == 0)
+					return NULL;
+				return reinterpret_cast<std::pair<K, T>*>(const_cast<unsigned char*>(inline_storage)) + pos;
+			}
+			return overflow->entries[pos - N];
+		}
+
+		int num_positions() const
+		{
+			return overflow ? N + overflow->entries.size() : inline_used;
+		}
+
+		int do_lookup(const K &key) const
+		{
+			if (overflow && overflow->indexed) {
+				auto it = overflow->index.find(key);
+				return it == overflow->index.end() ? -1 : it->second;
+			}
+			for (int pos = 0, end = num_positions(); pos < end; pos++) {
+				std::pair<K, T> *e = entry(pos);
+				if (e != NULL && OPS::cmp(e->first, key))
+					return pos;
+			}
+			return -1;
+		}
+
+		// drops the erased elements at the end of the container, so that the
+		// next element goes to their positions (and to the inline slots again)
+		void trim_tail()
+		{
+			if (overflow != NULL) {
+				while (!overflow->entries.empty() && overflow->entries.back() == NULL) {
+					overflow->entries.pop_back();
+					num_deleted--;
+				}
+				if (!overflow->entries.empty())
+					return;
+				delete overflow;
+				overflow = NULL;
+			}
+			while (inline_used > 0 && ((inline_live >> (inline_used - 1)) & 1) == 0) {
+				inline_used--;
+				num_deleted--;
+			}
+		}
+
+		// removes the erased overflow elements, the remaining elements keep
+		// their order and their addresses but move to lower positions
+		void compact_overflow()
+		{
+			int new_size = 0;
+			for (auto e : overflow->entries)
+				if (e != NULL)
+					overflow->entries[new_size++] = e;
+			num_deleted -= overflow->entries.size() - new_size;
+			overflow->entries.resize(new_size);
+			if (overflow->indexed) {
+				overflow->index.clear();
+				for (int i = 0, end = num_positions(); i < end; i++)
+					if (std::pair<K, T> *e = entry(i))
+						overflow->index[e->first] = i;
+			}
+		}
+
+		int do_insert(const std::pair<K, T> &value)
+		{
+			trim_tail();
+			if (overflow != NULL && num_deleted > N && 2 * num_deleted > num_positions())
+				compact_overflow();
+
+			int pos;
+			if (inline_used < N) {
+				pos = inline_used++;
+				new (reinterpret_cast<std::pair<K, T>*>(inline_storage) + pos) std::pair<K, T>(value);
+				inline_live |= uint32_t(1) << pos;
+			} else {
+				if (overflow == NULL)
+					overflow = new overflow_t;
+				overflow->entries.push_back(new std::pair<K, T>(value));
+				pos = N + overflow->entries.size() - 1;
+			}
+			if (overflow && overflow->indexed)
+				overflow->index[value.first] = pos;
+			else if (overflow && size() > index_threshold) {
+				for (int i = 0, end = num_positions(); i < end; i++)
+					if (std::pair<K, T> *e = entry(i))
+						overflow->index[e->first] = i;
+				overflow->indexed = true;
+			}
+			return pos;
+		}
+
+		void do_erase(int pos)
+		{
+			std::pair<K, T> *e = entry(pos);
+			if (overflow && overflow->indexed)
+				overflow->index.erase(e->first);
+			if (pos < N) {
+				e->~pair();
+				inline_live &= ~(uint32_t(1) << pos);
+			} else {
+				delete e;
+				overflow->entries[pos - N] = NULL;
+			}
+			num_deleted++;
+		}
+
+		// takes over the elements of other (at the same positions), this
+		// container must be empty
+		void move_from(flat_dict &other)
+		{
+			for (int pos = 0; pos < other.inline_used; pos++) {
+				std::pair<K, T> *e = other.entry(pos);
+				if (e == NULL)
+					continue;
+				new (reinterpret_cast<std::pair<K, T>*>(inline_storage) + pos) std::pair<K, T>(std::move(*e));
+				e->~pair();
+			}
+			inline_used = other.inline_used;
+			inline_live = other.inline_live;
+			num_deleted = other.num_deleted;
+			overflow = other.overflow;
+			other.inline_used = 0;
+			other.inline_live = 0;
+			other.num_deleted = 0;
+			other.overflow = NULL;
+		}
+
+	public:
+		typedef K key_type;
+		typedef T mapped_type;
+		typedef std::pair<K, T> value_type;
+
+		class const_iterator;
+
+		// an iterator is an element position, with -1 for end()
+		class iterator : public std::iterator<std::forward_iterator_tag, std::pair<K, T>>
+		{
+			friend class flat_dict;
+			friend class const_iterator;
+		protected:
+			flat_dict *ptr;
+			int index;
+			iterator(flat_dict *ptr, int index) : ptr(ptr), index(index) { skip(); }
+			void skip() {
+				while (index >= 0 && index < ptr->num_positions() && ptr->entry(index) == NULL)
+					index++;
+				if (index >= ptr->num_positions())
+					index = -1;
+			}
+		public:
+			iterator() : ptr(NULL), index(-1) { }
+			iterator operator++() { index++; skip(); return *this; }
+			iterator operator++(int) { iterator tmp = *this; index++; skip(); return tmp; }
+			bool operator==(const iterator &other) const { return index == other.index; }
+			bool operator!=(const iterator &other) const { return index != other.index; }
+			std::pair<K, T> &operator*() const { return *ptr->entry(index); }
+			std::pair<K, T> *operator->() const { return ptr->entry(index); }
+		};
+
+		class const_iterator : public std::iterator<std::forward_iterator_tag, const std::pair<K, T>>
+		{
+			friend class flat_dict;
+		protected:
+			const flat_dict *ptr;
+			int index;
+			const_iterator(const flat_dict *ptr, int index) : ptr(ptr), index(index) { skip(); }
+			void skip() {
+				while (index >= 0 && index < ptr->num_positions() && ptr->entry(index) == NULL)
+					index++;
+				if (index >= ptr->num_positions())
+					index = -1;
+			}
+		public:
+			const_iterator() : ptr(NULL), index(-1) { }
+			const_iterator(const iterator &it) : ptr(it.ptr), index(it.index) { }
+			const_iterator operator++() { index++; skip(); return *this; }
+			const_iterator operator++(int) { const_iterator tmp = *this; index++; skip(); return tmp; }
+			bool operator==(const const_iterator &other) const { return index == other.index; }
+			bool operator!=(const const_iterator &other) const { return index != other.index; }
+			const std::pair<K, T> &operator*() const { return *ptr->entry(index); }
+			const std::pair<K, T> *operator->() const { return ptr->entry(index); }
+		};
+
+		flat_dict() : inline_used(0), num_deleted(0), inline_live(0), overflow(NULL)
+		{
+		}
+
+		flat_dict(const flat_dict &other) : inline_used(0), num_deleted(0), inline_live(0), overflow(NULL)
+		{
+			*this = other;
+		}
+
+		flat_dict(flat_dict &&other) : inline_used(0), num_deleted(0), inline_live(0), overflow(NULL)
+		{
+			move_from(other);
+		}
+
+		template<class InputIterator>
+		flat_dict(InputIterator first, InputIterator last) : inline_used(0), num_deleted(0), inline_live(0), overflow(NULL)
+		{
+			insert(first, last);
+		}
+
+		~flat_dict()
+		{
+			clear();
+		}
+
+		flat_dict &operator=(const flat_dict &other)
+		{
+			if (this != &other) {
+				clear();
+				for (auto &it : other)
+					do_insert(it);
+			}
+			return *this;
+		}
+
+		flat_dict &operator=(flat_dict &&other)
+		{
+			if (this != &other) {
+				clear();
+				move_from(other);
+			}
+			return *this;
+		}
+
+		size_t size() const
+		{
+			return num_positions() - num_deleted;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		// bytes allocated by the container itself, not counting the memory
+		// that is owned by the keys and values (and not the inline storage,
+		// which is part of the object that contains the container)
+		size_t memory_usage() const
+		{
+			if (overflow == NULL)
+				return 0;
+			size_t size = sizeof(overflow_t) + overflow->entries.capacity() * sizeof(std::pair<K, T>*);
+			for (auto e : overflow->entries)
+				if (e != NULL)
+					size += sizeof(std::pair<K, T>);
+			return size + overflow->index.memory_usage();
+		}
+
+		void clear()
+		{
+			for (int pos = 0; pos < inline_used; pos++)
+				if (std::pair<K, T> *e = entry(pos))
+					e->~pair();
+			if (overflow != NULL) {
+				for (auto e : overflow->entries)
+					delete e;
+				delete overflow;
+			}
+			inline_used = 0;
+			inline_live = 0;
+			num_deleted = 0;
+			overflow = NULL;
+		}
+
+		void swap(flat_dict &other)
+		{
+			flat_dict tmp;
+			tmp.move_from(other);
+			other.move_from(*this);
+			move_from(tmp);
+		}
+
+		std::pair<iterator, bool> insert(const std::pair<K, T> &value)
+		{
+			int pos = do_lookup(value.first);
+			if (pos >= 0)
+				return std::pair<iterator, bool>(iterator(this, pos), false);
+			pos = do_insert(value);
+			return std::pair<iterator, bool>(iterator(this, pos), true);
+		}
+
+		template<class InputIterator>
+		void insert(InputIterator first, InputIterator last)
+		{
+			for (; first != last; ++first)
+				insert(*first);
+		}
+
+		size_t erase(const K &key)
+		{
+			int pos = do_lookup(key);
+			if (pos < 0)
+				return 0;
+			do_erase(pos);
+			return 1;
+		}
+
+		iterator erase(iterator it)
+		{
+			do_erase(it.index);
+			return ++it;
+		}
+
+		size_t count(const K &key) const
+		{
+			return do_lookup(key) < 0 ? 0 : 1;
+		}
+
+		iterator find(const K &key)
+		{
+			return iterator(this, do_lookup(key));
+		}
+
+		const_iterator find(const K &key) const
+		{
+			return const_iterator(this, do_lookup(key));
+		}
+
+		T &at(const K &key)
+		{
+			int pos = do_lookup(key);
+			if (pos < 0)
+				throw std::out_of_range("flat_dict::at()");
+			return entry(pos)->second;
+		}
+
+		const T &at(const K &key) const
+		{
+			int pos = do_lookup(key);
+			if (pos < 0)
+				throw std::out_of_range("flat_dict::at()");
+			return entry(pos)->second;
+		}
+
+		T &operator[](const K &key)
+		{
+			int pos = do_lookup(key);
+			if (pos < 0)
+				pos = do_insert(std::pair<K, T>(key, T()));
+			return entry(pos)->second;
+		}
+
+		// comparison does not depend on the order of the elements
+		bool operator==(const flat_dict &other) const
+		{
+			if (size() != other.size())
+				return false;
+			for (auto &it : *this) {
+				int pos = other.do_lookup(it.first);
+				if (pos < 0 || !(other.entry(pos)->second == it.second))
+					return false;
+			}
+			return true;
+		}
+
+		bool operator!=(const flat_dict &other) const
+		{
+			return !(*this == other);
+		}
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, -1); }
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, -1); }
+	};
+}
+
+#endif
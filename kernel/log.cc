@@ -27,18 +27,175 @@
 #include <stdarg.h>
 #include <vector>
 #include <list>
+#include <mutex>
+#include <algorithm>
+#include <unistd.h>
+#include <signal.h>
 
 std::vector<FILE*> log_files;
 FILE *log_errfile = NULL;
 bool log_time = false;
 bool log_cmd_error_throw = false;
 
+thread_local std::string *log_buffer = NULL;
+thread_local bool log_error_throw = false;
+int log_level = LOG_LEVEL_NORMAL;
+
 std::vector<int> header_count;
 std::list<std::string> string_buf;
+static std::mutex string_buf_mutex;
 
 static struct timeval initial_tv = { 0, 0 };
 static bool next_print_log = false;
 
+// the output for the log files is collected per thread and written in bulk
+// when the buffer is full, by log_flush() and when the thread exits. while
+// one of the log files is a terminal the output is written right away.
+#define LOG_OUTPUT_BUFFER_SIZE (64*1024)
+
+struct LogOutputBuffer;
+static void log_output_register(LogOutputBuffer *buffer, bool add);
+
+// the buffer of this thread for the crash handler, a plain pointer can be
+// read in a signal handler without running the thread_local initialization
+static thread_local LogOutputBuffer *log_output_self = NULL;
+
+struct LogOutputBuffer
+{
+	std::string data;
+	std::vector<FILE*> checked_files;
+	bool interactive;
+
+	LogOutputBuffer() : interactive(false)
+	{
+		log_output_register(this, true);
+		log_output_self = this;
+	}
+
+	~LogOutputBuffer()
+	{
+		write();
+		log_output_self = NULL;
+		log_output_register(this, false);
+	}
+
+	bool unbuffered()
+	{
+		if (checked_files != log_files) {
+			checked_files = log_files;
+			interactive = false;
+			for (auto f : log_files)
+				if (isatty(fileno(f)))
+					interactive = true;
+		}
+		return interactive;
+	}
+
+	// the files are flushed as well, the crash handler can't flush them
+	void write()
+	{
+		if (data.empty())
+			return;
+		for (auto f : log_files) {
+			fwrite(data.data(), 1, data.size(), f);
+			fflush(f);
+		}
+		data.clear();
+	}
+};
+
+static thread_local LogOutputBuffer log_output;
+
+// all buffers that exist, in the order the threads started logging (the main
+// thread first). the registry and its mutex are never destroyed, threads may
+// still exit while the static objects are destroyed.
+static std::mutex &log_output_mutex = *new std::mutex;
+static std::vector<LogOutputBuffer*> &log_output_buffers = *new std::vector<LogOutputBuffer*>;
+
+// writes the buffers of all threads, used before the process exits on an
+// error. the other threads are either waiting for the thread pool jobs or
+// write their output to a log_buffer, so their buffers don't change.
+static void log_flush_all()
+{
+	{
+		std::lock_guard<std::mutex> lock(log_output_mutex);
+		for (auto buffer : log_output_buffers)
+			buffer->write();
+	}
+	for (auto f : log_files)
+		fflush(f);
+}
+
+static void log_output_register(LogOutputBuffer *buffer, bool add)
+{
+	std::lock_guard<std::mutex> lock(log_output_mutex);
+	if (add)
+		log_output_buffers.push_back(buffer);
+	else
+		log_output_buffers.erase(std::find(log_output_buffers.begin(), log_output_buffers.end(), buffer));
+}
+
+// the crash signals are delivered to the thread that caused them, so only
+// the buffer of this thread is written. the buffers of the other threads may
+// be changed at the same time and are lost. the handler must not take locks
+// or use stdio (the crash may have happened while holding the FILE or heap
+// locks), so the buffer is written with write(2). the installation uses
+// SA_RESETHAND, the re-raised signal ends the program as before.
+static void log_crash_handler(int sig)
+{
+	LogOutputBuffer *buffer = log_output_self;
+	if (buffer != NULL) {
+		const char *data = buffer->data.data();
+		size_t size = buffer->data.size();
+		for (auto f : log_files) {
+			int fd = fileno_unlocked(f);
+			for (size_t pos = 0; fd >= 0 && pos < size;) {
+				ssize_t rc = ::write(fd, data + pos, size - pos);
+				if (rc <= 0)
+					break;
+				pos += rc;
+			}
+		}
+	}
+	raise(sig);
+}
+
+void log_install_crash_handlers()
+{
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = log_crash_handler;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESETHAND;
+	for (int sig : { SIGABRT, SIGSEGV, SIGBUS })
+		sigaction(sig, &sa, NULL);
+}
+
+// formats the message directly at the end of the string
+static void log_vappend(std::string &str, const char *format, va_list ap)
+{
+	char tmp[256];
+	va_list aq;
+
+	va_copy(aq, ap);
+	int len = vsnprintf(tmp, sizeof(tmp), format, aq);
+	va_end(aq);
+
+	if (len < 0)
+		return;
+	if (len < int(sizeof(tmp))) {
+		str.append(tmp, len);
+		return;
+	}
+
+	size_t pos = str.size();
+	str.resize(pos + len + 1);
+	va_copy(aq, ap);
+	vsnprintf(&str[pos], len + 1, format, aq);
+	va_end(aq);
+	str.resize(pos + len);
+}
+
 std::string stringf(const char *fmt, ...)
 {
 	std::string string;
@@ -60,6 +217,14 @@ std::string stringf(const char *fmt, ...)
 
 void logv(const char *format, va_list ap)
 {
+	if (log_files.empty())
+		return;
+
+	if (log_buffer != NULL) {
+		log_vappend(*log_buffer, format, ap);
+		return;
+	}
+
 	if (log_time) {
 		while (format[0] == '\n' && format[1] != 0) {
 			format++;
@@ -83,12 +248,9 @@ void logv(const char *format, va_list ap)
 			next_print_log = true;
 	}
 
-	for (auto f : log_files) {
-		va_list aq;
-		va_copy(aq, ap);
-		vfprintf(f, format, aq);
-		va_end(aq);
-	}
+	log_vappend(log_output.data, format, ap);
+	if (log_output.data.size() >= LOG_OUTPUT_BUFFER_SIZE || log_output.unbuffered())
+		log_output.write();
 }
 
 void logv_header(const char *format, va_list ap)
@@ -105,13 +267,25 @@ void logv_header(const char *format, va_list ap)
 
 void logv_error(const char *format, va_list ap)
 {
+	if (log_error_throw) {
+		std::string message;
+		log_vappend(message, format, ap);
+		throw log_error_exception(message);
+	}
+
+	if (log_buffer != NULL) {
+		std::string *buffer = log_buffer;
+		log_buffer = NULL;
+		log("%s", buffer->c_str());
+	}
+
 	log("ERROR: ");
 	logv(format, ap);
 	if (log_errfile != NULL) {
 		fprintf(log_errfile, "ERROR: ");
 		vfprintf(log_errfile, format, ap);
 	}
-	log_flush();
+	log_flush_all();
 	exit(1);
 }
 
@@ -175,6 +349,7 @@ void log_reset_stack()
 
 void log_flush()
 {
+	log_output.write();
 	for (auto f : log_files)
 		fflush(f);
 }
@@ -189,6 +364,7 @@ const char *log_signal(const RTLIL::SigSpec &sig, bool autoint)
 	fputc(0, f);
 	fclose(f);
 
+	std::lock_guard<std::mutex> lock(string_buf_mutex);
 	string_buf.push_back(ptr);
 	free(ptr);
 
@@ -29,6 +29,35 @@ extern FILE *log_errfile;
 extern bool log_time;
 extern bool log_cmd_error_throw;
 
+// when set, log() appends to this buffer instead of writing to the log files
+// (used to collect the output of jobs running in other threads)
+extern thread_local std::string *log_buffer;
+
+// when set, log_error() throws a log_error_exception instead of exiting (used
+// in jobs running in other threads, the error is reported by the main thread
+// after all jobs have finished)
+extern thread_local bool log_error_throw;
+
+struct log_error_exception {
+	std::string message;
+	log_error_exception(const std::string &message) : message(message) { }
+};
+
+// messages above log_level are dropped before their arguments are evaluated
+// (see log_debug() below). LOG_LEVEL_DEBUG is for per-object messages, such
+// as one line per removed or mapped cell; passes should also log a summary
+// of them at the normal level.
+#define LOG_LEVEL_NORMAL 1
+#define LOG_LEVEL_DEBUG  2
+extern int log_level;
+
+// true if a message at this level would end up in a log file. The log output
+// is buffered, call log_flush() before writing to the log files directly.
+static inline bool log_active(int level = LOG_LEVEL_NORMAL)
+{
+	return level <= log_level && !log_files.empty();
+}
+
 std::string stringf(const char *fmt, ...);
 
 void logv(const char *format, va_list ap);
@@ -46,8 +75,14 @@ void log_pop();
 void log_reset_stack();
 void log_flush();
 
+// writes the log output of the crashing thread on SIGABRT, SIGSEGV and SIGBUS,
+// called by the yosys driver (not by programs that embed libyosys)
+void log_install_crash_handlers();
+
 const char *log_signal(const RTLIL::SigSpec &sig, bool autoint = true);
 
+#define log_debug(...) do { if (log_active(LOG_LEVEL_DEBUG)) log(__VA_ARGS__); } while (0)
+
 #define log_abort() log_error("Abort in %s:%d.\n", __FILE__, __LINE__)
 #define log_assert(_assert_expr_) do { if (_assert_expr_) break; log_error("Assert `%s' failed in %s:%d.\n", #_assert_expr_, __FILE__, __LINE__); } while (0)
 
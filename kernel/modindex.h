@@ -0,0 +1,230 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Index of the cell ports driving and reading each bit of a module.
+ *
+ *  The index is attached to the module as an RTLIL::Monitor and is owned by
+ *  it. Cells added, removed, reconnected or retyped and module connections
+ *  added through the Module API update the index incrementally, so it stays
+ *  valid across passes that only use this API (see Pass::monitored). Changes
+ *  made behind the index's back (Module::notify_blackout(), also called by
+ *  Pass::call() after all other passes) drop the index contents, and it is
+ *  rebuilt on the next query.
+ *
+ *  Ports of known internal cells are classified using CellTypes. All ports of
+ *  other cells are considered to be both drivers and users of the signal.
+ *
+ */
+
+#ifndef MODINDEX_H
+#define MODINDEX_H
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include <set>
+
+struct ModIndex : public RTLIL::Monitor
+{
+	struct PortInfo {
+		RTLIL::Cell *cell;
+		RTLIL::IdString port;
+		int offset;
+		PortInfo() : cell(NULL), offset(0) { }
+		PortInfo(RTLIL::Cell *cell, RTLIL::IdString port, int offset) : cell(cell), port(port), offset(offset) { }
+		bool operator<(const PortInfo &other) const {
+			if (cell != other.cell)
+				return cell < other.cell;
+			if (port != other.port)
+				return port < other.port;
+			return offset < other.offset;
+		}
+	};
+
+	struct BitInfo {
+		std::set<PortInfo> drivers, users;
+	};
+
+	RTLIL::Module *module;
+	SigMap sigmap;
+	CellTypes ct;
+	hashlib::dict<RTLIL::SigBit, BitInfo> database;
+	bool dirty;
+
+	// returns the index attached to the module, creating it if necessary
+	static ModIndex *get(RTLIL::Module *module)
+	{
+		for (auto monitor : module->monitors) {
+			ModIndex *index = dynamic_cast<ModIndex*>(monitor);
+			if (index != NULL)
+				return index;
+		}
+		return new ModIndex(module);
+	}
+
+	void reload()
+	{
+		if (!dirty)
+			return;
+		sigmap.set(module);
+		database.clear();
+		dirty = false;
+		for (auto &it : module->cells)
+			notify_add(it.second);
+	}
+
+	const BitInfo *query(RTLIL::SigBit bit)
+	{
+		reload();
+		auto it = database.find(sigmap(bit));
+		return it != database.end() ? &it->second : NULL;
+	}
+
+	void query_drivers(const RTLIL::SigSpec &sig, std::set<RTLIL::Cell*> &result)
+	{
+		for (auto bit : sig) {
+			const BitInfo *info = query(bit);
+			if (info != NULL)
+				for (auto &port : info->drivers)
+					result.insert(port.cell);
+		}
+	}
+
+	void query_users(const RTLIL::SigSpec &sig, std::set<RTLIL::Cell*> &result)
+	{
+		for (auto bit : sig) {
+			const BitInfo *info = query(bit);
+			if (info != NULL)
+				for (auto &port : info->users)
+					result.insert(port.cell);
+		}
+	}
+
+	virtual void notify_add(RTLIL::Cell *cell)
+	{
+		if (!dirty)
+			for (auto &it : cell->connections)
+				port_add(cell, it.first, it.second);
+	}
+
+	virtual void notify_remove(RTLIL::Cell *cell)
+	{
+		if (!dirty)
+			for (auto &it : cell->connections)
+				port_del(cell, it.first, it.second);
+	}
+
+	virtual void notify_connect(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &sig)
+	{
+		if (!dirty) {
+			port_del(cell, port, old_sig);
+			port_add(cell, port, sig);
+		}
+	}
+
+	virtual void notify_connect(RTLIL::Module*, const RTLIL::SigSig &conn)
+	{
+		if (dirty)
+			return;
+
+		// merge the entries of the bits that are now connected
+		std::vector<RTLIL::SigBit> lhs = sigmap(conn.first).to_sigbit_vector();
+		std::vector<RTLIL::SigBit> rhs = sigmap(conn.second).to_sigbit_vector();
+		sigmap.add(conn.first, conn.second);
+
+		for (size_t i = 0; i < lhs.size(); i++) {
+			if (lhs[i] == rhs[i])
+				continue;
+			BitInfo info;
+			for (auto bit : { lhs[i], rhs[i] }) {
+				auto it = database.find(bit);
+				if (it == database.end())
+					continue;
+				info.drivers.insert(it->second.drivers.begin(), it->second.drivers.end());
+				info.users.insert(it->second.users.begin(), it->second.users.end());
+				database.erase(it);
+			}
+			RTLIL::SigBit bit = sigmap(lhs[i]);
+			if (bit.wire != NULL && (!info.drivers.empty() || !info.users.empty())) {
+				BitInfo &new_info = database[bit];
+				new_info.drivers.insert(info.drivers.begin(), info.drivers.end());
+				new_info.users.insert(info.users.begin(), info.users.end());
+			}
+		}
+	}
+
+	virtual void notify_blackout(RTLIL::Module*)
+	{
+		sigmap.clear();
+		database.clear();
+		dirty = true;
+	}
+
+	virtual void notify_delete(RTLIL::Module*)
+	{
+		delete this;
+	}
+
+private:
+	ModIndex(RTLIL::Module *module) : module(module), dirty(true)
+	{
+		ct.setup_internals();
+		ct.setup_internals_mem();
+		ct.setup_stdcells();
+		ct.setup_stdcells_mem();
+		module->monitors.insert(this);
+	}
+
+	virtual ~ModIndex()
+	{
+		module->monitors.erase(this);
+	}
+
+	void port_add(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
+	{
+		bool is_driver = !ct.cell_input(cell->type, port);
+		bool is_user = !ct.cell_output(cell->type, port);
+		int offset = 0;
+		for (auto bit : sigmap(sig)) {
+			if (bit.wire != NULL) {
+				BitInfo &info = database[bit];
+				if (is_driver)
+					info.drivers.insert(PortInfo(cell, port, offset));
+				if (is_user)
+					info.users.insert(PortInfo(cell, port, offset));
+			}
+			offset++;
+		}
+	}
+
+	void port_del(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
+	{
+		int offset = 0;
+		for (auto bit : sigmap(sig)) {
+			if (bit.wire != NULL && database.count(bit)) {
+				BitInfo &info = database.at(bit);
+				info.drivers.erase(PortInfo(cell, port, offset));
+				info.users.erase(PortInfo(cell, port, offset));
+			}
+			offset++;
+		}
+	}
+};
+
+#endif
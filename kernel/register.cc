@@ -19,10 +19,16 @@
 
 #include "register.h"
 #include "log.h"
+#include "threadpool.h"
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 using namespace REGISTER_INTERN;
 #define MAX_REG_COUNT 1000
@@ -39,8 +45,143 @@ namespace REGISTER_INTERN
 }
 
 std::vector<std::string> Frontend::next_args;
+Pass *Pass::current_pass = NULL;
 
-Pass::Pass(std::string name, std::string short_help) : pass_name(name), short_help(short_help)
+namespace {
+	int64_t wall_clock_ns()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+	}
+
+	// Chrome trace-event output, one complete ("X") event per span. The file
+	// is written in the JSON array format, which trace viewers also accept
+	// without the closing bracket if yosys exits with an error.
+	FILE *trace_file = NULL;
+	std::mutex trace_mutex;
+	bool trace_first_event;
+	int64_t trace_start_ns;
+	std::atomic<int> trace_next_tid(0);
+	thread_local int trace_tid = -1;
+
+	std::string trace_escape(const std::string &str)
+	{
+		std::string res;
+		for (char ch : str) {
+			if (ch == '"' || ch == '\\')
+				res += '\\';
+			if ((unsigned char)ch < 0x20)
+				res += stringf("\\u%04x", ch);
+			else
+				res += ch;
+		}
+		return res;
+	}
+
+	void trace_event(const std::string &name, const char *category, int64_t start_ns, int64_t end_ns, const std::string &args_json)
+	{
+		if (trace_tid < 0)
+			trace_tid = trace_next_tid++;
+
+		std::lock_guard<std::mutex> lock(trace_mutex);
+		fprintf(trace_file, "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d, \"args\": {%s}}",
+				trace_first_event ? "" : ",", trace_escape(name).c_str(), category, (start_ns - trace_start_ns) * 1e-3,
+				(end_ns - start_ns) * 1e-3, trace_tid, args_json.c_str());
+		trace_first_event = false;
+	}
+
+	std::string trace_selection(RTLIL::Design *design)
+	{
+		if (design->selection_stack.empty() || design->full_selection())
+			return "*";
+		std::string str;
+		int count = 0;
+		for (auto &it : design->modules) {
+			if (!design->selected_module(it.first))
+				continue;
+			if (count++ == 10) {
+				str += " ...";
+				break;
+			}
+			str += (str.empty() ? "" : " ") + std::string(RTLIL::id2cstr(it.first));
+			if (!design->selected_whole_module(it.first))
+				str += "(partial)";
+		}
+		return str;
+	}
+
+	// records the resources used by one call of a pass
+	struct PassProfiler
+	{
+		Pass *pass, *parent;
+		const std::vector<std::string> &args;
+		RTLIL::Design *design;
+		int64_t start_wall_ns, start_cpu_ns;
+		long start_maxrss_kb;
+
+		static void now(int64_t &wall_ns, int64_t &cpu_ns, long &maxrss_kb)
+		{
+			wall_ns = wall_clock_ns();
+
+			struct rusage ru;
+			getrusage(RUSAGE_SELF, &ru);
+			cpu_ns = (int64_t(ru.ru_utime.tv_sec) + ru.ru_stime.tv_sec) * 1000000000 +
+					(int64_t(ru.ru_utime.tv_usec) + ru.ru_stime.tv_usec) * 1000;
+			maxrss_kb = ru.ru_maxrss;
+		}
+
+		PassProfiler(Pass *pass, const std::vector<std::string> &args, RTLIL::Design *design) :
+				pass(pass), parent(Pass::current_pass), args(args), design(design)
+		{
+			Pass::current_pass = pass;
+			now(start_wall_ns, start_cpu_ns, start_maxrss_kb);
+		}
+
+		~PassProfiler()
+		{
+			int64_t wall_ns, cpu_ns;
+			long maxrss_kb;
+			now(wall_ns, cpu_ns, maxrss_kb);
+
+			// the selection of the pass is still on the selection stack here
+			if (trace_file != NULL) {
+				std::string command;
+				for (auto &arg : args)
+					command += (command.empty() ? "" : " ") + arg;
+				trace_event(pass->pass_name, "pass", start_wall_ns, wall_ns, stringf("\"command\": \"%s\", \"selection\": \"%s\"",
+						trace_escape(command).c_str(), trace_escape(trace_selection(design)).c_str()));
+			}
+
+			wall_ns -= start_wall_ns, cpu_ns -= start_cpu_ns;
+
+			pass->call_counter++;
+			pass->wall_ns += wall_ns;
+			pass->self_wall_ns += wall_ns;
+			pass->cpu_ns += cpu_ns;
+			pass->self_cpu_ns += cpu_ns;
+			pass->rss_growth_kb += maxrss_kb - start_maxrss_kb;
+			if (parent != NULL) {
+				parent->self_wall_ns -= wall_ns;
+				parent->self_cpu_ns -= cpu_ns;
+			}
+			Pass::current_pass = parent;
+		}
+	};
+
+	std::vector<Pass*> profiled_passes()
+	{
+		std::vector<Pass*> passes;
+		for (auto &it : pass_register)
+			if (it.second->call_counter > 0)
+				passes.push_back(it.second);
+		std::stable_sort(passes.begin(), passes.end(), [](Pass *a, Pass *b) { return a->self_wall_ns > b->self_wall_ns; });
+		return passes;
+	}
+}
+
+Pass::Pass(std::string name, std::string short_help) : pass_name(name), short_help(short_help), modifies_design(true),
+		monitored(false), modifies_selected_only(false), call_counter(0), wall_ns(0), self_wall_ns(0), cpu_ns(0), self_cpu_ns(0), rss_growth_kb(0)
 {
 	assert(!raw_register_done);
 	assert(raw_register_count < MAX_REG_COUNT);
@@ -81,6 +222,78 @@ void Pass::help()
 	log("\n");
 }
 
+void Pass::execute_module(RTLIL::Design*, RTLIL::Module*)
+{
+	log_abort();
+}
+
+void Pass::execute_modules(RTLIL::Design *design)
+{
+	std::vector<RTLIL::Module*> modules;
+	for (auto &mod_it : design->modules)
+		modules.push_back(mod_it.second);
+
+	// each module gets its own range of auto-generated names, so that the
+	// names are the same for any number of threads
+	int id_base = RTLIL::autoidx.fetch_add(modules.size());
+
+	if (ThreadPool::num_threads <= 1 || modules.size() <= 1) {
+		for (size_t idx = 0; idx < modules.size(); idx++) {
+			RTLIL::NewIdScope id_scope(id_base + idx);
+			int64_t start_ns = trace_file ? wall_clock_ns() : 0;
+			execute_module(design, modules[idx]);
+			if (trace_file)
+				trace_event(modules[idx]->name, "module", start_ns, wall_clock_ns(), "\"pass\": \"" + pass_name + "\"");
+		}
+		return;
+	}
+
+	// the log output so far must not get lost if a job crashes
+	log_flush();
+
+	// errors in the jobs are reported after all jobs have finished, so that
+	// the program does not exit while other jobs are still running
+	std::vector<std::string> buffers(modules.size());
+	std::vector<std::string> errors(modules.size());
+	std::vector<char> failed(modules.size());
+	try {
+		ThreadPool::run(modules.size(), [&](int idx) {
+			struct JobGuard {
+				std::string *old_buffer;
+				bool old_error_throw;
+				JobGuard(std::string *buffer) : old_buffer(log_buffer), old_error_throw(log_error_throw) {
+					log_buffer = buffer;
+					log_error_throw = true;
+				}
+				~JobGuard() {
+					log_buffer = old_buffer;
+					log_error_throw = old_error_throw;
+				}
+			} guard(&buffers[idx]);
+			RTLIL::NewIdScope id_scope(id_base + idx);
+			int64_t start_ns = trace_file ? wall_clock_ns() : 0;
+			try {
+				execute_module(design, modules[idx]);
+			} catch (log_error_exception &e) {
+				errors[idx] = e.message;
+				failed[idx] = true;
+				return;
+			}
+			if (trace_file)
+				trace_event(modules[idx]->name, "module", start_ns, wall_clock_ns(), "\"pass\": \"" + pass_name + "\"");
+		});
+	} catch (...) {
+		for (auto &buffer : buffers)
+			log("%s", buffer.c_str());
+		throw;
+	}
+	for (auto &buffer : buffers)
+		log("%s", buffer.c_str());
+	for (size_t idx = 0; idx < modules.size(); idx++)
+		if (failed[idx])
+			log_error("%s", errors[idx].c_str());
+}
+
 void Pass::cmd_log_args(const std::vector<std::string> &args)
 {
 	if (args.size() <= 1)
@@ -125,6 +338,9 @@ void Pass::extra_args(std::vector<std::string> args, size_t argidx, RTLIL::Desig
 		break;
 	}
 	cmd_log_args(args);
+
+	if (modifies_design && modifies_selected_only)
+		design->unshare(select);
 }
 
 void Pass::call(RTLIL::Design *design, std::string command)
@@ -167,6 +383,12 @@ void Pass::call(RTLIL::Design *design, std::string command)
 	call(design, args);
 }
 
+static void blackout_modules(RTLIL::Design *design)
+{
+	for (auto &mod_it : design->modules)
+		mod_it.second->notify_blackout();
+}
+
 void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 {
 	if (args.size() == 0 || args[0][0] == '#')
@@ -174,12 +396,89 @@ void Pass::call(RTLIL::Design *design, std::vector<std::string> args)
 	if (pass_register.count(args[0]) == 0)
 		log_cmd_error("No such command: %s (type 'help' for a command overview)\n", args[0].c_str());
 
+	Pass *pass = pass_register[args[0]];
+	if (pass->modifies_design && !pass->modifies_selected_only)
+		design->unshare();
+
+	// passes may modify modules without using the monitored Module API. the
+	// monitors are blacked out before such a pass, so they don't do needless
+	// incremental updates, and after it. a pass calling other passes may have
+	// changed modules behind the back of the monitors already, so the called
+	// pass is also given a consistent state.
+	bool blackout = pass->modifies_design && !pass->monitored;
+	if (blackout || (current_pass != NULL && current_pass->modifies_design && !current_pass->monitored))
+		blackout_modules(design);
+
 	size_t orig_sel_stack_pos = design->selection_stack.size();
-	pass_register[args[0]]->execute(args, design);
+	{
+		PassProfiler profiler(pass, args, design);
+		pass->execute(args, design);
+	}
+
+	if (blackout)
+		blackout_modules(design);
+
 	while (design->selection_stack.size() > orig_sel_stack_pos)
 		design->selection_stack.pop_back();
 }
 
+void Pass::trace_open(std::string filename)
+{
+	trace_file = fopen(filename.c_str(), "w");
+	if (trace_file == NULL)
+		log_error("Can't open trace file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+	fprintf(trace_file, "[");
+	trace_first_event = true;
+	trace_start_ns = wall_clock_ns();
+}
+
+void Pass::trace_close()
+{
+	if (trace_file == NULL)
+		return;
+	fprintf(trace_file, "\n]\n");
+	fclose(trace_file);
+	trace_file = NULL;
+}
+
+void Pass::log_profile()
+{
+	std::vector<Pass*> passes = profiled_passes();
+	if (passes.empty())
+		return;
+
+	int64_t total_ns = 0;
+	for (auto pass : passes)
+		total_ns += pass->self_wall_ns;
+
+	log("\nTime and memory spent per command (self excludes nested commands):\n\n");
+	log("  %6s %10s %10s %10s %6s %10s   %s\n", "calls", "wall", "self", "self-cpu", "self%", "peak-rss", "command");
+	for (auto pass : passes)
+		log("  %6d %9.3fs %9.3fs %9.3fs %5.1f%% %+8.1fMB   %s\n", pass->call_counter,
+				pass->wall_ns * 1e-9, pass->self_wall_ns * 1e-9, pass->self_cpu_ns * 1e-9,
+				total_ns > 0 ? 100.0 * pass->self_wall_ns / total_ns : 0.0,
+				pass->rss_growth_kb / 1024.0, pass->pass_name.c_str());
+}
+
+void Pass::write_profile_json(FILE *f)
+{
+	std::vector<Pass*> passes = profiled_passes();
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+
+	fprintf(f, "{\n  \"peak_rss_kb\": %ld,\n  \"passes\": [", ru.ru_maxrss);
+	for (size_t i = 0; i < passes.size(); i++) {
+		Pass *pass = passes[i];
+		fprintf(f, "%s\n    { \"name\": \"%s\", \"calls\": %d, \"wall_ns\": %lld, \"self_wall_ns\": %lld, "
+				"\"cpu_ns\": %lld, \"self_cpu_ns\": %lld, \"rss_growth_kb\": %ld }",
+				i ? "," : "", pass->pass_name.c_str(), pass->call_counter,
+				(long long)pass->wall_ns, (long long)pass->self_wall_ns,
+				(long long)pass->cpu_ns, (long long)pass->self_cpu_ns, pass->rss_growth_kb);
+	}
+	fprintf(f, "\n  ]\n}\n");
+}
+
 Frontend::Frontend(std::string name, std::string short_help) : Pass("read_"+name, short_help), frontend_name(name)
 {
 }
@@ -261,6 +560,7 @@ void Frontend::frontend_call(RTLIL::Design *design, FILE *f, std::string filenam
 	if (frontend_register.count(args[0]) == 0)
 		log_cmd_error("No such frontend: %s\n", args[0].c_str());
 
+	PassProfiler profiler(frontend_register[args[0]], args, design);
 	if (f != NULL) {
 		frontend_register[args[0]]->execute(f, filename, args, design);
 	} else if (filename == "-") {
@@ -274,6 +574,7 @@ void Frontend::frontend_call(RTLIL::Design *design, FILE *f, std::string filenam
 
 Backend::Backend(std::string name, std::string short_help) : Pass("write_"+name, short_help), backend_name(name)
 {
+	modifies_design = false;
 }
 
 void Backend::run_register()
@@ -352,14 +653,17 @@ void Backend::backend_call(RTLIL::Design *design, FILE *f, std::string filename,
 
 	size_t orig_sel_stack_pos = design->selection_stack.size();
 
-	if (f != NULL) {
-		backend_register[args[0]]->execute(f, filename, args, design);
-	} else if (filename == "-") {
-		backend_register[args[0]]->execute(stdout, "<stdout>", args, design);
-	} else {
-		if (!filename.empty())
-			args.push_back(filename);
-		backend_register[args[0]]->execute(args, design);
+	{
+		PassProfiler profiler(backend_register[args[0]], args, design);
+		if (f != NULL) {
+			backend_register[args[0]]->execute(f, filename, args, design);
+		} else if (filename == "-") {
+			backend_register[args[0]]->execute(stdout, "<stdout>", args, design);
+		} else {
+			if (!filename.empty())
+				args.push_back(filename);
+			backend_register[args[0]]->execute(args, design);
+		}
 	}
 
 	while (design->selection_stack.size() > orig_sel_stack_pos)
@@ -367,7 +671,7 @@ void Backend::backend_call(RTLIL::Design *design, FILE *f, std::string filename,
 }
 
 struct HelpPass : public Pass {
-	HelpPass() : Pass("help", "display help messages") { }
+	HelpPass() : Pass("help", "display help messages") { modifies_design = false; }
 	virtual void help()
 	{
 		log("\n");
@@ -465,8 +769,10 @@ struct HelpPass : public Pass {
 					size_t memsize;
 					char *memptr;
 					FILE *memf = open_memstream(&memptr, &memsize);
+					log_flush();
 					log_files.push_back(memf);
 					it.second->help();
+					log_flush();
 					log_files.pop_back();
 					fclose(memf);
 					write_tex(f, it.first, it.second->short_help, memptr);
@@ -481,8 +787,10 @@ struct HelpPass : public Pass {
 					size_t memsize;
 					char *memptr;
 					FILE *memf = open_memstream(&memptr, &memsize);
+					log_flush();
 					log_files.push_back(memf);
 					it.second->help();
+					log_flush();
 					log_files.pop_back();
 					fclose(memf);
 					write_html(f, it.first, it.second->short_help, memptr);
@@ -22,6 +22,7 @@
 
 #include "kernel/rtlil.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -39,12 +40,30 @@ std::string get_share_file_name(std::string file);
 struct Pass
 {
 	std::string pass_name, short_help;
+	bool modifies_design;
+	// set by passes that change modules only through the monitored Module API
+	// (or call Module::notify_blackout() themselves), so that Pass::call()
+	// does not need to black out all modules after the pass
+	bool monitored;
+	// set by passes that only modify the modules selected when they call
+	// extra_args(). modules shared with saved designs are then only copied
+	// if they are selected, instead of all of them before the pass runs
+	bool modifies_selected_only;
 	Pass(std::string name, std::string short_help = "** document me **");
 	virtual void run_register();
 	virtual ~Pass();
 	virtual void help();
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design) = 0;
 
+	// Passes that work on each module independently can implement
+	// execute_module() and call execute_modules() from execute(). The modules
+	// of the design are then processed concurrently by the kernel thread pool.
+	// execute_module() is called for all modules, selected or not. The log
+	// output of each module is buffered and written in the module order, and
+	// NEW_ID generates names from a per-module RTLIL::NewIdScope.
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module);
+	void execute_modules(RTLIL::Design *design);
+
 	void cmd_log_args(const std::vector<std::string> &args);
 	void cmd_error(const std::vector<std::string> &args, size_t argidx, std::string msg);
 	void extra_args(std::vector<std::string> args, size_t argidx, RTLIL::Design *design, bool select = true);
@@ -52,6 +71,21 @@ struct Pass
 	static void call(RTLIL::Design *design, std::string command);
 	static void call(RTLIL::Design *design, std::vector<std::string> args);
 
+	// profiling data, collected for each call of the pass. the "self" values
+	// exclude the time spent in nested pass calls (e.g. opt calling opt_const)
+	int call_counter;
+	int64_t wall_ns, self_wall_ns, cpu_ns, self_cpu_ns;
+	long rss_growth_kb;
+	static Pass *current_pass;
+
+	static void log_profile();
+	static void write_profile_json(FILE *f);
+
+	// write a span for every pass call (and for every module processed by
+	// execute_modules()) to a Chrome trace-event JSON file
+	static void trace_open(std::string filename);
+	static void trace_close();
+
 	static void init_register();
 	static void done_register();
 };
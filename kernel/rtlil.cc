@@ -19,11 +19,150 @@
 
 #include "kernel/rtlil.h"
 #include "kernel/log.h"
+#include "kernel/celltypes.h"
 #include "frontends/verilog/verilog_frontend.h"
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <mutex>
+
+std::atomic<int> RTLIL::autoidx(1);
+
+namespace {
+	struct IdStringHashOps {
+		size_t operator()(const char *p) const {
+			size_t h = 5381;
+			while (*p)
+				h = (h * 33) ^ (unsigned char)*(p++);
+			return h;
+		}
+		bool operator()(const char *a, const char *b) const {
+			return strcmp(a, b) == 0;
+		}
+	};
+
+	// keys point into the char blocks of the pool
+	std::unordered_map<const char*, int, IdStringHashOps, IdStringHashOps> global_id_index;
+	std::mutex global_id_mutex;
+	int global_id_count = 0;
+
+	// the characters of the names are copied into blocks of this size, longer
+	// names get a block of their own. Like the names, the blocks are never freed.
+	const size_t GLOBAL_ID_BLOCK_SIZE = 64 * 1024;
+	char *global_id_block_ptr = NULL;
+	size_t global_id_block_avail = 0;
+
+	// the new entry must be complete before the index is handed out, readers
+	// of the pool don't lock global_id_mutex
+	int add_global_id(const char *str)
+	{
+		size_t len = strlen(str);
+		char *p;
+		if (len >= GLOBAL_ID_BLOCK_SIZE / 4) {
+			p = (char*)malloc(len + 1);
+		} else {
+			if (global_id_block_avail < len + 1) {
+				global_id_block_ptr = (char*)malloc(GLOBAL_ID_BLOCK_SIZE);
+				global_id_block_avail = GLOBAL_ID_BLOCK_SIZE;
+			}
+			p = global_id_block_ptr;
+			global_id_block_ptr += len + 1;
+			global_id_block_avail -= len + 1;
+		}
+		memcpy(p, str, len + 1);
+
+		int idx = global_id_count;
+		RTLIL::IdString::entry_t *&chunk = RTLIL::IdString::global_id_storage[idx >> RTLIL::IdString::CHUNK_BITS];
+		if (chunk == NULL)
+			chunk = new RTLIL::IdString::entry_t[RTLIL::IdString::CHUNK_SIZE];
+		chunk[idx & (RTLIL::IdString::CHUNK_SIZE-1)].str = p;
+		chunk[idx & (RTLIL::IdString::CHUNK_SIZE-1)].len = len;
+		global_id_index[p] = idx;
+		global_id_count++;
+		return idx;
+	}
+
+	// the names that get fixed indices (see CellTypeId and CellPortId in celltypes.h)
+	const char *fixed_ids[] = {
+#define X(_name, _category, _port, _func) "$" #_name,
+		CELLTYPE_TABLE(X)
+#undef X
+#define X(_port) "\\" #_port,
+		CELLTYPE_OUTPUT_PORTS(X)
+#undef X
+	};
+}
+
+RTLIL::IdString::entry_t *RTLIL::IdString::global_id_storage[RTLIL::IdString::MAX_CHUNKS];
+
+int RTLIL::IdString::get_index(const char *str)
+{
+	// small direct mapped cache of the names looked up by this thread, so the
+	// lookups of existing names in the inner loops of passes (port and
+	// parameter names) don't take global_id_mutex
+	struct cache_entry_t {
+		const char *str;
+		int idx;
+	};
+	static thread_local cache_entry_t cache[1024];
+
+	size_t hash = IdStringHashOps()(str);
+	cache_entry_t &entry = cache[hash % 1024];
+	if (entry.str != NULL && strcmp(entry.str, str) == 0)
+		return entry.idx;
+
+	std::lock_guard<std::mutex> lock(global_id_mutex);
+
+	// index 0 is reserved for the empty string, followed by the fixed names
+	if (global_id_count == 0) {
+		add_global_id("");
+		for (auto name : fixed_ids)
+			add_global_id(name);
+		assert(global_id_count == CP_END);
+	}
+
+	int idx = 0;
+	if (str[0] != 0) {
+		auto it = global_id_index.find(str);
+		if (it != global_id_index.end())
+			idx = it->second;
+		else
+			idx = add_global_id(str);
+	}
+
+	entry.str = global_id_storage[idx >> CHUNK_BITS][idx & (CHUNK_SIZE-1)].str;
+	entry.idx = idx;
+	return idx;
+}
+
+thread_local RTLIL::NewIdScope *RTLIL::NewIdScope::current = NULL;
+
+std::string RTLIL::new_id_prefix(const char *file, int line, const char *func)
+{
+	const char *basename = strrchr(file, '/');
+	return stringf("$auto$%s:%d:%s$", basename ? basename+1 : file, line, func);
+}
+
+RTLIL::IdString RTLIL::new_id(const std::string &prefix)
+{
+	// reuse the buffer of this thread instead of building a new std::string
+	// for every name
+	static thread_local std::string buffer;
+	char digits[32];
 
-int RTLIL::autoidx = 1;
+	buffer = prefix;
+	NewIdScope *scope = NewIdScope::current;
+	if (scope != NULL)
+		snprintf(digits, sizeof(digits), "%d.%d", scope->base, scope->counter++);
+	else
+		snprintf(digits, sizeof(digits), "%d", autoidx++);
+	buffer += digits;
+
+	return IdString(buffer);
+}
 
 RTLIL::Const::Const(std::string str) : str(str)
 {
@@ -102,6 +241,174 @@ std::string RTLIL::Const::as_string() const
 	return ret;
 }
 
+RTLIL::IdSet::IdSet(const RTLIL::IdSet &other) : size_(0)
+{
+	*this = other;
+}
+
+RTLIL::IdSet::IdSet(RTLIL::IdSet &&other) : size_(0)
+{
+	swap(other);
+}
+
+RTLIL::IdSet::~IdSet()
+{
+	clear();
+}
+
+RTLIL::IdSet &RTLIL::IdSet::operator=(const RTLIL::IdSet &other)
+{
+	if (this != &other) {
+		clear();
+		pages.resize(other.pages.size(), NULL);
+		for (size_t i = 0; i < other.pages.size(); i++)
+			if (other.pages[i] != NULL) {
+				pages[i] = new uint64_t[PAGE_WORDS];
+				memcpy(pages[i], other.pages[i], PAGE_WORDS * sizeof(uint64_t));
+			}
+		size_ = other.size_;
+	}
+	return *this;
+}
+
+RTLIL::IdSet &RTLIL::IdSet::operator=(RTLIL::IdSet &&other)
+{
+	clear();
+	swap(other);
+	return *this;
+}
+
+bool RTLIL::IdSet::insert(RTLIL::IdString id)
+{
+	size_t page = id.index_ >> PAGE_BITS;
+	if (page >= pages.size())
+		pages.resize(page + 1, NULL);
+	if (pages[page] == NULL) {
+		pages[page] = new uint64_t[PAGE_WORDS];
+		memset(pages[page], 0, PAGE_WORDS * sizeof(uint64_t));
+	}
+	uint64_t &word = pages[page][(id.index_ >> 6) & (PAGE_WORDS-1)];
+	uint64_t mask = uint64_t(1) << (id.index_ & 63);
+	if (word & mask)
+		return false;
+	word |= mask;
+	size_++;
+	return true;
+}
+
+size_t RTLIL::IdSet::erase(RTLIL::IdString id)
+{
+	if (count(id) == 0)
+		return 0;
+	pages[id.index_ >> PAGE_BITS][(id.index_ >> 6) & (PAGE_WORDS-1)] &= ~(uint64_t(1) << (id.index_ & 63));
+	size_--;
+	return 1;
+}
+
+void RTLIL::IdSet::clear()
+{
+	for (auto page : pages)
+		delete[] page;
+	pages.clear();
+	size_ = 0;
+}
+
+void RTLIL::IdSet::swap(RTLIL::IdSet &other)
+{
+	pages.swap(other.pages);
+	std::swap(size_, other.size_);
+}
+
+RTLIL::IdSet &RTLIL::IdSet::operator|=(const RTLIL::IdSet &other)
+{
+	if (pages.size() < other.pages.size())
+		pages.resize(other.pages.size(), NULL);
+	for (size_t i = 0; i < other.pages.size(); i++) {
+		if (other.pages[i] == NULL)
+			continue;
+		if (pages[i] == NULL) {
+			pages[i] = new uint64_t[PAGE_WORDS];
+			memcpy(pages[i], other.pages[i], PAGE_WORDS * sizeof(uint64_t));
+			for (int j = 0; j < PAGE_WORDS; j++)
+				size_ += __builtin_popcountll(pages[i][j]);
+			continue;
+		}
+		for (int j = 0; j < PAGE_WORDS; j++) {
+			size_ += __builtin_popcountll(other.pages[i][j] & ~pages[i][j]);
+			pages[i][j] |= other.pages[i][j];
+		}
+	}
+	return *this;
+}
+
+RTLIL::IdSet &RTLIL::IdSet::operator&=(const RTLIL::IdSet &other)
+{
+	for (size_t i = 0; i < pages.size(); i++) {
+		if (pages[i] == NULL)
+			continue;
+		if (i >= other.pages.size() || other.pages[i] == NULL) {
+			for (int j = 0; j < PAGE_WORDS; j++)
+				size_ -= __builtin_popcountll(pages[i][j]);
+			delete[] pages[i];
+			pages[i] = NULL;
+			continue;
+		}
+		for (int j = 0; j < PAGE_WORDS; j++) {
+			size_ -= __builtin_popcountll(pages[i][j] & ~other.pages[i][j]);
+			pages[i][j] &= other.pages[i][j];
+		}
+	}
+	return *this;
+}
+
+RTLIL::IdSet &RTLIL::IdSet::operator-=(const RTLIL::IdSet &other)
+{
+	for (size_t i = 0; i < pages.size() && i < other.pages.size(); i++) {
+		if (pages[i] == NULL || other.pages[i] == NULL)
+			continue;
+		for (int j = 0; j < PAGE_WORDS; j++) {
+			size_ -= __builtin_popcountll(pages[i][j] & other.pages[i][j]);
+			pages[i][j] &= ~other.pages[i][j];
+		}
+	}
+	return *this;
+}
+
+bool RTLIL::IdSet::operator==(const RTLIL::IdSet &other) const
+{
+	if (size_ != other.size_)
+		return false;
+	for (auto id : *this)
+		if (other.count(id) == 0)
+			return false;
+	return true;
+}
+
+// returns the smallest index >= index that is in the set, or -1
+int RTLIL::IdSet::next(int index) const
+{
+	for (size_t page = index >> PAGE_BITS; page < pages.size(); page++, index = page << PAGE_BITS) {
+		if (pages[page] == NULL)
+			continue;
+		for (int word = (index >> 6) & (PAGE_WORDS-1); word < PAGE_WORDS; word++, index = (index | 63) + 1) {
+			uint64_t bits = pages[page][word] >> (index & 63);
+			if (bits != 0)
+				return index + __builtin_ctzll(bits);
+		}
+	}
+	return -1;
+}
+
+std::vector<RTLIL::IdString> RTLIL::IdSet::sorted() const
+{
+	std::vector<RTLIL::IdString> ids;
+	ids.reserve(size_);
+	for (auto id : *this)
+		ids.push_back(id);
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
 bool RTLIL::Selection::selected_module(RTLIL::IdString mod_name) const
 {
 	if (full_selection)
@@ -191,10 +498,25 @@ void RTLIL::Selection::optimize(RTLIL::Design *design)
 	}
 }
 
+bool RTLIL::Design::arena_alloc = true;
+
 RTLIL::Design::~Design()
 {
 	for (auto it = modules.begin(); it != modules.end(); it++)
-		delete it->second;
+		it->second->release();
+}
+
+// Modules can be shared copy-on-write between designs (see "design -save").
+// Pass::call() calls this before running a pass that may modify the design,
+// so that the pass only ever sees modules that are private to this design.
+void RTLIL::Design::unshare(bool selected_only)
+{
+	for (auto &it : modules)
+		if (it.second->share_count > 0 && (!selected_only || selected_module(it.first))) {
+			RTLIL::Module *copy = it.second->clone();
+			it.second->release();
+			it.second = copy;
+		}
 }
 
 void RTLIL::Design::check()
@@ -245,8 +567,18 @@ bool RTLIL::Design::selected_member(RTLIL::IdString mod_name, RTLIL::IdString me
 	return selection_stack.back().selected_member(mod_name, memb_name);
 }
 
+RTLIL::Module::Module()
+{
+	arena = RTLIL::Design::arena_alloc ? new Arena : NULL;
+	share_count = 0;
+	epoch = 0;
+	connections_epoch = 0;
+}
+
 RTLIL::Module::~Module()
 {
+	for (auto monitor : std::set<RTLIL::Monitor*>(monitors))
+		monitor->notify_delete(this);
 	for (auto it = wires.begin(); it != wires.end(); it++)
 		delete it->second;
 	for (auto it = memories.begin(); it != memories.end(); it++)
@@ -255,6 +587,10 @@ RTLIL::Module::~Module()
 		delete it->second;
 	for (auto it = processes.begin(); it != processes.end(); it++)
 		delete it->second;
+	for (auto data : cache_slots)
+		delete data;
+	if (arena != NULL)
+		arena->release();
 }
 
 RTLIL::IdString RTLIL::Module::derive(RTLIL::Design*, std::map<RTLIL::IdString, RTLIL::Const>)
@@ -348,13 +684,13 @@ void RTLIL::Module::cloneInto(RTLIL::Module *new_mod) const
 	new_mod->attributes = attributes;
 
 	for (auto &it : wires)
-		new_mod->wires[it.first] = new RTLIL::Wire(*it.second);
+		new_mod->wires[it.first] = new (new_mod->arena) RTLIL::Wire(*it.second);
 
 	for (auto &it : memories)
 		new_mod->memories[it.first] = new RTLIL::Memory(*it.second);
 
 	for (auto &it : cells)
-		new_mod->cells[it.first] = new RTLIL::Cell(*it.second);
+		new_mod->cells[it.first] = new (new_mod->arena) RTLIL::Cell(*it.second);
 
 	for (auto &it : processes)
 		new_mod->processes[it.first] = it.second->clone();
@@ -382,13 +718,29 @@ RTLIL::Module *RTLIL::Module::clone() const
 	return new_mod;
 }
 
+RTLIL::Module *RTLIL::Module::share()
+{
+	share_count++;
+	return this;
+}
+
+void RTLIL::Module::release()
+{
+	if (share_count > 0)
+		share_count--;
+	else
+		delete this;
+}
+
+int RTLIL::Module::new_cache_slot()
+{
+	static std::atomic<int> next_slot(0);
+	return next_slot++;
+}
+
 RTLIL::Wire *RTLIL::Module::new_wire(int width, RTLIL::IdString name)
 {
-	RTLIL::Wire *wire = new RTLIL::Wire;
-	wire->width = width;
-	wire->name = name;
-	add(wire);
-	return wire;
+	return addWire(name, width);
 }
 
 void RTLIL::Module::add(RTLIL::Wire *wire)
@@ -396,6 +748,7 @@ void RTLIL::Module::add(RTLIL::Wire *wire)
 	assert(!wire->name.empty());
 	assert(count_id(wire->name) == 0);
 	wires[wire->name] = wire;
+	epoch++;
 }
 
 void RTLIL::Module::add(RTLIL::Cell *cell)
@@ -403,6 +756,101 @@ void RTLIL::Module::add(RTLIL::Cell *cell)
 	assert(!cell->name.empty());
 	assert(count_id(cell->name) == 0);
 	cells[cell->name] = cell;
+	epoch++;
+	for (auto monitor : monitors)
+		monitor->notify_add(cell);
+}
+
+void RTLIL::Module::remove(RTLIL::Cell *cell)
+{
+	assert(cells.count(cell->name) != 0);
+	for (auto monitor : monitors)
+		monitor->notify_remove(cell);
+	cells.erase(cell->name);
+	delete cell;
+	epoch++;
+}
+
+void RTLIL::Module::connect(const RTLIL::SigSig &conn)
+{
+	for (auto monitor : monitors)
+		monitor->notify_connect(this, conn);
+	connections.push_back(conn);
+	epoch++;
+}
+
+void RTLIL::Module::connect(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig)
+{
+	epoch++;
+	if (monitors.size() > 0) {
+		RTLIL::SigSpec old_sig = cell->connections.count(port) ? cell->connections.at(port) : RTLIL::SigSpec();
+		cell->connections[port] = sig;
+		for (auto monitor : monitors)
+			monitor->notify_connect(cell, port, old_sig, sig);
+	} else
+		cell->connections[port] = sig;
+}
+
+void RTLIL::Module::disconnect(RTLIL::Cell *cell, RTLIL::IdString port)
+{
+	if (cell->connections.count(port) == 0)
+		return;
+	epoch++;
+	for (auto monitor : monitors)
+		monitor->notify_connect(cell, port, cell->connections.at(port), RTLIL::SigSpec());
+	cell->connections.erase(port);
+}
+
+void RTLIL::Module::retype(RTLIL::Cell *cell, RTLIL::IdString type)
+{
+	epoch++;
+	for (auto monitor : monitors)
+		monitor->notify_remove(cell);
+	cell->type = type;
+	for (auto monitor : monitors)
+		monitor->notify_add(cell);
+}
+
+void RTLIL::Module::notify_blackout()
+{
+	epoch++;
+	connections_epoch++;
+	for (auto monitor : monitors)
+		monitor->notify_blackout(this);
+}
+
+RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, int width)
+{
+	RTLIL::Wire *wire = new (arena) RTLIL::Wire;
+	wire->name = name;
+	wire->width = width;
+	add(wire);
+	return wire;
+}
+
+RTLIL::Wire *RTLIL::Module::addWire(RTLIL::IdString name, const RTLIL::Wire *other)
+{
+	RTLIL::Wire *wire = new (arena) RTLIL::Wire(*other);
+	wire->name = name;
+	add(wire);
+	return wire;
+}
+
+RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, RTLIL::IdString type)
+{
+	RTLIL::Cell *cell = new (arena) RTLIL::Cell;
+	cell->name = name;
+	cell->type = type;
+	add(cell);
+	return cell;
+}
+
+RTLIL::Cell *RTLIL::Module::addCell(RTLIL::IdString name, const RTLIL::Cell *other)
+{
+	RTLIL::Cell *cell = new (arena) RTLIL::Cell(*other);
+	cell->name = name;
+	add(cell);
+	return cell;
 }
 
 static bool fixup_ports_compare(const RTLIL::Wire *a, const RTLIL::Wire *b)
@@ -430,6 +878,7 @@ void RTLIL::Module::fixup_ports()
 	std::sort(all_ports.begin(), all_ports.end(), fixup_ports_compare);
 	for (size_t i = 0; i < all_ports.size(); i++)
 		all_ports[i]->port_id = i+1;
+	epoch++;
 }
 
 RTLIL::Wire::Wire()
@@ -598,6 +1047,31 @@ RTLIL::SigSpec::SigSpec(RTLIL::State bit, int width)
 	check();
 }
 
+RTLIL::SigSpec::SigSpec(RTLIL::SigBit bit, int width)
+{
+	if (bit.wire == NULL)
+		chunks.push_back(RTLIL::SigChunk(bit.data, width));
+	else
+		for (int i = 0; i < width; i++)
+			chunks.push_back(RTLIL::SigChunk(bit.wire, 1, bit.offset));
+	this->width = width;
+	check();
+}
+
+RTLIL::SigSpec::SigSpec(const std::vector<RTLIL::SigBit> &bits)
+{
+	width = 0;
+	for (auto &bit : bits)
+		append_bit(bit);
+	check();
+}
+
+RTLIL::SigSpec::SigSpec(const RTLIL::SigSlice &slice)
+{
+	width = 0;
+	append(slice);
+}
+
 void RTLIL::SigSpec::expand()
 {
 	std::vector<RTLIL::SigChunk> new_chunks;
@@ -612,37 +1086,33 @@ void RTLIL::SigSpec::expand()
 
 void RTLIL::SigSpec::optimize()
 {
-	for (size_t i = 0; i < chunks.size(); i++) {
-		if (chunks[i].wire && chunks[i].wire->auto_width)
-			continue;
-		if (chunks[i].width == 0)
-			chunks.erase(chunks.begin()+i--);
-	}
-	for (size_t i = 1; i < chunks.size(); i++) {
-		RTLIL::SigChunk &ch1 = chunks[i-1];
-		RTLIL::SigChunk &ch2 = chunks[i];
-		if (ch1.wire && ch1.wire->auto_width)
-			continue;
-		if (ch2.wire && ch2.wire->auto_width)
+	size_t k = 0;
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		RTLIL::SigChunk &ch = chunks[i];
+		bool ch_auto_width = ch.wire && ch.wire->auto_width;
+		if (ch.width == 0 && !ch_auto_width)
 			continue;
-		if (ch1.wire == ch2.wire) {
-			if (ch1.wire != NULL && ch1.offset+ch1.width == ch2.offset) {
-				ch1.width += ch2.width;
-				goto merged_with_next_chunk;
-			}
-			if (ch1.wire == NULL && ch1.data.str.empty() == ch2.data.str.empty()) {
-				ch1.data.str = ch2.data.str + ch1.data.str;
-				ch1.data.bits.insert(ch1.data.bits.end(), ch2.data.bits.begin(), ch2.data.bits.end());
-				ch1.width += ch2.width;
-				goto merged_with_next_chunk;
+		if (k > 0 && !ch_auto_width) {
+			RTLIL::SigChunk &last = chunks[k-1];
+			if (last.wire == ch.wire && !(last.wire && last.wire->auto_width)) {
+				if (ch.wire != NULL && last.offset+last.width == ch.offset) {
+					last.width += ch.width;
+					continue;
+				}
+				if (ch.wire == NULL && last.data.str.empty() == ch.data.str.empty()) {
+					last.data.str = ch.data.str + last.data.str;
+					last.data.bits.insert(last.data.bits.end(), ch.data.bits.begin(), ch.data.bits.end());
+					last.width += ch.width;
+					continue;
+				}
 			}
 		}
-		if (0) {
-	merged_with_next_chunk:
-			chunks.erase(chunks.begin()+i);
-			i--;
-		}
+		if (k != i)
+			chunks[k] = std::move(ch);
+		k++;
 	}
+	chunks.resize(k);
 	check();
 }
 
@@ -707,7 +1177,7 @@ restart:
 					int upper = std::min(ch1.offset + ch1.width, ch2.offset + ch2.width);
 					if (lower < upper) {
 						restart_pos = pos+upper-ch1.offset;
-						other->replace(pos+lower-ch1.offset, with.extract(poff+lower-ch2.offset, upper-lower));
+						other->replace(pos+lower-ch1.offset, with.slice(poff+lower-ch2.offset, upper-lower));
 						goto restart;
 					}
 				}
@@ -775,9 +1245,9 @@ RTLIL::SigSpec RTLIL::SigSpec::extract(RTLIL::SigSpec pattern, RTLIL::SigSpec *o
 					int upper = std::min(ch1.offset + ch1.width, ch2.offset + ch2.width);
 					if (lower < upper) {
 						if (other)
-							ret.append(other->extract(pos+lower-ch1.offset, upper-lower));
+							ret.append(other->slice(pos+lower-ch1.offset, upper-lower));
 						else
-							ret.append(extract(pos+lower-ch1.offset, upper-lower));
+							ret.append(slice(pos+lower-ch1.offset, upper-lower));
 					}
 				}
 			}
@@ -809,6 +1279,30 @@ void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSpec &with)
 	check();
 }
 
+void RTLIL::SigSpec::replace(int offset, const RTLIL::SigSlice &with)
+{
+	if (with.sig == this) {
+		replace(offset, RTLIL::SigSpec(with));
+		return;
+	}
+	int pos = 0;
+	assert(offset >= 0);
+	assert(offset+with.width <= width);
+	remove(offset, with.width);
+	size_t i = 0;
+	while (i < chunks.size() && pos != offset)
+		pos += chunks[i++].width;
+	assert(pos == offset);
+	std::vector<RTLIL::SigChunk> tail(std::make_move_iterator(chunks.begin()+i), std::make_move_iterator(chunks.end()));
+	chunks.resize(i);
+	int tail_width = width - offset;
+	width = offset;
+	append(with);
+	chunks.insert(chunks.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+	width += tail_width;
+	check();
+}
+
 void RTLIL::SigSpec::remove_const()
 {
 	for (size_t i = 0; i < chunks.size(); i++) {
@@ -861,33 +1355,16 @@ void RTLIL::SigSpec::remove(int offset, int length)
 
 RTLIL::SigSpec RTLIL::SigSpec::extract(int offset, int length) const
 {
-	int pos = 0;
 	RTLIL::SigSpec ret;
-	assert(offset >= 0);
-	assert(length >= 0);
-	assert(offset+length <= width);
-	for (size_t i = 0; i < chunks.size(); i++) {
-		if (pos+chunks[i].width > offset && pos < offset+length) {
-			int off = offset - pos;
-			int len = length;
-			if (off < 0) {
-				len += off;
-				off = 0;
-			}
-			if (len > chunks[i].width-off)
-				len = chunks[i].width-off;
-			ret.chunks.push_back(chunks[i].extract(off, len));
-			ret.width += len;
-			offset += len;
-			length -= len;
-		}
-		pos += chunks[i].width;
-	}
-	assert(length == 0);
-	ret.check();
+	ret.append(slice(offset, length));
 	return ret;
 }
 
+RTLIL::SigSlice RTLIL::SigSpec::slice(int offset, int length) const
+{
+	return RTLIL::SigSlice(*this, offset, length);
+}
+
 void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 {
 	for (size_t i = 0; i < signal.chunks.size(); i++) {
@@ -897,6 +1374,51 @@ void RTLIL::SigSpec::append(const RTLIL::SigSpec &signal)
 	check();
 }
 
+void RTLIL::SigSpec::append(const RTLIL::SigSlice &slice)
+{
+	if (slice.sig == this) {
+		append(RTLIL::SigSpec(slice));
+		return;
+	}
+	int pos = 0, offset = slice.offset, length = slice.width;
+	const std::vector<RTLIL::SigChunk> &src = slice.sig->chunks;
+	for (size_t i = 0; i < src.size() && length > 0; i++) {
+		if (pos+src[i].width > offset) {
+			int off = offset - pos;
+			int len = std::min(length, src[i].width-off);
+			chunks.push_back(src[i].extract(off, len));
+			width += len;
+			offset += len;
+			length -= len;
+		}
+		pos += src[i].width;
+	}
+	assert(length == 0);
+	check();
+}
+
+// like append() followed by optimize(), but without re-scanning the chunk list
+void RTLIL::SigSpec::append_bit(const RTLIL::SigBit &bit)
+{
+	if (chunks.size() > 0) {
+		RTLIL::SigChunk &last = chunks.back();
+		if (bit.wire == NULL && last.wire == NULL && last.data.str.empty()) {
+			last.data.bits.push_back(bit.data);
+			last.width++, width++;
+			return;
+		}
+		if (bit.wire != NULL && last.wire == bit.wire && !bit.wire->auto_width && last.offset+last.width == bit.offset) {
+			last.width++, width++;
+			return;
+		}
+	}
+	if (bit.wire == NULL)
+		chunks.push_back(RTLIL::SigChunk(bit.data));
+	else
+		chunks.push_back(RTLIL::SigChunk(bit.wire, 1, bit.offset));
+	width++;
+}
+
 bool RTLIL::SigSpec::combine(RTLIL::SigSpec signal, RTLIL::State freeState, bool override)
 {
 	bool no_collisions = true;
@@ -944,7 +1466,7 @@ void RTLIL::SigSpec::check() const
 {
 	int w = 0;
 	for (size_t i = 0; i < chunks.size(); i++) {
-		const RTLIL::SigChunk chunk = chunks[i];
+		const RTLIL::SigChunk &chunk = chunks[i];
 		if (chunk.wire == NULL) {
 			assert(chunk.offset == 0);
 			assert(chunk.data.bits.size() == (size_t)chunk.width);
@@ -1014,6 +1536,14 @@ bool RTLIL::SigSpec::is_fully_const() const
 	return true;
 }
 
+bool RTLIL::SigSlice::is_fully_const() const
+{
+	for (auto bit : *this)
+		if (bit.wire != NULL)
+			return false;
+	return true;
+}
+
 bool RTLIL::SigSpec::is_fully_def() const
 {
 	for (auto it = chunks.begin(); it != chunks.end(); it++) {
@@ -1093,6 +1623,25 @@ RTLIL::Const RTLIL::SigSpec::as_const() const
 	return RTLIL::Const();
 }
 
+RTLIL::SigBit RTLIL::SigSpec::as_bit() const
+{
+	assert(width == 1);
+	size_t i = 0;
+	while (chunks[i].width == 0)
+		i++;
+	return RTLIL::SigBit(chunks[i]);
+}
+
+std::vector<RTLIL::SigBit> RTLIL::SigSpec::to_sigbit_vector() const
+{
+	std::vector<RTLIL::SigBit> bits;
+	bits.reserve(width);
+	for (auto &chunk : chunks)
+		for (int i = 0; i < chunk.width; i++)
+			bits.push_back(RTLIL::SigBit(chunk, i));
+	return bits;
+}
+
 bool RTLIL::SigSpec::match(std::string pattern) const
 {
 	std::string str = as_string();
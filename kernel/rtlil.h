@@ -24,7 +24,13 @@
 #include <set>
 #include <vector>
 #include <string>
+#include <atomic>
+#include <stdexcept>
 #include <assert.h>
+#include <string.h>
+
+#include "kernel/hashlib.h"
+#include "kernel/arena.h"
 
 std::string stringf(const char *fmt, ...);
 
@@ -47,17 +53,22 @@ namespace RTLIL
 		STa = 5  // always active
 	};
 
-	extern int autoidx;
+	extern std::atomic<int> autoidx;
 
 	struct Const;
+	struct IdSet;
 	struct Selection;
 	struct Design;
+	struct Monitor;
+	struct CachedData;
 	struct Module;
 	struct Wire;
 	struct Memory;
 	struct Cell;
 	struct SigChunk;
+	struct SigBit;
 	struct SigSpec;
+	struct SigSlice;
 	struct CaseRule;
 	struct SwitchRule;
 	struct SyncRule;
@@ -65,36 +76,119 @@ namespace RTLIL
 
 	typedef std::pair<SigSpec, SigSpec> SigSig;
 
-#ifdef NDEBUG
-	typedef std::string IdString;
-#else
-	struct IdString : public std::string {
-		IdString() { }
-		IdString(std::string str) : std::string(str) {
+	// IdStrings are interned in a global string pool. An IdString object is
+	// just a 32 bit index into this pool, so copying, comparing for equality
+	// and hashing are O(1) operations (see rtlil.cc for the implementation
+	// of the pool).
+	//
+	// The characters of the names are stored NUL terminated in large char
+	// blocks, and the pool maps each index to the name and its length in
+	// fixed size chunks. Neither are ever moved, so c_str() and size() can be
+	// called without locking while other threads add new strings. str()
+	// returns a copy of the name as std::string.
+	//
+	// Strings are never removed from the pool, even when no IdString refers
+	// to them anymore. Each name costs its length plus one byte in the char
+	// blocks, 16 bytes in the chunks and its share of the hash index used
+	// for the lookup (roughly 60 bytes), for the rest of the process lifetime.
+	// So a script that keeps creating temporary names (e.g. NEW_ID in
+	// passes that are run in a loop) grows the pool without bound.
+	struct IdString
+	{
+		enum { CHUNK_BITS = 12, CHUNK_SIZE = 1 << CHUNK_BITS, MAX_CHUNKS = 1 << 16 };
+		struct entry_t {
+			const char *str;
+			size_t len;
+		};
+		static entry_t *global_id_storage[MAX_CHUNKS];
+		static int get_index(const char *str);
+		static int get_index(const std::string &str) { return get_index(str.c_str()); }
+
+		int index_;
+
+		IdString() : index_(0) { }
+		IdString(const char *str) : index_(get_index(str)) {
 			check();
 		}
-		IdString(const char *s) : std::string(s) {
+		IdString(const std::string &str) : index_(get_index(str)) {
 			check();
 		}
-		IdString &operator=(const std::string &str) {
-			std::string::operator=(str);
-			check();
-			return *this;
+
+		const entry_t &entry() const {
+			return global_id_storage[index_ >> CHUNK_BITS][index_ & (CHUNK_SIZE-1)];
 		}
-		IdString &operator=(const char *s) {
-			std::string::operator=(s);
-			check();
-			return *this;
+		std::string str() const {
+			return std::string(entry().str, entry().len);
+		}
+		operator std::string() const {
+			return str();
+		}
+		const char *c_str() const {
+			return entry().str;
+		}
+
+		size_t size() const { return entry().len; }
+		size_t length() const { return entry().len; }
+		bool empty() const { return index_ == 0; }
+		char operator[](size_t i) const { return c_str()[i]; }
+		char at(size_t i) const {
+			if (i >= size())
+				throw std::out_of_range("RTLIL::IdString::at");
+			return c_str()[i];
+		}
+		const char *begin() const { return c_str(); }
+		const char *end() const { return c_str() + size(); }
+
+		std::string substr(size_t pos = 0, size_t len = std::string::npos) const { return str().substr(pos, len); }
+		size_t find(const std::string &s, size_t pos = 0) const {
+			const char *p = pos <= size() ? strstr(c_str() + pos, s.c_str()) : NULL;
+			return p ? p - c_str() : std::string::npos;
 		}
-		bool operator<(const IdString &rhs) {
-			check(), rhs.check();
-			return std::string(*this) < std::string(rhs);
+		size_t find(char c, size_t pos = 0) const {
+			const char *p = pos < size() ? (const char*)memchr(c_str() + pos, c, size() - pos) : NULL;
+			return p ? p - c_str() : std::string::npos;
 		}
+		size_t rfind(const std::string &s, size_t pos = std::string::npos) const { return str().rfind(s, pos); }
+		size_t rfind(char c, size_t pos = std::string::npos) const {
+			for (size_t i = std::min(pos, size()-1) + 1; size() > 0 && i > 0; i--)
+				if (c_str()[i-1] == c)
+					return i-1;
+			return std::string::npos;
+		}
+		size_t find_first_of(const std::string &s, size_t pos = 0) const { return str().find_first_of(s, pos); }
+		size_t find_last_of(const std::string &s, size_t pos = std::string::npos) const { return str().find_last_of(s, pos); }
+		int compare(size_t pos, size_t len, const std::string &s) const { return str().compare(pos, len, s); }
+
+		bool operator==(const IdString &rhs) const { return index_ == rhs.index_; }
+		bool operator!=(const IdString &rhs) const { return index_ != rhs.index_; }
+		bool operator==(const std::string &rhs) const { return size() == rhs.size() && memcmp(c_str(), rhs.data(), size()) == 0; }
+		bool operator!=(const std::string &rhs) const { return !(*this == rhs); }
+		bool operator==(const char *rhs) const { return strcmp(c_str(), rhs) == 0; }
+		bool operator!=(const char *rhs) const { return strcmp(c_str(), rhs) != 0; }
+
+		// ordering is by string value (not by index) so that iterating over
+		// std::map<IdString, ...> containers stays deterministic
+		bool operator<(const IdString &rhs) const {
+			return index_ != rhs.index_ && strcmp(c_str(), rhs.c_str()) < 0;
+		}
+
+		unsigned int hash() const {
+			return index_;
+		}
+
 		void check() const {
 			assert(empty() || (size() >= 2 && (at(0) == '$' || at(0) == '\\')));
 		}
 	};
-#endif
+
+	static inline std::string operator+(const IdString &a, const std::string &b) { return a.str() + b; }
+	static inline std::string operator+(const IdString &a, const char *b) { return a.str() + b; }
+	static inline std::string operator+(const std::string &a, const IdString &b) { return a + b.str(); }
+	static inline std::string operator+(const char *a, const IdString &b) { return a + b.str(); }
+	static inline bool operator==(const std::string &a, const IdString &b) { return b == a; }
+	static inline bool operator!=(const std::string &a, const IdString &b) { return b != a; }
+	static inline bool operator==(const char *a, const IdString &b) { return b == a; }
+	static inline bool operator!=(const char *a, const IdString &b) { return b != a; }
 
 	static IdString escape_id(std::string str) __attribute__((unused));
 	static IdString escape_id(std::string str) {
@@ -110,24 +204,45 @@ namespace RTLIL
 		return str;
 	}
 
-	static const char *id2cstr(std::string str) __attribute__((unused));
-	static const char *id2cstr(std::string str) {
+	static const char *id2cstr(const std::string &str) __attribute__((unused));
+	static const char *id2cstr(const std::string &str) {
 		if (str.size() > 1 && str[0] == '\\' && str[1] != '$')
 			return str.c_str() + 1;
 		return str.c_str();
 	}
 
-	static IdString new_id(std::string file, int line, std::string func) __attribute__((unused));
-	static IdString new_id(std::string file, int line, std::string func) {
-		std::string str = "$auto$";
-		size_t pos = file.find_last_of('/');
-		str += pos != std::string::npos ? file.substr(pos+1) : file;
-		str += stringf(":%d:%s$%d", line, func.c_str(), autoidx++);
-		return str;
+	static const char *id2cstr(const RTLIL::IdString &str) __attribute__((unused));
+	static const char *id2cstr(const RTLIL::IdString &str) {
+		if (str.size() > 1 && str[0] == '\\' && str[1] != '$')
+			return str.c_str() + 1;
+		return str.c_str();
 	}
 
-#define NEW_ID \
-	RTLIL::new_id(__FILE__, __LINE__, __FUNCTION__)
+	// NEW_ID creates names of the form "$auto$<file>:<line>:<func>$<n>". The
+	// "$auto$<file>:<line>:<func>$" prefix is formatted only once per call
+	// site and <n> is taken from the global autoidx counter.
+	//
+	// Code that runs for several modules in parallel installs a NewIdScope
+	// for each module (see Pass::execute_modules()). While a scope is active
+	// in a thread, <n> is "<base>.<k>" with a per-scope counter k instead, so
+	// the generated names do not depend on the order in which the modules
+	// are processed by the threads.
+	struct NewIdScope
+	{
+		static thread_local NewIdScope *current;
+		NewIdScope *outer;
+		int base, counter;
+
+		NewIdScope(int base) : outer(current), base(base), counter(0) { current = this; }
+		~NewIdScope() { current = outer; }
+	};
+
+	std::string new_id_prefix(const char *file, int line, const char *func);
+	IdString new_id(const std::string &prefix);
+
+#define NEW_ID ({ \
+	static const std::string _new_id_prefix = RTLIL::new_id_prefix(__FILE__, __LINE__, __FUNCTION__); \
+	RTLIL::new_id(_new_id_prefix); })
 
 #define NEW_WIRE(_mod, _width) \
 	(_mod)->new_wire(_width, NEW_ID)
@@ -138,6 +253,12 @@ namespace RTLIL
 		}
 	};
 
+	// copy of a container keyed by name (wires, cells, connections, attributes, ..)
+	// in the order of the names, for output that must not depend on insertion order
+	template <typename C> std::map<typename C::key_type, typename C::mapped_type> sorted_by_name(const C &container) {
+		return std::map<typename C::key_type, typename C::mapped_type>(container.begin(), container.end());
+	}
+
 	// see calc.cc for the implementation of this functions
 	RTLIL::Const const_not         (const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len);
 	RTLIL::Const const_and         (const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len);
@@ -193,10 +314,64 @@ struct RTLIL::Const {
 	std::string as_string() const;
 };
 
+// A set of IdStrings stored as a bitmap over the IdString indices, so that
+// count(), insert() and erase() are O(1) and the set operations work on whole
+// words. The bitmap is split in pages that are only allocated when an id in
+// their range is inserted. Iteration is in index order, sorted() returns the
+// ids ordered by name (e.g. for printing).
+struct RTLIL::IdSet {
+	enum { PAGE_BITS = 12, PAGE_WORDS = (1 << PAGE_BITS) / 64 };
+	std::vector<uint64_t*> pages;
+	size_t size_;
+
+	struct const_iterator {
+		const RTLIL::IdSet *set;
+		int index;
+		const_iterator(const RTLIL::IdSet *set, int index) : set(set), index(index) { }
+		RTLIL::IdString operator*() const { RTLIL::IdString id; id.index_ = index; return id; }
+		const_iterator &operator++() { index = set->next(index + 1); return *this; }
+		bool operator==(const const_iterator &other) const { return index == other.index; }
+		bool operator!=(const const_iterator &other) const { return index != other.index; }
+	};
+
+	IdSet() : size_(0) { }
+	IdSet(const RTLIL::IdSet &other);
+	IdSet(RTLIL::IdSet &&other);
+	~IdSet();
+	RTLIL::IdSet &operator=(const RTLIL::IdSet &other);
+	RTLIL::IdSet &operator=(RTLIL::IdSet &&other);
+
+	size_t count(RTLIL::IdString id) const {
+		size_t page = id.index_ >> PAGE_BITS;
+		if (page >= pages.size() || pages[page] == NULL)
+			return 0;
+		return (pages[page][(id.index_ >> 6) & (PAGE_WORDS-1)] >> (id.index_ & 63)) & 1;
+	}
+	bool insert(RTLIL::IdString id);
+	size_t erase(RTLIL::IdString id);
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+	void clear();
+	void swap(RTLIL::IdSet &other);
+
+	RTLIL::IdSet &operator|=(const RTLIL::IdSet &other);
+	RTLIL::IdSet &operator&=(const RTLIL::IdSet &other);
+	RTLIL::IdSet &operator-=(const RTLIL::IdSet &other);
+	bool operator==(const RTLIL::IdSet &other) const;
+	bool operator!=(const RTLIL::IdSet &other) const { return !(*this == other); }
+
+	int next(int index) const;
+	const_iterator begin() const { return const_iterator(this, next(0)); }
+	const_iterator end() const { return const_iterator(this, -1); }
+	std::vector<RTLIL::IdString> sorted() const;
+};
+
+// A selection is either the full design or a set of whole modules plus a set
+// of selected members for each partially selected module.
 struct RTLIL::Selection {
 	bool full_selection;
-	std::set<RTLIL::IdString> selected_modules;
-	std::map<RTLIL::IdString, std::set<RTLIL::IdString>> selected_members;
+	RTLIL::IdSet selected_modules;
+	hashlib::dict<RTLIL::IdString, RTLIL::IdSet> selected_members;
 	Selection(bool full = true) : full_selection(full) { }
 	bool selected_module(RTLIL::IdString mod_name) const;
 	bool selected_whole_module(RTLIL::IdString mod_name) const;
@@ -213,7 +388,11 @@ struct RTLIL::Design {
 	std::vector<RTLIL::Selection> selection_stack;
 	std::map<RTLIL::IdString, RTLIL::Selection> selection_vars;
 	std::string selected_active_module;
+	static bool arena_alloc;
 	~Design();
+	// replaces modules shared with a saved design by private copies, with
+	// selected_only set only the modules in the current selection
+	void unshare(bool selected_only = false);
 	void check();
 	void optimize();
 	bool selected_module(RTLIL::IdString mod_name) const;
@@ -236,26 +415,65 @@ struct RTLIL::Design {
 	}
 };
 
-#define RTLIL_ATTRIBUTE_MEMBERS                                \
-	std::map<RTLIL::IdString, RTLIL::Const> attributes;    \
-	void set_bool_attribute(RTLIL::IdString id) {          \
-		attributes[id] = RTLIL::Const(1);              \
-	}                                                      \
-	bool get_bool_attribute(RTLIL::IdString id) const {    \
-		if (attributes.count(id) == 0)                 \
-			return false;                          \
-		return attributes.at(id).as_bool();            \
+#define RTLIL_ATTRIBUTE_MEMBERS                                  \
+	hashlib::dict<RTLIL::IdString, RTLIL::Const> attributes; \
+	void set_bool_attribute(RTLIL::IdString id) {            \
+		attributes[id] = RTLIL::Const(1);                \
+	}                                                        \
+	bool get_bool_attribute(RTLIL::IdString id) const {      \
+		if (attributes.count(id) == 0)                   \
+			return false;                            \
+		return attributes.at(id).as_bool();              \
 	}
 
+// A Monitor is attached to a module and is notified about the changes made to
+// the module through the Module::add(), Module::remove(), Module::connect(),
+// Module::disconnect() and Module::retype() methods. Code that modifies a
+// module directly must call notify_blackout() on the module afterwards, so the
+// monitors and the cached data can resync.
+struct RTLIL::Monitor {
+	virtual ~Monitor() { }
+	virtual void notify_add(RTLIL::Cell*) { }
+	virtual void notify_remove(RTLIL::Cell*) { }
+	virtual void notify_connect(RTLIL::Cell*, RTLIL::IdString, const RTLIL::SigSpec&, const RTLIL::SigSpec&) { }
+	virtual void notify_connect(RTLIL::Module*, const RTLIL::SigSig&) { }
+	virtual void notify_blackout(RTLIL::Module*) { }
+	virtual void notify_delete(RTLIL::Module*) { }
+};
+
+// Data derived from a module (like a SigMap) that is kept in a cache slot of
+// the module and reused by later passes, see Module::get_cached(). When the
+// module was modified since the data was built, revalidate() is asked if the
+// data is still up to date before it is thrown away and rebuilt.
+struct RTLIL::CachedData {
+	unsigned int epoch;
+	CachedData() : epoch(0) { }
+	virtual ~CachedData() { }
+	virtual bool revalidate(RTLIL::Module*) { return false; }
+};
+
 struct RTLIL::Module {
 	RTLIL::IdString name;
-	std::map<RTLIL::IdString, RTLIL::Wire*> wires;
-	std::map<RTLIL::IdString, RTLIL::Memory*> memories;
-	std::map<RTLIL::IdString, RTLIL::Cell*> cells;
-	std::map<RTLIL::IdString, RTLIL::Process*> processes;
+	hashlib::dict<RTLIL::IdString, RTLIL::Wire*> wires;
+	hashlib::dict<RTLIL::IdString, RTLIL::Memory*> memories;
+	hashlib::dict<RTLIL::IdString, RTLIL::Cell*> cells;
+	hashlib::dict<RTLIL::IdString, RTLIL::Process*> processes;
 	std::vector<RTLIL::SigSig> connections;
 	RTLIL_ATTRIBUTE_MEMBERS
+	Arena *arena;
+	std::set<RTLIL::Monitor*> monitors;
+	int share_count;
+	// modification counter, incremented by the Module API and notify_blackout()
+	unsigned int epoch;
+	// incremented by notify_blackout() and rewrite_sigspecs(), i.e. when the
+	// module connections may have changed other than by connect(SigSig) adding
+	// a new connection at the end
+	unsigned int connections_epoch;
+	std::vector<RTLIL::CachedData*> cache_slots;
+	Module();
 	virtual ~Module();
+	RTLIL::Module *share();
+	void release();
 	virtual RTLIL::IdString derive(RTLIL::Design *design, std::map<RTLIL::IdString, RTLIL::Const> parameters);
 	virtual void update_auto_wires(std::map<RTLIL::IdString, int> auto_sizes);
 	virtual size_t count_id(RTLIL::IdString id);
@@ -264,15 +482,49 @@ struct RTLIL::Module {
 	RTLIL::Wire *new_wire(int width, RTLIL::IdString name);
 	void add(RTLIL::Wire *wire);
 	void add(RTLIL::Cell *cell);
+	void remove(RTLIL::Cell *cell);
+
+	void connect(const RTLIL::SigSig &conn);
+	void connect(RTLIL::Cell *cell, RTLIL::IdString port, const RTLIL::SigSpec &sig);
+	void disconnect(RTLIL::Cell *cell, RTLIL::IdString port);
+	// monitors see a type change as removing and re-adding the cell
+	void retype(RTLIL::Cell *cell, RTLIL::IdString type);
+	void notify_blackout();
+
+	RTLIL::Wire *addWire(RTLIL::IdString name, int width = 1);
+	RTLIL::Wire *addWire(RTLIL::IdString name, const RTLIL::Wire *other);
+	RTLIL::Cell *addCell(RTLIL::IdString name, RTLIL::IdString type);
+	RTLIL::Cell *addCell(RTLIL::IdString name, const RTLIL::Cell *other);
 	void fixup_ports();
 
 	template<typename T> void rewrite_sigspecs(T functor);
 	void cloneInto(RTLIL::Module *new_mod) const;
 	virtual RTLIL::Module *clone() const;
 
+	// returns the data in the given cache slot, (re)built as T(module) if it
+	// is missing or out of date. The returned object stays valid until the
+	// next get_cached() call for the same slot after the module was modified.
+	static int new_cache_slot();
+	template<typename T> T *get_cached(int slot) {
+		if (slot >= int(cache_slots.size()))
+			cache_slots.resize(slot + 1, NULL);
+		RTLIL::CachedData *&data = cache_slots[slot];
+		if (data != NULL && data->epoch != epoch) {
+			if (data->revalidate(this))
+				data->epoch = epoch;
+			else
+				delete data, data = NULL;
+		}
+		if (data == NULL) {
+			data = new T(this);
+			data->epoch = epoch;
+		}
+		return static_cast<T*>(data);
+	}
+
 };
 
-struct RTLIL::Wire {
+struct RTLIL::Wire : ArenaObject {
 	RTLIL::IdString name;
 	int width, start_offset, port_id;
 	bool port_input, port_output, auto_width;
@@ -287,17 +539,6 @@ struct RTLIL::Memory {
 	Memory();
 };
 
-struct RTLIL::Cell {
-	RTLIL::IdString name;
-	RTLIL::IdString type;
-	std::map<RTLIL::IdString, RTLIL::SigSpec> connections;
-	std::map<RTLIL::IdString, RTLIL::Const> parameters;
-	RTLIL_ATTRIBUTE_MEMBERS
-	void optimize();
-
-	template<typename T> void rewrite_sigspecs(T functor);
-};
-
 struct RTLIL::SigChunk {
 	RTLIL::Wire *wire;
 	RTLIL::Const data; // only used if wire == NULL, LSB at index 0
@@ -315,9 +556,60 @@ struct RTLIL::SigChunk {
 	static bool compare(const RTLIL::SigChunk &a, const RTLIL::SigChunk &b);
 };
 
+// a single bit of a signal: either bit 'offset' of 'wire' or the constant 'data'
+struct RTLIL::SigBit {
+	RTLIL::Wire *wire;
+	RTLIL::State data;
+	int offset;
+	SigBit() : wire(NULL), data(RTLIL::State::S0), offset(0) { }
+	SigBit(RTLIL::State bit) : wire(NULL), data(bit), offset(0) { }
+	SigBit(RTLIL::Wire *wire, int offset) : wire(wire), data(RTLIL::State::S0), offset(offset) { }
+	explicit SigBit(const RTLIL::SigChunk &chunk, int index = 0) {
+		wire = chunk.wire;
+		data = wire ? RTLIL::State::S0 : chunk.data.bits[index];
+		offset = wire ? chunk.offset + index : 0;
+	}
+	bool operator <(const RTLIL::SigBit &other) const {
+		if (wire != other.wire) {
+			if (wire == NULL || other.wire == NULL)
+				return wire < other.wire;
+			if (wire->name != other.wire->name)
+				return wire->name < other.wire->name;
+			return wire < other.wire;
+		}
+		return wire ? offset < other.offset : data < other.data;
+	}
+	bool operator ==(const RTLIL::SigBit &other) const {
+		return wire == other.wire && (wire ? offset == other.offset : data == other.data);
+	}
+	bool operator !=(const RTLIL::SigBit &other) const {
+		return !(*this == other);
+	}
+	unsigned int hash() const {
+		return wire ? hashlib::mkhash(wire->name.hash(), offset) : (unsigned int)data;
+	}
+};
+
 struct RTLIL::SigSpec {
 	std::vector<RTLIL::SigChunk> chunks; // LSB at index 0
 	int width;
+
+	// iterates over the bits of a signal without expanding it
+	struct const_iterator {
+		const std::vector<RTLIL::SigChunk> *chunks;
+		size_t chunk_idx;
+		int bit_idx;
+		const_iterator(const std::vector<RTLIL::SigChunk> *chunks, size_t chunk_idx) : chunks(chunks), chunk_idx(chunk_idx), bit_idx(0) { skip(); }
+		void skip() {
+			while (chunk_idx < chunks->size() && bit_idx >= (*chunks)[chunk_idx].width)
+				chunk_idx++, bit_idx = 0;
+		}
+		const_iterator &operator++() { bit_idx++; skip(); return *this; }
+		bool operator==(const const_iterator &other) const { return chunk_idx == other.chunk_idx && bit_idx == other.bit_idx; }
+		bool operator!=(const const_iterator &other) const { return !(*this == other); }
+		RTLIL::SigBit operator*() const { return RTLIL::SigBit((*chunks)[chunk_idx], bit_idx); }
+	};
+
 	SigSpec();
 	SigSpec(const RTLIL::Const &data);
 	SigSpec(const RTLIL::SigChunk &chunk);
@@ -325,6 +617,12 @@ struct RTLIL::SigSpec {
 	SigSpec(const std::string &str);
 	SigSpec(int val, int width = 32);
 	SigSpec(RTLIL::State bit, int width = 1);
+	SigSpec(RTLIL::SigBit bit, int width = 1);
+	SigSpec(const std::vector<RTLIL::SigBit> &bits);
+	explicit SigSpec(const RTLIL::SigSlice &slice);
+	const_iterator begin() const { return const_iterator(&chunks, 0); }
+	const_iterator end() const { return const_iterator(&chunks, chunks.size()); }
+	const_iterator iterator_at(int offset) const;
 	void expand();
 	void optimize();
 	void sort();
@@ -336,10 +634,14 @@ struct RTLIL::SigSpec {
 	void remove2(const RTLIL::SigSpec &pattern, RTLIL::SigSpec *other);
 	RTLIL::SigSpec extract(RTLIL::SigSpec pattern, RTLIL::SigSpec *other = NULL) const;
 	void replace(int offset, const RTLIL::SigSpec &with);
+	void replace(int offset, const RTLIL::SigSlice &with);
 	void remove_const();
 	void remove(int offset, int length);
 	RTLIL::SigSpec extract(int offset, int length) const;
+	RTLIL::SigSlice slice(int offset, int length) const;
 	void append(const RTLIL::SigSpec &signal);
+	void append(const RTLIL::SigSlice &slice);
+	void append_bit(const RTLIL::SigBit &bit);
 	bool combine(RTLIL::SigSpec signal, RTLIL::State freeState = RTLIL::State::Sz, bool override = false);
 	void extend(int width, bool is_signed = false);
 	void check() const;
@@ -354,10 +656,48 @@ struct RTLIL::SigSpec {
 	int as_int() const;
 	std::string as_string() const;
 	RTLIL::Const as_const() const;
+	RTLIL::SigBit as_bit() const;
+	std::vector<RTLIL::SigBit> to_sigbit_vector() const;
 	bool match(std::string pattern) const;
 	static bool parse(RTLIL::SigSpec &sig, RTLIL::Module *module, std::string str);
 };
 
+// a read-only view of the bits offset .. offset+width-1 of a SigSpec that
+// does not copy any chunks. The SigSpec must not be modified or destroyed
+// while the slice is in use. Use SigSpec(slice) to get a copy of the bits.
+struct RTLIL::SigSlice {
+	const RTLIL::SigSpec *sig;
+	int offset, width;
+	SigSlice(const RTLIL::SigSpec &sig) : sig(&sig), offset(0), width(sig.width) { }
+	SigSlice(const RTLIL::SigSpec &sig, int offset, int width) : sig(&sig), offset(offset), width(width) {
+		assert(offset >= 0 && width >= 0 && offset+width <= sig.width);
+	}
+	RTLIL::SigSpec::const_iterator begin() const { return sig->iterator_at(offset); }
+	RTLIL::SigSpec::const_iterator end() const { return sig->iterator_at(offset + width); }
+	bool is_fully_const() const;
+};
+
+inline RTLIL::SigSpec::const_iterator RTLIL::SigSpec::iterator_at(int offset) const
+{
+	size_t i = 0;
+	while (i < chunks.size() && offset >= chunks[i].width)
+		offset -= chunks[i++].width;
+	const_iterator it(&chunks, i);
+	it.bit_idx = offset;
+	return it;
+}
+
+struct RTLIL::Cell : ArenaObject {
+	RTLIL::IdString name;
+	RTLIL::IdString type;
+	hashlib::flat_dict<RTLIL::IdString, RTLIL::SigSpec, 4> connections;
+	hashlib::flat_dict<RTLIL::IdString, RTLIL::Const, 1> parameters;
+	RTLIL_ATTRIBUTE_MEMBERS
+	void optimize();
+
+	template<typename T> void rewrite_sigspecs(T functor);
+};
+
 struct RTLIL::CaseRule {
 	std::vector<RTLIL::SigSpec> compare;
 	std::vector<RTLIL::SigSig> actions;
@@ -405,6 +745,8 @@ struct RTLIL::Process {
 template<typename T>
 void RTLIL::Module::rewrite_sigspecs(T functor)
 {
+	epoch++;
+	connections_epoch++;
 	for (auto &it : cells)
 		it.second->rewrite_sigspecs(functor);
 	for (auto &it : processes)
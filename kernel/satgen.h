@@ -58,18 +58,17 @@ struct SatGen
 		assert(timestep < 0 || timestep > 0);
 		RTLIL::SigSpec s = sig;
 		sigmap->apply(s);
-		s.expand();
 
 		std::vector<int> vec;
-		vec.reserve(s.chunks.size());
+		vec.reserve(s.width);
 
-		for (auto &c : s.chunks)
-			if (c.wire == NULL) {
-				vec.push_back(c.data.as_bool() ? ez->TRUE : ez->FALSE);
+		for (auto bit : s)
+			if (bit.wire == NULL) {
+				vec.push_back(bit.data == RTLIL::State::S1 ? ez->TRUE : ez->FALSE);
 			} else {
 				std::string name = prefix;
 				name += timestep == -1 ? "" : stringf("@%d:", timestep);
-				name += stringf(c.wire->width == 1 ?  "%s" : "%s [%d]", RTLIL::id2cstr(c.wire->name), c.offset);
+				name += stringf(bit.wire->width == 1 ?  "%s" : "%s [%d]", RTLIL::id2cstr(bit.wire->name), bit.offset);
 				vec.push_back(ez->literal(name));
 			}
 		return vec;
@@ -104,29 +103,31 @@ struct SatGen
 
 	bool importCell(RTLIL::Cell *cell, int timestep = -1)
 	{
-		if (cell->type == "$_AND_" || cell->type == "$_OR_" || cell->type == "$_XOR_" ||
-				cell->type == "$and" || cell->type == "$or" || cell->type == "$xor" || cell->type == "$xnor" ||
-				cell->type == "$add" || cell->type == "$sub") {
+		CellTypeId type = cell_type_id(cell->type);
+
+		if (type == CT__AND_ || type == CT__OR_ || type == CT__XOR_ ||
+				type == CT_and || type == CT_or || type == CT_xor || type == CT_xnor ||
+				type == CT_add || type == CT_sub) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
 			extendSignalWidth(a, b, y, cell);
-			if (cell->type == "$and" || cell->type == "$_AND_")
+			if (type == CT_and || type == CT__AND_)
 				ez->assume(ez->vec_eq(ez->vec_and(a, b), y));
-			if (cell->type == "$or" || cell->type == "$_OR_")
+			if (type == CT_or || type == CT__OR_)
 				ez->assume(ez->vec_eq(ez->vec_or(a, b), y));
-			if (cell->type == "$xor" || cell->type == "$_XOR_")
+			if (type == CT_xor || type == CT__XOR_)
 				ez->assume(ez->vec_eq(ez->vec_xor(a, b), y));
-			if (cell->type == "$xnor")
+			if (type == CT_xnor)
 				ez->assume(ez->vec_eq(ez->vec_not(ez->vec_xor(a, b)), y));
-			if (cell->type == "$add")
+			if (type == CT_add)
 				ez->assume(ez->vec_eq(ez->vec_add(a, b), y));
-			if (cell->type == "$sub")
+			if (type == CT_sub)
 				ez->assume(ez->vec_eq(ez->vec_sub(a, b), y));
 			return true;
 		}
 
-		if (cell->type == "$_INV_" || cell->type == "$not") {
+		if (type == CT__INV_ || type == CT_not) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
 			extendSignalWidthUnary(a, y, cell);
@@ -134,7 +135,7 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$_MUX_" || cell->type == "$mux") {
+		if (type == CT__MUX_ || type == CT_mux) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> s = importSigSpec(cell->connections.at("\\S"), timestep);
@@ -143,7 +144,7 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$pmux" || cell->type == "$safe_pmux") {
+		if (type == CT_pmux || type == CT_safe_pmux) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> s = importSigSpec(cell->connections.at("\\S"), timestep);
@@ -153,17 +154,17 @@ struct SatGen
 				std::vector<int> part_of_b(b.begin()+i*a.size(), b.begin()+(i+1)*a.size());
 				tmp = ez->vec_ite(s.at(i), part_of_b, tmp);
 			}
-			if (cell->type == "$safe_pmux")
+			if (type == CT_safe_pmux)
 				tmp = ez->vec_ite(ez->onehot(s, true), tmp, a);
 			ez->assume(ez->vec_eq(tmp, y));
 			return true;
 		}
 
-		if (cell->type == "$pos" || cell->type == "$neg") {
+		if (type == CT_pos || type == CT_neg) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
 			extendSignalWidthUnary(a, y, cell);
-			if (cell->type == "$pos") {
+			if (type == CT_pos) {
 				ez->assume(ez->vec_eq(a, y));
 			} else {
 				std::vector<int> zero(a.size(), ez->FALSE);
@@ -172,30 +173,30 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$reduce_and" || cell->type == "$reduce_or" || cell->type == "$reduce_xor" ||
-				cell->type == "$reduce_xnor" || cell->type == "$reduce_bool" || cell->type == "$logic_not") {
+		if (type == CT_reduce_and || type == CT_reduce_or || type == CT_reduce_xor ||
+				type == CT_reduce_xnor || type == CT_reduce_bool || type == CT_logic_not) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
-			if (cell->type == "$reduce_and")
+			if (type == CT_reduce_and)
 				ez->SET(ez->expression(ez->OpAnd, a), y.at(0));
-			if (cell->type == "$reduce_or" || cell->type == "$reduce_bool")
+			if (type == CT_reduce_or || type == CT_reduce_bool)
 				ez->SET(ez->expression(ez->OpOr, a), y.at(0));
-			if (cell->type == "$reduce_xor")
+			if (type == CT_reduce_xor)
 				ez->SET(ez->expression(ez->OpXor, a), y.at(0));
-			if (cell->type == "$reduce_xnor")
+			if (type == CT_reduce_xnor)
 				ez->SET(ez->NOT(ez->expression(ez->OpXor, a)), y.at(0));
-			if (cell->type == "$logic_not")
+			if (type == CT_logic_not)
 				ez->SET(ez->NOT(ez->expression(ez->OpOr, a)), y.at(0));
 			for (size_t i = 1; i < y.size(); i++)
 				ez->SET(0, y.at(0));
 			return true;
 		}
 
-		if (cell->type == "$logic_and" || cell->type == "$logic_or") {
+		if (type == CT_logic_and || type == CT_logic_or) {
 			int a = ez->expression(ez->OpOr, importSigSpec(cell->connections.at("\\A"), timestep));
 			int b = ez->expression(ez->OpOr, importSigSpec(cell->connections.at("\\B"), timestep));
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
-			if (cell->type == "$logic_and")
+			if (type == CT_logic_and)
 				ez->SET(ez->expression(ez->OpAnd, a, b), y.at(0));
 			else
 				ez->SET(ez->expression(ez->OpOr, a, b), y.at(0));
@@ -204,35 +205,35 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$lt" || cell->type == "$le" || cell->type == "$eq" || cell->type == "$ne" || cell->type == "$ge" || cell->type == "$gt") {
+		if (type == CT_lt || type == CT_le || type == CT_eq || type == CT_ne || type == CT_ge || type == CT_gt) {
 			bool is_signed = cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool();
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
 			extendSignalWidth(a, b, cell);
-			if (cell->type == "$lt")
+			if (type == CT_lt)
 				ez->SET(is_signed ? ez->vec_lt_signed(a, b) : ez->vec_lt_unsigned(a, b), y.at(0));
-			if (cell->type == "$le")
+			if (type == CT_le)
 				ez->SET(is_signed ? ez->vec_le_signed(a, b) : ez->vec_le_unsigned(a, b), y.at(0));
-			if (cell->type == "$eq")
+			if (type == CT_eq)
 				ez->SET(ez->vec_eq(a, b), y.at(0));
-			if (cell->type == "$ne")
+			if (type == CT_ne)
 				ez->SET(ez->vec_ne(a, b), y.at(0));
-			if (cell->type == "$ge")
+			if (type == CT_ge)
 				ez->SET(is_signed ? ez->vec_ge_signed(a, b) : ez->vec_ge_unsigned(a, b), y.at(0));
-			if (cell->type == "$gt")
+			if (type == CT_gt)
 				ez->SET(is_signed ? ez->vec_gt_signed(a, b) : ez->vec_gt_unsigned(a, b), y.at(0));
 			for (size_t i = 1; i < y.size(); i++)
 				ez->SET(0, y.at(0));
 			return true;
 		}
 
-		if (cell->type == "$shl" || cell->type == "$shr" || cell->type == "$sshl" || cell->type == "$sshr") {
+		if (type == CT_shl || type == CT_shr || type == CT_sshl || type == CT_sshr) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
-			char shift_left = cell->type == "$shl" || cell->type == "$sshl";
-			bool sign_extend = cell->type == "$sshr" && cell->parameters["\\A_SIGNED"].as_bool();
+			char shift_left = type == CT_shl || type == CT_sshl;
+			bool sign_extend = type == CT_sshr && cell->parameters["\\A_SIGNED"].as_bool();
 			while (y.size() < a.size())
 				y.push_back(ez->literal());
 			while (y.size() > a.size())
@@ -251,7 +252,7 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$mul") {
+		if (type == CT_mul) {
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
 			std::vector<int> y = importSigSpec(cell->connections.at("\\Y"), timestep);
@@ -268,7 +269,7 @@ struct SatGen
 			return true;
 		}
 
-		if (cell->type == "$div" || cell->type == "$mod")
+		if (type == CT_div || type == CT_mod)
 		{
 			std::vector<int> a = importSigSpec(cell->connections.at("\\A"), timestep);
 			std::vector<int> b = importSigSpec(cell->connections.at("\\B"), timestep);
@@ -301,7 +302,7 @@ struct SatGen
 			}
 
 			std::vector<int> y_tmp = ignore_div_by_zero ? y : ez->vec_var(y.size());
-			if (cell->type == "$div") {
+			if (type == CT_div) {
 				if (cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool())
 					ez->assume(ez->vec_eq(y_tmp, ez->vec_ite(ez->XOR(a.back(), b.back()), ez->vec_neg(y_u), y_u)));
 				else
@@ -317,7 +318,7 @@ struct SatGen
 				ez->assume(ez->expression(ezSAT::OpOr, b));
 			} else {
 				std::vector<int> div_zero_result;
-				if (cell->type == "$div") {
+				if (type == CT_div) {
 					if (cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool()) {
 						std::vector<int> all_ones(y.size(), ez->TRUE);
 						std::vector<int> only_first_one(y.size(), ez->FALSE);
@@ -341,7 +342,7 @@ struct SatGen
 			return true;
 		}
 
-		if (timestep > 0 && (cell->type == "$dff" || cell->type == "$_DFF_N_" || cell->type == "$_DFF_P_")) {
+		if (timestep > 0 && (type == CT_dff || type == CT__DFF_N_ || type == CT__DFF_P_)) {
 			if (timestep == 1) {
 				initial_state.add((*sigmap)(cell->connections.at("\\Q")));
 			} else {
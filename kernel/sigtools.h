@@ -24,6 +24,7 @@
 #include "kernel/log.h"
 #include <assert.h>
 #include <set>
+#include <algorithm>
 
 struct SigPool
 {
@@ -35,16 +36,16 @@ struct SigPool
 		bits.clear();
 	}
 
-	void add(RTLIL::SigSpec sig)
+	void add(const RTLIL::SigSlice &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits.insert(bit);
-		}
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits.insert(bitDef_t(bit.wire, bit.offset));
+	}
+
+	void add(const RTLIL::SigSpec &sig)
+	{
+		add(RTLIL::SigSlice(sig));
 	}
 
 	void add(const SigPool &other)
@@ -53,16 +54,11 @@ struct SigPool
 			bits.insert(bit);
 	}
 
-	void del(RTLIL::SigSpec sig)
+	void del(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits.erase(bit);
-		}
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits.erase(bitDef_t(bit.wire, bit.offset));
 	}
 
 	void del(const SigPool &other)
@@ -71,72 +67,49 @@ struct SigPool
 			bits.erase(bit);
 	}
 
-	void expand(RTLIL::SigSpec from, RTLIL::SigSpec to)
+	void expand(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
 	{
-		from.expand();
-		to.expand();
-		assert(from.chunks.size() == to.chunks.size());
-		for (size_t i = 0; i < from.chunks.size(); i++) {
-			bitDef_t bit_from(from.chunks[i].wire, from.chunks[i].offset);
-			bitDef_t bit_to(to.chunks[i].wire, to.chunks[i].offset);
-			if (bit_from.first == NULL || bit_to.first == NULL)
+		assert(from.width == to.width);
+		for (auto it_from = from.begin(), it_to = to.begin(); it_from != from.end(); ++it_from, ++it_to) {
+			RTLIL::SigBit bit_from = *it_from, bit_to = *it_to;
+			if (bit_from.wire == NULL || bit_to.wire == NULL)
 				continue;
-			if (bits.count(bit_from) > 0)
-				bits.insert(bit_to);
+			if (bits.count(bitDef_t(bit_from.wire, bit_from.offset)) > 0)
+				bits.insert(bitDef_t(bit_to.wire, bit_to.offset));
 		}
 	}
 
-	RTLIL::SigSpec extract(RTLIL::SigSpec sig)
+	RTLIL::SigSpec extract(const RTLIL::SigSpec &sig)
 	{
 		RTLIL::SigSpec result;
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			bitDef_t bit(c.wire, c.offset);
-			if (bits.count(bit) > 0)
-				result.append(c);
-		}
+		for (auto bit : sig)
+			if (bit.wire != NULL && bits.count(bitDef_t(bit.wire, bit.offset)) > 0)
+				result.append(RTLIL::SigSpec(bit));
 		return result;
 	}
 
-	RTLIL::SigSpec remove(RTLIL::SigSpec sig)
+	RTLIL::SigSpec remove(const RTLIL::SigSpec &sig)
 	{
 		RTLIL::SigSpec result;
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			bitDef_t bit(c.wire, c.offset);
-			if (bits.count(bit) == 0)
-				result.append(c);
-		}
+		for (auto bit : sig)
+			if (bit.wire != NULL && bits.count(bitDef_t(bit.wire, bit.offset)) == 0)
+				result.append(RTLIL::SigSpec(bit));
 		return result;
 	}
 
-	bool check_any(RTLIL::SigSpec sig)
+	bool check_any(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			bitDef_t bit(c.wire, c.offset);
-			if (bits.count(bit) != 0)
+		for (auto bit : sig)
+			if (bit.wire != NULL && bits.count(bitDef_t(bit.wire, bit.offset)) != 0)
 				return true;
-		}
 		return false;
 	}
 
-	bool check_all(RTLIL::SigSpec sig)
+	bool check_all(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			bitDef_t bit(c.wire, c.offset);
-			if (bits.count(bit) == 0)
+		for (auto bit : sig)
+			if (bit.wire != NULL && bits.count(bitDef_t(bit.wire, bit.offset)) == 0)
 				return false;
-		}
 		return true;
 	}
 
@@ -176,157 +149,489 @@ struct SigSet
 		bits.clear();
 	}
 
-	void insert(RTLIL::SigSpec sig, T data)
+	void insert(const RTLIL::SigSlice &sig, const T &data)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits[bit].insert(data);
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits[bitDef_t(bit.wire, bit.offset)].insert(data);
+	}
+
+	void insert(const RTLIL::SigSpec &sig, const T &data)
+	{
+		insert(RTLIL::SigSlice(sig), data);
+	}
+
+	void insert(const RTLIL::SigSpec &sig, const std::set<T> &data)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits[bitDef_t(bit.wire, bit.offset)].insert(data.begin(), data.end());
+	}
+
+	void erase(const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits[bitDef_t(bit.wire, bit.offset)].clear();
+	}
+
+	void erase(const RTLIL::SigSpec &sig, T data)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits[bitDef_t(bit.wire, bit.offset)].erase(data);
+	}
+
+	void erase(const RTLIL::SigSpec &sig, const std::set<T> &data)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				bits[bitDef_t(bit.wire, bit.offset)].erase(data.begin(), data.end());
+	}
+
+	void find(const RTLIL::SigSlice &sig, std::set<T> &result)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL) {
+				auto it = bits.find(bitDef_t(bit.wire, bit.offset));
+				if (it != bits.end())
+					result.insert(it->second.begin(), it->second.end());
+			}
+	}
+
+	void find(const RTLIL::SigSpec &sig, std::set<T> &result)
+	{
+		find(RTLIL::SigSlice(sig), result);
+	}
+
+	std::set<T> find(const RTLIL::SigSpec &sig)
+	{
+		std::set<T> result;
+		find(sig, result);
+		return result;
+	}
+
+	bool has(const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig)
+			if (bit.wire != NULL && bits.count(bitDef_t(bit.wire, bit.offset)))
+				return true;
+		return false;
+	}
+};
+
+// SigBitIndex assigns dense indices to the bits of the wires of a module: the
+// bits of a wire get consecutive indices starting at a per-wire base index.
+// Wires that are not yet known (e.g. wires created after the index has been
+// set up) are added by the containers below when they are first used.
+struct SigBitIndex
+{
+	struct wire_range_t {
+		int base, width;
+		wire_range_t() : base(0), width(0) { }
+	};
+
+	hashlib::dict<RTLIL::Wire*, wire_range_t> wires;
+	std::vector<std::pair<int, RTLIL::Wire*>> ranges;
+	int num_bits;
+
+	SigBitIndex(RTLIL::Module *module = NULL) : num_bits(0)
+	{
+		if (module != NULL)
+			set(module);
+	}
+
+	void clear()
+	{
+		wires.clear();
+		ranges.clear();
+		num_bits = 0;
+	}
+
+	void set(RTLIL::Module *module)
+	{
+		clear();
+		for (auto &it : module->wires)
+			add(it.second);
+	}
+
+	// returns the index of bit 0 of the wire
+	int add(RTLIL::Wire *wire)
+	{
+		auto it = wires.find(wire);
+		if (it != wires.end()) {
+			assert(wire->width <= it->second.width);
+			return it->second.base;
 		}
+		wire_range_t &range = wires[wire];
+		range.base = num_bits;
+		range.width = wire->width;
+		if (wire->width > 0)
+			ranges.push_back(std::pair<int, RTLIL::Wire*>(num_bits, wire));
+		num_bits += wire->width;
+		return range.base;
 	}
 
-	void insert(RTLIL::SigSpec sig, const std::set<T> &data)
+	// returns the index of bit 0 of the wire or -1 if the wire is not known
+	int lookup(RTLIL::Wire *wire) const
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits[bit].insert(data.begin(), data.end());
+		auto it = wires.find(wire);
+		if (it == wires.end())
+			return -1;
+		assert(wire->width <= it->second.width);
+		return it->second.base;
+	}
+
+	RTLIL::SigBit bit(int index) const
+	{
+		// binary search for the last range starting at or before index
+		int lo = 0, hi = ranges.size();
+		while (hi - lo > 1) {
+			int mid = (lo + hi) / 2;
+			if (ranges[mid].first <= index)
+				lo = mid;
+			else
+				hi = mid;
 		}
+		assert(lo < int(ranges.size()) && ranges[lo].first <= index);
+		return RTLIL::SigBit(ranges[lo].second, index - ranges[lo].first);
 	}
+};
+
+// Like SigPool, but stores a bitset over the indices of a SigBitIndex. All
+// pools that are combined using add(), del() or expand() must share the
+// same index.
+struct DenseSigPool
+{
+	SigBitIndex *index;
+	std::vector<bool> bits;
+	size_t count;
 
-	void erase(RTLIL::SigSpec sig)
+	DenseSigPool(SigBitIndex *index) : index(index), count(0)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits[bit].clear();
+	}
+
+	void clear()
+	{
+		bits.clear();
+		count = 0;
+	}
+
+	// internal helper function: index of the first bit of the chunk,
+	// or -1 for constants and (if create is false) unknown wires
+	int chunk_index(const RTLIL::SigChunk &chunk, bool create)
+	{
+		if (chunk.wire == NULL)
+			return -1;
+		int base = create ? index->add(chunk.wire) : index->lookup(chunk.wire);
+		if (base < 0)
+			return -1;
+		if (bits.size() < size_t(index->num_bits))
+			bits.resize(index->num_bits);
+		return base + chunk.offset;
+	}
+
+	// internal helper function
+	bool get(int idx) const
+	{
+		return size_t(idx) < bits.size() && bits[idx];
+	}
+
+	// internal helper function
+	void set(int idx, bool value)
+	{
+		if (bits[idx] != value) {
+			bits[idx] = value;
+			value ? count++ : count--;
 		}
 	}
 
-	void erase(RTLIL::SigSpec sig, T data)
+	void add(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits[bit].erase(data);
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, true);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				set(idx + i, true);
 		}
 	}
 
-	void erase(RTLIL::SigSpec sig, const std::set<T> &data)
+	void add(const DenseSigPool &other)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
-				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			bits[bit].erase(data.begin(), data.end());
+		assert(index == other.index);
+		if (bits.size() < other.bits.size())
+			bits.resize(other.bits.size());
+		for (size_t i = 0; i < other.bits.size(); i++)
+			if (other.bits[i])
+				set(i, true);
+	}
+
+	void del(const RTLIL::SigSpec &sig)
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				set(idx + i, false);
 		}
 	}
 
-	void find(RTLIL::SigSpec sig, std::set<T> &result)
+	void del(const DenseSigPool &other)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
+		assert(index == other.index);
+		for (size_t i = 0; i < other.bits.size() && i < bits.size(); i++)
+			if (other.bits[i])
+				set(i, false);
+	}
+
+	void expand(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
+	{
+		assert(from.width == to.width);
+		for (auto it_from = from.begin(), it_to = to.begin(); it_from != from.end(); ++it_from, ++it_to) {
+			RTLIL::SigBit bit_from = *it_from, bit_to = *it_to;
+			if (bit_from.wire == NULL || bit_to.wire == NULL)
 				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			for (auto &data : bits[bit])
-				result.insert(data);
+			int idx_from = index->lookup(bit_from.wire);
+			if (idx_from >= 0 && get(idx_from + bit_from.offset))
+				add(RTLIL::SigSpec(bit_to));
 		}
 	}
 
-	std::set<T> find(RTLIL::SigSpec sig)
+	RTLIL::SigSpec extract(const RTLIL::SigSpec &sig)
 	{
-		std::set<T> result;
-		find(sig, result);
+		RTLIL::SigSpec result;
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				if (get(idx + i))
+					result.append(RTLIL::SigSpec(chunk.wire, 1, chunk.offset + i));
+		}
 		return result;
 	}
 
-	bool has(RTLIL::SigSpec sig)
+	RTLIL::SigSpec remove(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (auto &c : sig.chunks) {
-			if (c.wire == NULL)
+		RTLIL::SigSpec result;
+		for (auto &chunk : sig.chunks) {
+			if (chunk.wire == NULL)
 				continue;
-			assert(c.width == 1);
-			bitDef_t bit(c.wire, c.offset);
-			if (bits.count(bit))
-				return true;
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; i < chunk.width; i++)
+				if (idx < 0 || !get(idx + i))
+					result.append(RTLIL::SigSpec(chunk.wire, 1, chunk.offset + i));
+		}
+		return result;
+	}
+
+	bool check_any(const RTLIL::SigSpec &sig) const
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk.wire ? index->lookup(chunk.wire) : -1;
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				if (get(idx + chunk.offset + i))
+					return true;
 		}
 		return false;
 	}
+
+	bool check_all(const RTLIL::SigSpec &sig) const
+	{
+		for (auto &chunk : sig.chunks) {
+			if (chunk.wire == NULL)
+				continue;
+			int idx = index->lookup(chunk.wire);
+			for (int i = 0; i < chunk.width; i++)
+				if (idx < 0 || !get(idx + chunk.offset + i))
+					return false;
+		}
+		return true;
+	}
+
+	RTLIL::SigSpec export_one() const
+	{
+		for (size_t i = 0; i < bits.size(); i++)
+			if (bits[i])
+				return RTLIL::SigSpec(index->bit(i));
+		return RTLIL::SigSpec();
+	}
+
+	RTLIL::SigSpec export_all() const
+	{
+		RTLIL::SigSpec sig;
+		for (size_t i = 0; i < bits.size(); i++)
+			if (bits[i])
+				sig.append(RTLIL::SigSpec(index->bit(i)));
+		sig.sort_and_unify();
+		return sig;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
 };
 
-struct SigMap
+// Like SigSet, but stores a sorted vector of elements for each index of a
+// SigBitIndex. Unlike SigSet::has(), has() only returns true for bits with
+// a non-empty set of elements.
+template <typename T, class Compare = std::less<T>>
+struct DenseSigSet
 {
-	typedef std::pair<RTLIL::Wire*,int> bitDef_t;
+	SigBitIndex *index;
+	std::vector<std::vector<T>> bits;
 
-	struct shared_bit_data_t {
-		RTLIL::SigChunk chunk;
-		std::set<bitDef_t> bits;
-	};
+	DenseSigSet(SigBitIndex *index) : index(index)
+	{
+	}
 
-	std::map<bitDef_t, shared_bit_data_t*> bits;
+	void clear()
+	{
+		bits.clear();
+	}
 
-	SigMap(RTLIL::Module *module = NULL)
+	// internal helper function, see DenseSigPool::chunk_index()
+	int chunk_index(const RTLIL::SigChunk &chunk, bool create)
 	{
-		if (module != NULL)
-			set(module);
+		if (chunk.wire == NULL)
+			return -1;
+		int base = create ? index->add(chunk.wire) : index->lookup(chunk.wire);
+		if (base < 0)
+			return -1;
+		if (bits.size() < size_t(index->num_bits))
+			bits.resize(index->num_bits);
+		return base + chunk.offset;
 	}
 
-	SigMap(const SigMap &other)
+	// internal helper function
+	static void insert_elem(std::vector<T> &vec, const T &data)
 	{
-		copy(other);
+		auto it = std::lower_bound(vec.begin(), vec.end(), data, Compare());
+		if (it == vec.end() || Compare()(data, *it))
+			vec.insert(it, data);
 	}
 
-	const SigMap &operator=(const SigMap &other)
+	// internal helper function
+	static void erase_elem(std::vector<T> &vec, const T &data)
 	{
-		copy(other);
-		return *this;
+		auto it = std::lower_bound(vec.begin(), vec.end(), data, Compare());
+		if (it != vec.end() && !Compare()(data, *it))
+			vec.erase(it);
 	}
 
-	void copy(const SigMap &other)
+	void insert(const RTLIL::SigSpec &sig, T data)
 	{
-		clear();
-		for (auto &bit : other.bits) {
-			bits[bit.first] = new shared_bit_data_t;
-			bits[bit.first]->chunk = bit.second->chunk;
-			bits[bit.first]->bits = bit.second->bits;
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, true);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				insert_elem(bits[idx + i], data);
 		}
 	}
 
-	void swap(SigMap &other)
+	void insert(const RTLIL::SigSpec &sig, const std::set<T> &data)
 	{
-		bits.swap(other.bits);
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, true);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				for (auto &d : data)
+					insert_elem(bits[idx + i], d);
+		}
 	}
 
-	~SigMap()
+	void erase(const RTLIL::SigSpec &sig)
 	{
-		clear();
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				bits[idx + i].clear();
+		}
+	}
+
+	void erase(const RTLIL::SigSpec &sig, T data)
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				erase_elem(bits[idx + i], data);
+		}
+	}
+
+	void erase(const RTLIL::SigSpec &sig, const std::set<T> &data)
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk_index(chunk, false);
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				for (auto &d : data)
+					erase_elem(bits[idx + i], d);
+		}
+	}
+
+	void find(const RTLIL::SigSpec &sig, std::set<T> &result) const
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk.wire ? index->lookup(chunk.wire) : -1;
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				if (size_t(idx + chunk.offset + i) < bits.size()) {
+					const std::vector<T> &vec = bits[idx + chunk.offset + i];
+					result.insert(vec.begin(), vec.end());
+				}
+		}
+	}
+
+	std::set<T> find(const RTLIL::SigSpec &sig) const
+	{
+		std::set<T> result;
+		find(sig, result);
+		return result;
+	}
+
+	bool has(const RTLIL::SigSpec &sig) const
+	{
+		for (auto &chunk : sig.chunks) {
+			int idx = chunk.wire ? index->lookup(chunk.wire) : -1;
+			for (int i = 0; idx >= 0 && i < chunk.width; i++)
+				if (size_t(idx + chunk.offset + i) < bits.size() && !bits[idx + chunk.offset + i].empty())
+					return true;
+		}
+		return false;
+	}
+};
+
+// SigMap is a union-find structure over the bits of all wires it has seen.
+// The bits of a wire get consecutive slots starting at the base index stored
+// for the wire in 'wires', slot2node maps the slots to the union-find nodes
+// and the root node of each group stores the signal the group maps to.
+struct SigMap
+{
+	struct wire_slots_t {
+		int base, width;
+		wire_slots_t() : base(0), width(0) { }
+	};
+
+	hashlib::dict<RTLIL::Wire*, wire_slots_t> wires;
+	std::vector<int> slot2node;
+	std::vector<int> parent, group_size;
+	std::vector<RTLIL::SigBit> map_to;
+
+	SigMap(RTLIL::Module *module = NULL)
+	{
+		if (module != NULL)
+			set(module);
+	}
+
+	void swap(SigMap &other)
+	{
+		wires.swap(other.wires);
+		slot2node.swap(other.slot2node);
+		parent.swap(other.parent);
+		group_size.swap(other.group_size);
+		map_to.swap(other.map_to);
 	}
 
 	void clear()
 	{
-		std::set<shared_bit_data_t*> all_bd_ptr;
-		for (auto &it : bits)
-			all_bd_ptr.insert(it.second);
-		for (auto bd_ptr : all_bd_ptr)
-			delete bd_ptr;
-		bits.clear();
+		wires.clear();
+		slot2node.clear();
+		parent.clear();
+		group_size.clear();
+		map_to.clear();
 	}
 
 	void set(RTLIL::Module *module)
@@ -334,143 +639,187 @@ struct SigMap
 		clear();
 		for (auto &it : module->connections)
 			add(it.first, it.second);
+		compress();
+	}
+
+	// internal helper function
+	int new_node(const RTLIL::SigBit &bit)
+	{
+		parent.push_back(parent.size());
+		group_size.push_back(1);
+		map_to.push_back(bit);
+		return parent.size() - 1;
 	}
 
 	// internal helper function
-	void register_bit(const RTLIL::SigChunk &c)
-	{
-		assert(c.width == 1);
-		bitDef_t bit(c.wire, c.offset);
-		if (c.wire && bits.count(bit) == 0) {
-			shared_bit_data_t *bd = new shared_bit_data_t;
-			bd->chunk = c;
-			bd->bits.insert(bit);
-			bits[bit] = bd;
+	int lookup_slot(const RTLIL::SigBit &bit) const
+	{
+		if (bit.wire == NULL)
+			return -1;
+		auto it = wires.find(bit.wire);
+		if (it == wires.end() || bit.offset >= it->second.width)
+			return -1;
+		return it->second.base + bit.offset;
+	}
+
+	// internal helper function
+	int register_bit(const RTLIL::SigBit &bit)
+	{
+		assert(bit.wire != NULL);
+		wire_slots_t &ws = wires[bit.wire];
+		if (bit.offset >= ws.width) {
+			// first use of this wire or the wire has grown (auto_width)
+			int old_base = ws.base, old_width = ws.width;
+			ws.base = slot2node.size();
+			ws.width = std::max(bit.wire->width, bit.offset + 1);
+			for (int i = 0; i < ws.width; i++)
+				slot2node.push_back(i < old_width ? slot2node[old_base + i] : new_node(RTLIL::SigBit(bit.wire, i)));
 		}
+		return slot2node[ws.base + bit.offset];
 	}
 
 	// internal helper function
-	void unregister_bit(const RTLIL::SigChunk &c)
-	{
-		assert(c.width == 1);
-		bitDef_t bit(c.wire, c.offset);
-		if (c.wire && bits.count(bit) > 0) {
-			shared_bit_data_t *bd = bits[bit];
-			bd->bits.erase(bit);
-			if (bd->bits.size() == 0)
-				delete bd;
-			bits.erase(bit);
+	int find(int node)
+	{
+		int root = node;
+		while (parent[root] != root)
+			root = parent[root];
+		while (parent[node] != root) {
+			int next = parent[node];
+			parent[node] = root;
+			node = next;
 		}
+		return root;
 	}
 
 	// internal helper function
-	void merge_bit(const RTLIL::SigChunk &c1, const RTLIL::SigChunk &c2)
+	int find(int node) const
 	{
-		assert(c1.wire != NULL && c2.wire != NULL);
-		assert(c1.width == 1 && c2.width == 1);
-
-		bitDef_t b1(c1.wire, c1.offset);
-		bitDef_t b2(c2.wire, c2.offset);
-
-		shared_bit_data_t *bd1 = bits[b1];
-		shared_bit_data_t *bd2 = bits[b2];
-		assert(bd1 != NULL && bd2 != NULL);
-
-		if (bd1 == bd2)
-			return;
+		while (parent[node] != node)
+			node = parent[node];
+		return node;
+	}
 
-		if (bd1->bits.size() < bd2->bits.size())
-		{
-			for (auto &bit : bd1->bits)
-				bits[bit] = bd2;
-			bd2->bits.insert(bd1->bits.begin(), bd1->bits.end());
-			delete bd1;
-		}
-		else
-		{
-			bd1->chunk = bd2->chunk;
-			for (auto &bit : bd2->bits)
-				bits[bit] = bd1;
-			bd1->bits.insert(bd2->bits.begin(), bd2->bits.end());
-			delete bd2;
-		}
+	// internal helper function: point all nodes directly to their root
+	void compress()
+	{
+		for (int i = 0; i < int(parent.size()); i++)
+			find(i);
 	}
 
-	// internal helper function
-	void set_bit(const RTLIL::SigChunk &c1, const RTLIL::SigChunk &c2)
+	// internal helper function: the merged group maps to what node2 mapped to
+	void merge_nodes(int node1, int node2)
 	{
-		assert(c1.wire != NULL);
-		assert(c1.width == 1 && c2.width == 1);
-		bitDef_t bit(c1.wire, c1.offset);
-		assert(bits.count(bit) > 0);
-		bits[bit]->chunk = c2;
+		int root1 = find(node1), root2 = find(node2);
+		if (root1 == root2)
+			return;
+		RTLIL::SigBit target = map_to[root2];
+		if (group_size[root1] < group_size[root2])
+			std::swap(root1, root2);
+		parent[root2] = root1;
+		group_size[root1] += group_size[root2];
+		map_to[root1] = target;
 	}
 
 	// internal helper function
-	void map_bit(RTLIL::SigChunk &c)
+	RTLIL::SigBit map_bit(const RTLIL::SigBit &bit) const
 	{
-		assert(c.width == 1);
-		bitDef_t bit(c.wire, c.offset);
-		if (c.wire && bits.count(bit) > 0)
-			c = bits[bit]->chunk;
+		int slot = lookup_slot(bit);
+		if (slot < 0)
+			return bit;
+		return map_to[find(slot2node[slot])];
 	}
 
-	void add(RTLIL::SigSpec from, RTLIL::SigSpec to)
+	void add(const RTLIL::SigSpec &from, const RTLIL::SigSpec &to)
 	{
-		from.expand();
-		to.expand();
-
-		assert(from.chunks.size() == to.chunks.size());
-		for (size_t i = 0; i < from.chunks.size(); i++)
+		assert(from.width == to.width);
+		for (auto it_from = from.begin(), it_to = to.begin(); it_from != from.end(); ++it_from, ++it_to)
 		{
-			RTLIL::SigChunk &cf = from.chunks[i];
-			RTLIL::SigChunk &ct = to.chunks[i];
+			RTLIL::SigBit bf = *it_from, bt = *it_to;
 
-			if (cf.wire == NULL)
+			if (bf.wire == NULL)
 				continue;
 
-			register_bit(cf);
-			register_bit(ct);
-
-			if (ct.wire != NULL)
-				merge_bit(cf, ct);
+			int node = register_bit(bf);
+			if (bt.wire != NULL)
+				merge_nodes(node, register_bit(bt));
 			else
-				set_bit(cf, ct);
+				map_to[find(node)] = bt;
 		}
 	}
 
-	void add(RTLIL::SigSpec sig)
+	void add(const RTLIL::SigSpec &sig)
 	{
-		sig.expand();
-		for (size_t i = 0; i < sig.chunks.size(); i++)
-		{
-			RTLIL::SigChunk &c = sig.chunks[i];
-			if (c.wire != NULL) {
-				register_bit(c);
-				set_bit(c, c);
-			}
+		for (auto bit : sig)
+			if (bit.wire != NULL)
+				map_to[find(register_bit(bit))] = bit;
+	}
+
+	// detach the bits from their groups, they map to themselves again
+	void del(const RTLIL::SigSpec &sig)
+	{
+		for (auto bit : sig) {
+			int slot = lookup_slot(bit);
+			if (slot >= 0)
+				slot2node[slot] = new_node(bit);
 		}
 	}
 
-	void del(RTLIL::SigSpec sig)
+	void apply(RTLIL::SigSpec &sig) const
 	{
-		sig.expand();
-		for (auto &c : sig.chunks)
-			unregister_bit(c);
+		sig = (*this)(RTLIL::SigSlice(sig));
 	}
 
-	void apply(RTLIL::SigSpec &sig)
+	RTLIL::SigSpec operator()(const RTLIL::SigSlice &sig) const
 	{
-		sig.expand();
-		for (auto &c : sig.chunks)
-			map_bit(c);
-		sig.optimize();
+		RTLIL::SigSpec new_sig;
+		for (auto bit : sig)
+			new_sig.append_bit(map_bit(bit));
+		return new_sig;
 	}
 
-	RTLIL::SigSpec operator()(RTLIL::SigSpec sig)
+	RTLIL::SigSpec operator()(const RTLIL::SigSpec &sig) const
 	{
-		apply(sig);
-		return sig;
+		return (*this)(RTLIL::SigSlice(sig));
+	}
+
+	RTLIL::SigBit operator()(RTLIL::SigBit bit) const
+	{
+		return map_bit(bit);
+	}
+};
+
+// A SigMap for a module that is kept in a module cache slot, so that the
+// passes in a script like 'opt' do not rebuild it while the module
+// connections stay the same. Use CachedSigMap::get(module) instead of
+// SigMap(module) where the map is only read; passes that add their own
+// entries work on a copy. Passes that change the module connections without
+// Module::connect() must call notify_blackout() before they get the map again.
+struct CachedSigMap : public RTLIL::CachedData
+{
+	SigMap sigmap;
+	unsigned int connections_epoch;
+	size_t connections_count;
+
+	CachedSigMap(RTLIL::Module *module) : sigmap(module),
+			connections_epoch(module->connections_epoch), connections_count(module->connections.size()) { }
+
+	// the module connections are all the map depends on. connections added
+	// by Module::connect() since the map was built are simply added to it.
+	virtual bool revalidate(RTLIL::Module *module)
+	{
+		if (connections_epoch != module->connections_epoch || connections_count > module->connections.size())
+			return false;
+		for (size_t i = connections_count; i < module->connections.size(); i++)
+			sigmap.add(module->connections[i].first, module->connections[i].second);
+		connections_count = module->connections.size();
+		return true;
+	}
+
+	static const SigMap &get(RTLIL::Module *module)
+	{
+		static int slot = RTLIL::Module::new_cache_slot();
+		return module->get_cached<CachedSigMap>(slot)->sigmap;
 	}
 };
 
@@ -0,0 +1,134 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/threadpool.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <vector>
+
+int ThreadPool::num_threads = 1;
+
+namespace {
+
+// The pool state is never freed and the workers are detached, so that
+// exit() can be called from any thread (e.g. by log_error()) while the
+// workers are still waiting for jobs.
+struct PoolState
+{
+	std::mutex mutex;
+	std::condition_variable work_cond, done_cond;
+	int num_workers = 0;
+
+	// the current batch of jobs
+	std::function<void(int)> *job = NULL;
+	int job_count = 0;
+	std::atomic<int> next_job;
+	int active_workers = 0;
+	unsigned int generation = 0;
+	std::exception_ptr exception;
+
+	PoolState() : next_job(0) { }
+
+	void work(std::function<void(int)> &current_job, int count);
+	void worker_main();
+};
+
+PoolState *pool = NULL;
+thread_local bool inside_job = false;
+
+void PoolState::work(std::function<void(int)> &current_job, int count)
+{
+	inside_job = true;
+	while (1) {
+		int idx = next_job++;
+		if (idx >= count)
+			break;
+		try {
+			current_job(idx);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!exception)
+				exception = std::current_exception();
+		}
+	}
+	inside_job = false;
+}
+
+void PoolState::worker_main()
+{
+	unsigned int seen_generation = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (1) {
+		work_cond.wait(lock, [&]() { return generation != seen_generation; });
+		seen_generation = generation;
+		if (job == NULL)
+			continue;
+		std::function<void(int)> *current_job = job;
+		int count = job_count;
+		active_workers++;
+		lock.unlock();
+		work(*current_job, count);
+		lock.lock();
+		if (--active_workers == 0)
+			done_cond.notify_all();
+	}
+}
+
+} /* namespace */
+
+void ThreadPool::run(int count, std::function<void(int)> job)
+{
+	if (num_threads <= 1 || count <= 1 || inside_job) {
+		for (int i = 0; i < count; i++)
+			job(i);
+		return;
+	}
+
+	if (pool == NULL)
+		pool = new PoolState;
+
+	std::unique_lock<std::mutex> lock(pool->mutex);
+	while (pool->num_workers < num_threads - 1) {
+		std::thread(&PoolState::worker_main, pool).detach();
+		pool->num_workers++;
+	}
+
+	pool->job = &job;
+	pool->job_count = count;
+	pool->next_job = 0;
+	pool->exception = std::exception_ptr();
+	pool->generation++;
+	lock.unlock();
+	pool->work_cond.notify_all();
+
+	pool->work(job, count);
+
+	lock.lock();
+	pool->done_cond.wait(lock, [&]() { return pool->active_workers == 0; });
+	pool->job = NULL;
+	std::exception_ptr exception = pool->exception;
+	pool->exception = std::exception_ptr();
+	lock.unlock();
+
+	if (exception)
+		std::rethrow_exception(exception);
+}
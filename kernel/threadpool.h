@@ -0,0 +1,46 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  A simple pool of worker threads for running independent jobs in parallel.
+ *
+ *  The workers are started on first use and then wait for new jobs. The
+ *  calling thread takes part in the work, so ThreadPool::run() with
+ *  num_threads == 1 simply calls the jobs in order. Calls to run() from
+ *  within a job are executed sequentially by the calling thread.
+ *
+ *  Exceptions thrown by a job are caught and the first one is rethrown by
+ *  run() after all jobs have finished.
+ *
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <functional>
+
+struct ThreadPool
+{
+	// number of threads used by run(), set with "yosys -j <N>" (default: 1)
+	static int num_threads;
+
+	// calls job(0) .. job(count-1) and returns when all of them have finished
+	static void run(int count, std::function<void(int)> job);
+};
+
+#endif
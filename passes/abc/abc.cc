@@ -275,7 +275,7 @@ static void handle_loops()
 					id1 = id2;
 				else if (edges[id1].size() > edges[id2].size())
 					continue;
-				else if (w1->name > w2->name)
+				else if (w2->name < w1->name)
 					id1 = id2;
 			}
 
@@ -515,9 +515,7 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 			log_error("ABC output file does not contain a module `logic'.\n");
 		for (auto &it : mapped_mod->wires) {
 			RTLIL::Wire *w = it.second;
-			RTLIL::Wire *wire = new RTLIL::Wire;
-			wire->name = remap_name(w->name);
-			module->wires[wire->name] = wire;
+			RTLIL::Wire *wire = module->addWire(remap_name(w->name));
 			design->select(module, wire);
 		}
 
@@ -542,35 +540,26 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 					continue;
 				}
 				if (c->type == "\\INV") {
-					RTLIL::Cell *cell = new RTLIL::Cell;
-					cell->type = "$_INV_";
-					cell->name = remap_name(c->name);
+					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_INV_");
 					cell->connections["\\A"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\A"].chunks[0].wire->name)]);
 					cell->connections["\\Y"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\Y"].chunks[0].wire->name)]);
-					module->cells[cell->name] = cell;
 					design->select(module, cell);
 					continue;
 				}
 				if (c->type == "\\AND" || c->type == "\\OR" || c->type == "\\XOR") {
-					RTLIL::Cell *cell = new RTLIL::Cell;
-					cell->type = "$_" + c->type.substr(1) + "_";
-					cell->name = remap_name(c->name);
+					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_" + c->type.substr(1) + "_");
 					cell->connections["\\A"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\A"].chunks[0].wire->name)]);
 					cell->connections["\\B"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\B"].chunks[0].wire->name)]);
 					cell->connections["\\Y"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\Y"].chunks[0].wire->name)]);
-					module->cells[cell->name] = cell;
 					design->select(module, cell);
 					continue;
 				}
 				if (c->type == "\\MUX") {
-					RTLIL::Cell *cell = new RTLIL::Cell;
-					cell->type = "$_MUX_";
-					cell->name = remap_name(c->name);
+					RTLIL::Cell *cell = module->addCell(remap_name(c->name), "$_MUX_");
 					cell->connections["\\A"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\A"].chunks[0].wire->name)]);
 					cell->connections["\\B"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\B"].chunks[0].wire->name)]);
 					cell->connections["\\S"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\S"].chunks[0].wire->name)]);
 					cell->connections["\\Y"] = RTLIL::SigSpec(module->wires[remap_name(c->connections["\\Y"].chunks[0].wire->name)]);
-					module->cells[cell->name] = cell;
 					design->select(module, cell);
 					continue;
 				}
@@ -589,10 +578,8 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 					module->connections.push_back(conn);
 					continue;
 				}
-				RTLIL::Cell *cell = new RTLIL::Cell;
-				cell->type = c->type;
+				RTLIL::Cell *cell = module->addCell(remap_name(c->name), c->type);
 				cell->parameters = c->parameters;
-				cell->name = remap_name(c->name);
 				for (auto &conn : c->connections) {
 					RTLIL::SigSpec newsig;
 					for (auto &c : conn.second.chunks) {
@@ -603,7 +590,6 @@ static void abc_module(RTLIL::Design *design, RTLIL::Module *current_module, std
 					}
 					cell->connections[conn.first] = newsig;
 				}
-				module->cells[cell->name] = cell;
 				design->select(module, cell);
 			}
 		}
@@ -23,7 +23,7 @@
 #include "kernel/log.h"
 
 struct DesignPass : public Pass {
-	DesignPass() : Pass("design", "save, restore and reset current design") { }
+	DesignPass() : Pass("design", "save, restore and reset current design") { modifies_design = false; }
 	std::map<std::string, RTLIL::Design*> saved_designs;
 	virtual ~DesignPass() {
 		for (auto &it : saved_designs)
@@ -41,7 +41,11 @@ struct DesignPass : public Pass {
 		log("\n");
 		log("    design -save <name>\n");
 		log("\n");
-		log("Save the current design under the given name.\n");
+		log("Save the current design under the given name. The saved design shares its\n");
+		log("modules with the current design. A module is only copied when a command that\n");
+		log("may modify the design is executed while the module is shared. Commands that\n");
+		log("only work on the selected modules (like 'opt' or 'proc') only copy the shared\n");
+		log("modules that are selected.\n");
 		log("\n");
 		log("\n");
 		log("    design -load <name>\n");
@@ -49,6 +53,13 @@ struct DesignPass : public Pass {
 		log("Reset the current design and load the design previously saved under the given\n");
 		log("name.\n");
 		log("\n");
+		log("\n");
+		log("    design -arena {on|off}\n");
+		log("\n");
+		log("Enable or disable allocating the wires and cells of modules from per-module\n");
+		log("memory pools (default: on). This only affects modules created after the\n");
+		log("command. Switching it off can be useful for memory debugging tools.\n");
+		log("\n");
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
@@ -70,6 +81,11 @@ struct DesignPass : public Pass {
 				save_name = args[++argidx];
 				continue;
 			}
+			if (arg == "-arena" && argidx+1 < args.size() && (args[argidx+1] == "on" || args[argidx+1] == "off")) {
+				got_mode = true;
+				RTLIL::Design::arena_alloc = args[++argidx] == "on";
+				continue;
+			}
 			if (arg == "-load" && argidx+1 < args.size()) {
 				got_mode = true;
 				load_name = args[++argidx];
@@ -81,12 +97,12 @@ struct DesignPass : public Pass {
 		extra_args(args, argidx, design, false);
 
 		if (!got_mode)
-			cmd_error(args, argidx, "Missing mode argument (-reset, -save, or -load).");
+			cmd_error(args, argidx, "Missing mode argument (-reset, -save, -load, or -arena).");
 
 		if (reset_mode || !load_name.empty())
 		{
 			for (auto &it : design->modules)
-				delete it.second;
+				it.second->release();
 			design->modules.clear();
 
 			design->selection_stack.clear();
@@ -101,7 +117,7 @@ struct DesignPass : public Pass {
 			RTLIL::Design *design_copy = new RTLIL::Design;
 
 			for (auto &it : design->modules)
-				design_copy->modules[it.first] = it.second->clone();
+				design_copy->modules[it.first] = it.second->share();
 
 			design_copy->selection_stack = design->selection_stack;
 			design_copy->selection_vars = design->selection_vars;
@@ -117,7 +133,7 @@ struct DesignPass : public Pass {
 			RTLIL::Design *saved_design = saved_designs.at(load_name);
 
 			for (auto &it : saved_design->modules)
-				design->modules[it.first] = it.second->clone();
+				design->modules[it.first] = it.second->share();
 
 			design->selection_stack = saved_design->selection_stack;
 			design->selection_vars = saved_design->selection_vars;
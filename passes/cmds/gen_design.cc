@@ -0,0 +1,561 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/log.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <map>
+
+namespace {
+
+struct GenDesignConfig
+{
+	std::string top;
+	int num_cells, width, fanout, ff_percent;
+	int depth, branch;
+	bool unique;
+	int num_memories, mem_abits, num_fsms, num_states;
+	uint32_t seed;
+
+	GenDesignConfig()
+	{
+		top = "\\gen_top";
+		num_cells = 10000;
+		width = 16;
+		fanout = 2;
+		ff_percent = 10;
+		depth = 0;
+		branch = 2;
+		unique = false;
+		num_memories = 0;
+		mem_abits = 4;
+		num_fsms = 0;
+		num_states = 8;
+		seed = 1;
+	}
+};
+
+// Generates the logic of one module. All data signals are cfg.width bits
+// wide. The outputs of the cells (and of the submodule instances) are kept
+// in a pool of sources, each one as often as it should be read by other
+// cells. New cells take their inputs from the recently added sources, so that
+// the design has some locality. Because cells only read signals that exist
+// when they are created there are no combinational loops. The sources left
+// over at the end are combined into the module output with a tree of $xor
+// cells, so that all cells are live.
+struct ModuleGenerator
+{
+	const GenDesignConfig &cfg;
+	RTLIL::Module *module;
+	RTLIL::SigSpec sig_clk, sig_in;
+	uint32_t xorshift32_state;
+	int num_cells;
+
+	std::vector<RTLIL::SigSpec> signals;
+	std::vector<int> refcount, sources;
+	int num_live_signals, last_taken;
+
+	ModuleGenerator(const GenDesignConfig &cfg, RTLIL::Module *module, uint32_t seed) :
+			cfg(cfg), module(module), xorshift32_state(seed ? seed : 1), num_cells(0), num_live_signals(0), last_taken(-1)
+	{
+		RTLIL::Wire *wire = module->addWire("\\clk");
+		wire->port_input = true;
+		sig_clk = RTLIL::SigSpec(wire);
+
+		wire = module->addWire("\\in", cfg.width);
+		wire->port_input = true;
+		sig_in = RTLIL::SigSpec(wire);
+
+		for (int i = 0; i < 4; i++)
+			xorshift32();
+	}
+
+	uint32_t xorshift32()
+	{
+		xorshift32_state ^= xorshift32_state << 13;
+		xorshift32_state ^= xorshift32_state >> 17;
+		xorshift32_state ^= xorshift32_state << 5;
+		return xorshift32_state;
+	}
+
+	int random(int n)
+	{
+		return xorshift32() % n;
+	}
+
+	// the number of readers is uniformly distributed in [1, 2*fanout-1]
+	void add_source(const RTLIL::SigSpec &sig)
+	{
+		int idx = signals.size();
+		int readers = 1 + random(2 * cfg.fanout - 1);
+		signals.push_back(sig);
+		refcount.push_back(readers);
+		for (int i = 0; i < readers; i++)
+			sources.push_back(idx);
+		num_live_signals++;
+	}
+
+	// consecutive calls return different signals where possible, so that
+	// the inputs of a cell are not trivially equal. When the pool has no
+	// suitable entry (the cells have more inputs than the fan-out provides),
+	// a random earlier signal gets an additional reader.
+	RTLIL::SigSpec take_source()
+	{
+		int window = std::min(int(sources.size()), 64);
+		for (int i = 0; i < 8 && window > 0; i++) {
+			int pos = sources.size() - 1 - random(window);
+			int idx = sources[pos];
+			if (idx == last_taken)
+				continue;
+			sources[pos] = sources.back();
+			sources.pop_back();
+			if (--refcount[idx] == 0)
+				num_live_signals--;
+			last_taken = idx;
+			return signals[idx];
+		}
+
+		int idx = random(signals.size());
+		for (int i = 0; i < 8 && idx == last_taken; i++)
+			idx = random(signals.size());
+		last_taken = idx;
+		return signals[idx];
+	}
+
+	RTLIL::SigSpec take_bit()
+	{
+		RTLIL::SigSpec sig = take_source();
+		return sig.extract(random(sig.width), 1);
+	}
+
+	RTLIL::SigSpec new_signal(int width)
+	{
+		return RTLIL::SigSpec(module->addWire(NEW_ID, width));
+	}
+
+	RTLIL::Cell *add_cell(std::string type)
+	{
+		num_cells++;
+		return module->addCell(NEW_ID, type);
+	}
+
+	RTLIL::SigSpec add_binary(std::string type, RTLIL::SigSpec a, RTLIL::SigSpec b, int y_width)
+	{
+		RTLIL::SigSpec y = new_signal(y_width);
+		RTLIL::Cell *cell = add_cell(type);
+		cell->connections["\\A"] = a;
+		cell->connections["\\B"] = b;
+		cell->connections["\\Y"] = y;
+		cell->parameters["\\A_SIGNED"] = RTLIL::Const(0);
+		cell->parameters["\\B_SIGNED"] = RTLIL::Const(0);
+		cell->parameters["\\A_WIDTH"] = RTLIL::Const(a.width);
+		cell->parameters["\\B_WIDTH"] = RTLIL::Const(b.width);
+		cell->parameters["\\Y_WIDTH"] = RTLIL::Const(y_width);
+		return y;
+	}
+
+	RTLIL::SigSpec add_mux(RTLIL::SigSpec a, RTLIL::SigSpec b, RTLIL::SigSpec s)
+	{
+		RTLIL::SigSpec y = new_signal(a.width);
+		RTLIL::Cell *cell = add_cell("$mux");
+		cell->connections["\\A"] = a;
+		cell->connections["\\B"] = b;
+		cell->connections["\\S"] = s;
+		cell->connections["\\Y"] = y;
+		cell->parameters["\\WIDTH"] = RTLIL::Const(a.width);
+		return y;
+	}
+
+	RTLIL::SigSpec add_dff(RTLIL::SigSpec d)
+	{
+		RTLIL::SigSpec q = new_signal(d.width);
+		RTLIL::Cell *cell = add_cell("$dff");
+		cell->connections["\\CLK"] = sig_clk;
+		cell->connections["\\D"] = d;
+		cell->connections["\\Q"] = q;
+		cell->parameters["\\WIDTH"] = RTLIL::Const(d.width);
+		cell->parameters["\\CLK_POLARITY"] = RTLIL::Const(1);
+		return q;
+	}
+
+	void gen_logic_cell()
+	{
+		if (random(100) < cfg.ff_percent) {
+			add_source(add_dff(take_source()));
+			return;
+		}
+
+		RTLIL::SigSpec y;
+		switch (random(8))
+		{
+		case 0:
+			y = add_binary("$add", take_source(), take_source(), cfg.width);
+			break;
+		case 1:
+			y = add_binary("$sub", take_source(), take_source(), cfg.width);
+			break;
+		case 2:
+			y = add_binary("$and", take_source(), take_source(), cfg.width);
+			break;
+		case 3:
+			y = add_binary("$or", take_source(), take_source(), cfg.width);
+			break;
+		case 4:
+			y = add_binary("$xor", take_source(), take_source(), cfg.width);
+			break;
+		case 5:
+			y = add_binary("$shl", take_source(), take_source().extract(0, std::min(cfg.width, 3)), cfg.width);
+			break;
+		default: {
+				RTLIL::SigSpec a = take_source(), b = take_source();
+				RTLIL::SigSpec s = add_binary(random(2) ? "$eq" : "$lt", take_source(), take_source(), 1);
+				y = add_mux(a, b, s);
+			}
+			break;
+		}
+		add_source(y);
+	}
+
+	// a memory with one synchronous write port and one asynchronous read
+	// port, as created by the frontend and memory_dff
+	void gen_memory(int idx)
+	{
+		RTLIL::Memory *memory = new RTLIL::Memory;
+		memory->name = stringf("\\mem%d", idx);
+		memory->width = cfg.width;
+		memory->size = 1 << cfg.mem_abits;
+		module->memories[memory->name] = memory;
+
+		RTLIL::SigSpec wr_addr = take_source(), rd_addr = take_source();
+		wr_addr.extend(cfg.mem_abits);
+		rd_addr.extend(cfg.mem_abits);
+
+		RTLIL::Cell *cell = add_cell("$memwr");
+		cell->connections["\\CLK"] = sig_clk;
+		cell->connections["\\ADDR"] = wr_addr.extract(0, cfg.mem_abits);
+		cell->connections["\\DATA"] = take_source();
+		cell->connections["\\EN"] = take_bit();
+		cell->parameters["\\MEMID"] = RTLIL::Const(memory->name);
+		cell->parameters["\\ABITS"] = RTLIL::Const(cfg.mem_abits);
+		cell->parameters["\\WIDTH"] = RTLIL::Const(cfg.width);
+		cell->parameters["\\CLK_ENABLE"] = RTLIL::Const(1);
+		cell->parameters["\\CLK_POLARITY"] = RTLIL::Const(1);
+
+		RTLIL::SigSpec data = new_signal(cfg.width);
+		cell = add_cell("$memrd");
+		cell->connections["\\CLK"] = RTLIL::SigSpec(RTLIL::State::Sx, 1);
+		cell->connections["\\ADDR"] = rd_addr.extract(0, cfg.mem_abits);
+		cell->connections["\\DATA"] = data;
+		cell->parameters["\\MEMID"] = RTLIL::Const(memory->name);
+		cell->parameters["\\ABITS"] = RTLIL::Const(cfg.mem_abits);
+		cell->parameters["\\WIDTH"] = RTLIL::Const(cfg.width);
+		cell->parameters["\\CLK_ENABLE"] = RTLIL::Const(0);
+		cell->parameters["\\CLK_POLARITY"] = RTLIL::Const(0);
+		add_source(data);
+	}
+
+	// a state register with a $mux chain for the next state and $eq cells
+	// decoding the state, the structure fsm_detect is looking for
+	void gen_fsm(int idx)
+	{
+		int state_bits = 2;
+		while ((1 << state_bits) < cfg.num_states)
+			state_bits++;
+
+		RTLIL::Wire *state_wire = module->addWire(stringf("\\fsm%d_state", idx), state_bits);
+		RTLIL::SigSpec state(state_wire), next_state = state;
+		std::vector<RTLIL::SigSpec> decoded;
+
+		for (int i = 0; i < cfg.num_states; i++) {
+			decoded.push_back(add_binary("$eq", state, RTLIL::SigSpec(i, state_bits), 1));
+			RTLIL::SigSpec cond = add_binary("$and", decoded.back(), take_bit(), 1);
+			next_state = add_mux(next_state, RTLIL::SigSpec(random(cfg.num_states), state_bits), cond);
+		}
+
+		RTLIL::Cell *cell = add_cell("$dff");
+		cell->connections["\\CLK"] = sig_clk;
+		cell->connections["\\D"] = next_state;
+		cell->connections["\\Q"] = state;
+		cell->parameters["\\WIDTH"] = RTLIL::Const(state_bits);
+		cell->parameters["\\CLK_POLARITY"] = RTLIL::Const(1);
+
+		for (int i = 0; i < 2; i++)
+			add_source(add_mux(take_source(), take_source(), decoded[random(decoded.size())]));
+	}
+
+	void gen_instance(RTLIL::IdString type, int idx)
+	{
+		RTLIL::SigSpec out = new_signal(cfg.width);
+		RTLIL::Cell *cell = module->addCell(stringf("\\inst%d", idx), type);
+		cell->connections["\\clk"] = sig_clk;
+		cell->connections["\\in"] = take_source();
+		cell->connections["\\out"] = out;
+		add_source(out);
+	}
+
+	// the logic cells are generated until the cells of the final $xor tree
+	// (one less than the number of live sources) make up the budget
+	void generate(int budget, const std::vector<RTLIL::IdString> &children)
+	{
+		add_source(sig_in);
+
+		// memories, FSMs and instances are placed at random positions between the logic cells
+		int num_blocks = cfg.num_memories + cfg.num_fsms + children.size();
+		std::vector<int> block_pos, block_order;
+		for (int i = 0; i < num_blocks; i++) {
+			block_pos.push_back(random(std::max(budget, 1)));
+			block_order.push_back(i);
+			std::swap(block_order[i], block_order[random(i + 1)]);
+		}
+		std::sort(block_pos.begin(), block_pos.end());
+
+		for (int i = 0, pos = 0; i < num_blocks || num_cells + num_live_signals - 1 < budget; ) {
+			if (i < num_blocks && block_pos[i] <= pos) {
+				int idx = block_order[i];
+				if (idx < cfg.num_memories)
+					gen_memory(idx);
+				else if (idx < cfg.num_memories + cfg.num_fsms)
+					gen_fsm(idx - cfg.num_memories);
+				else
+					gen_instance(children[idx - cfg.num_memories - cfg.num_fsms], idx - cfg.num_memories - cfg.num_fsms);
+				i++;
+			} else {
+				gen_logic_cell();
+				pos++;
+			}
+		}
+
+		std::vector<RTLIL::SigSpec> outputs;
+		for (size_t i = 0; i < signals.size(); i++)
+			if (refcount[i] > 0)
+				outputs.push_back(signals[i]);
+		while (outputs.size() > 1) {
+			std::vector<RTLIL::SigSpec> next_outputs;
+			for (size_t i = 0; i+1 < outputs.size(); i += 2)
+				next_outputs.push_back(add_binary("$xor", outputs[i], outputs[i+1], cfg.width));
+			if (outputs.size() % 2)
+				next_outputs.push_back(outputs.back());
+			outputs.swap(next_outputs);
+		}
+
+		RTLIL::Wire *wire = module->addWire("\\out", cfg.width);
+		wire->port_output = true;
+		module->connect(RTLIL::SigSig(RTLIL::SigSpec(wire), outputs.front()));
+		module->fixup_ports();
+	}
+};
+
+struct DesignGenerator
+{
+	const GenDesignConfig &cfg;
+	RTLIL::Design *design;
+	int cells_per_module;
+	std::map<int, RTLIL::IdString> shared_modules;
+	int num_modules, total_cells;
+
+	DesignGenerator(const GenDesignConfig &cfg, RTLIL::Design *design) : cfg(cfg), design(design), num_modules(0), total_cells(0)
+	{
+		int num_instances = 0;
+		for (int d = 0, n = 1; d <= cfg.depth; d++, n *= cfg.branch)
+			num_instances += n;
+		cells_per_module = std::max(1, cfg.num_cells / num_instances);
+	}
+
+	// returns the name of a module at the given level of the hierarchy
+	RTLIL::IdString gen_module(int level, RTLIL::IdString name)
+	{
+		if (!cfg.unique && shared_modules.count(level))
+			return shared_modules.at(level);
+
+		std::vector<RTLIL::IdString> children;
+		if (level < cfg.depth)
+			for (int i = 0; i < cfg.branch; i++)
+				children.push_back(gen_module(level + 1, cfg.unique ?
+						stringf("%s_%d", name.c_str(), i) : stringf("%s_l%d", cfg.top.c_str(), level + 1)));
+
+		if (design->modules.count(name) != 0)
+			log_cmd_error("Module `%s' already exists in the design.\n", RTLIL::id2cstr(name));
+
+		RTLIL::Module *module = new RTLIL::Module;
+		module->name = name;
+		design->modules[module->name] = module;
+
+		ModuleGenerator generator(cfg, module, cfg.seed * 1000003 + num_modules);
+		generator.generate(cells_per_module, children);
+
+		log("Generated module %s with %d cells and %d instances.\n", RTLIL::id2cstr(name), generator.num_cells, int(children.size()));
+		num_modules++;
+		total_cells += generator.num_cells;
+
+		if (!cfg.unique)
+			shared_modules[level] = name;
+		return name;
+	}
+};
+
+} /* namespace */
+
+struct GenDesignPass : public Pass {
+	GenDesignPass() : Pass("gen_design", "generate a synthetic design for benchmarks") { }
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    gen_design [options]\n");
+		log("\n");
+		log("This command adds a randomly generated design to the current design. It is\n");
+		log("used to measure how the run time and memory usage of the passes scale with\n");
+		log("the size of the design. The generated design consists of internal cells\n");
+		log("($add, $sub, $and, $or, $xor, $shl, $eq, $lt, $mux, $dff, $memwr, $memrd)\n");
+		log("with data signals of a fixed width. Every module has the ports 'clk', 'in'\n");
+		log("and 'out'.\n");
+		log("\n");
+		log("    -top <name>\n");
+		log("        the name of the top module (default: gen_top). The names of the\n");
+		log("        submodules are derived from this name.\n");
+		log("\n");
+		log("    -cells <num>\n");
+		log("        the total number of cells in the flattened design (default: 10000).\n");
+		log("        The cells are distributed evenly over all module instances. The\n");
+		log("        memory and FSM cells come on top of that.\n");
+		log("\n");
+		log("    -width <bits>\n");
+		log("        the width of the data signals (default: 16)\n");
+		log("\n");
+		log("    -fanout <num>\n");
+		log("        the average number of cell inputs driven by each cell output. The\n");
+		log("        number of readers is uniformly distributed between 1 and 2*num-1.\n");
+		log("        When the cells need more inputs than that, random earlier signals get\n");
+		log("        additional readers. (default: 2)\n");
+		log("\n");
+		log("    -ffs <percent>\n");
+		log("        the percentage of the logic cells that are $dff cells (default: 10)\n");
+		log("\n");
+		log("    -depth <num>\n");
+		log("    -branch <num>\n");
+		log("        the number of hierarchy levels below the top module (default: 0) and\n");
+		log("        the number of submodule instances in each non-leaf module (default: 2)\n");
+		log("\n");
+		log("    -unique\n");
+		log("        generate a separate module for each instance. By default all\n");
+		log("        instances on the same level of the hierarchy share one module.\n");
+		log("\n");
+		log("    -memories <num>\n");
+		log("    -abits <bits>\n");
+		log("        the number of memories in each module (default: 0) and the number of\n");
+		log("        address bits of the memories (default: 4). The memories have one\n");
+		log("        synchronous write port and one asynchronous read port.\n");
+		log("\n");
+		log("    -fsms <num>\n");
+		log("    -states <num>\n");
+		log("        the number of FSMs in each module (default: 0) and the number of\n");
+		log("        states of each FSM (default: 8)\n");
+		log("\n");
+		log("    -seed <num>\n");
+		log("        the seed for the random number generator (default: 1)\n");
+		log("\n");
+		log("For example, the following generates a design with one million cells and\n");
+		log("some memories and FSMs in 31 modules and flattens it. (The memories must be\n");
+		log("mapped before flattening, as flatten does not support memories.)\n");
+		log("\n");
+		log("    gen_design -cells 1000000 -depth 4 -unique -memories 2 -fsms 2\n");
+		log("    hierarchy -top gen_top; memory; flatten\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Executing GEN_DESIGN pass (generating a synthetic design).\n");
+
+		GenDesignConfig cfg;
+
+		size_t argidx;
+		for (argidx = 1; argidx < args.size(); argidx++)
+		{
+			std::string arg = args[argidx];
+			if (arg == "-top" && argidx+1 < args.size()) {
+				cfg.top = RTLIL::escape_id(args[++argidx]);
+				continue;
+			}
+			if (arg == "-cells" && argidx+1 < args.size()) {
+				cfg.num_cells = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-width" && argidx+1 < args.size()) {
+				cfg.width = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-fanout" && argidx+1 < args.size()) {
+				cfg.fanout = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-ffs" && argidx+1 < args.size()) {
+				cfg.ff_percent = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-depth" && argidx+1 < args.size()) {
+				cfg.depth = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-branch" && argidx+1 < args.size()) {
+				cfg.branch = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-unique") {
+				cfg.unique = true;
+				continue;
+			}
+			if (arg == "-memories" && argidx+1 < args.size()) {
+				cfg.num_memories = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-abits" && argidx+1 < args.size()) {
+				cfg.mem_abits = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-fsms" && argidx+1 < args.size()) {
+				cfg.num_fsms = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-states" && argidx+1 < args.size()) {
+				cfg.num_states = atoi(args[++argidx].c_str());
+				continue;
+			}
+			if (arg == "-seed" && argidx+1 < args.size()) {
+				cfg.seed = atoi(args[++argidx].c_str());
+				continue;
+			}
+			break;
+		}
+		extra_args(args, argidx, design);
+
+		if (cfg.num_cells < 1 || cfg.width < 1 || cfg.fanout < 1 || cfg.ff_percent < 0 || cfg.ff_percent > 100)
+			log_cmd_error("Invalid -cells, -width, -fanout or -ffs value.\n");
+		if (cfg.depth < 0 || cfg.depth > 20 || cfg.branch < 1)
+			log_cmd_error("Invalid -depth or -branch value.\n");
+		if (cfg.num_memories < 0 || cfg.mem_abits < 1 || cfg.mem_abits > 24 || cfg.num_fsms < 0 || cfg.num_states < 2)
+			log_cmd_error("Invalid -memories, -abits, -fsms or -states value.\n");
+
+		DesignGenerator generator(cfg, design);
+		generator.gen_module(0, cfg.top);
+
+		log("Generated %d modules with %d cells.\n", generator.num_modules, generator.total_cells);
+	}
+} GenDesignPass;
@@ -97,7 +97,7 @@ struct RenamePass : public Pass {
 				if (!design->selected(module))
 					continue;
 
-				std::map<RTLIL::IdString, RTLIL::Wire*> new_wires;
+				hashlib::dict<RTLIL::IdString, RTLIL::Wire*> new_wires;
 				for (auto &it : module->wires) {
 					if (it.first[0] == '$' && design->selected(module, it.second))
 						do it.second->name = stringf("\\_%d_", counter++);
@@ -106,7 +106,7 @@ struct RenamePass : public Pass {
 				}
 				module->wires.swap(new_wires);
 
-				std::map<RTLIL::IdString, RTLIL::Cell*> new_cells;
+				hashlib::dict<RTLIL::IdString, RTLIL::Cell*> new_cells;
 				for (auto &it : module->cells) {
 					if (it.first[0] == '$' && design->selected(module, it.second))
 						do it.second->name = stringf("\\_%d_", counter++);
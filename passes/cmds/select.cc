@@ -22,6 +22,7 @@
 #include "kernel/log.h"
 #include <string.h>
 #include <fnmatch.h>
+#include <algorithm>
 
 using RTLIL::id2cstr;
 
@@ -43,7 +44,7 @@ static bool match_attr_val(const RTLIL::Const &value, std::string pattern)
 	return false;
 }
 
-static bool match_attr(const std::map<RTLIL::IdString, RTLIL::Const> &attributes, std::string name_pat, std::string value_pat, bool use_value_pat)
+static bool match_attr(const hashlib::dict<RTLIL::IdString, RTLIL::Const> &attributes, std::string name_pat, std::string value_pat, bool use_value_pat)
 {
 	if (name_pat.find('*') != std::string::npos || name_pat.find('?') != std::string::npos || name_pat.find('[') != std::string::npos) {
 		for (auto &it : attributes) {
@@ -61,6 +62,18 @@ static bool match_attr(const std::map<RTLIL::IdString, RTLIL::Const> &attributes
 	return false;
 }
 
+static void add_all_members(RTLIL::IdSet &members, RTLIL::Module *mod)
+{
+	for (auto &it : mod->wires)
+		members.insert(it.first);
+	for (auto &it : mod->memories)
+		members.insert(it.first);
+	for (auto &it : mod->cells)
+		members.insert(it.first);
+	for (auto &it : mod->processes)
+		members.insert(it.first);
+}
+
 static void select_op_neg(RTLIL::Design *design, RTLIL::Selection &lhs)
 {
 	if (lhs.full_selection) {
@@ -86,19 +99,11 @@ static void select_op_neg(RTLIL::Design *design, RTLIL::Selection &lhs)
 			continue;
 		}
 
-		RTLIL::Module *mod = mod_it.second;
-		for (auto &it : mod->wires)
-			if (!lhs.selected_member(mod_it.first, it.first))
-				new_sel.selected_members[mod->name].insert(it.first);
-		for (auto &it : mod->memories)
-			if (!lhs.selected_member(mod_it.first, it.first))
-				new_sel.selected_members[mod->name].insert(it.first);
-		for (auto &it : mod->cells)
-			if (!lhs.selected_member(mod_it.first, it.first))
-				new_sel.selected_members[mod->name].insert(it.first);
-		for (auto &it : mod->processes)
-			if (!lhs.selected_member(mod_it.first, it.first))
-				new_sel.selected_members[mod->name].insert(it.first);
+		RTLIL::IdSet members;
+		add_all_members(members, mod_it.second);
+		members -= lhs.selected_members.at(mod_it.first);
+		if (!members.empty())
+			new_sel.selected_members[mod_it.first].swap(members);
 	}
 
 	lhs.selected_modules.swap(new_sel.selected_modules);
@@ -118,13 +123,11 @@ static void select_op_union(RTLIL::Design*, RTLIL::Selection &lhs, const RTLIL::
 		return;
 
 	for (auto &it : rhs.selected_members)
-		for (auto &it2 : it.second)
-			lhs.selected_members[it.first].insert(it2);
+		lhs.selected_members[it.first] |= it.second;
 
-	for (auto &it : rhs.selected_modules) {
-		lhs.selected_modules.insert(it);
+	lhs.selected_modules |= rhs.selected_modules;
+	for (auto it : rhs.selected_modules)
 		lhs.selected_members.erase(it);
-	}
 }
 
 static void select_op_diff(RTLIL::Design *design, RTLIL::Selection &lhs, const RTLIL::Selection &rhs)
@@ -144,10 +147,9 @@ static void select_op_diff(RTLIL::Design *design, RTLIL::Selection &lhs, const R
 			lhs.selected_modules.insert(it.first);
 	}
 
-	for (auto &it : rhs.selected_modules) {
-		lhs.selected_modules.erase(it);
+	lhs.selected_modules -= rhs.selected_modules;
+	for (auto it : rhs.selected_modules)
 		lhs.selected_members.erase(it);
-	}
 
 	for (auto &it : rhs.selected_members)
 	{
@@ -156,24 +158,15 @@ static void select_op_diff(RTLIL::Design *design, RTLIL::Selection &lhs, const R
 
 		RTLIL::Module *mod = design->modules[it.first];
 
-		if (lhs.selected_modules.count(mod->name) > 0)
-		{
-			for (auto &it : mod->wires)
-				lhs.selected_members[mod->name].insert(it.first);
-			for (auto &it : mod->memories)
-				lhs.selected_members[mod->name].insert(it.first);
-			for (auto &it : mod->cells)
-				lhs.selected_members[mod->name].insert(it.first);
-			for (auto &it : mod->processes)
-				lhs.selected_members[mod->name].insert(it.first);
+		if (lhs.selected_modules.count(mod->name) > 0) {
+			add_all_members(lhs.selected_members[mod->name], mod);
 			lhs.selected_modules.erase(mod->name);
 		}
 
 		if (lhs.selected_members.count(mod->name) == 0)
 			continue;
 
-		for (auto &it2 : it.second)
-			lhs.selected_members[mod->name].erase(it2);
+		lhs.selected_members[mod->name] -= it.second;
 	}
 }
 
@@ -188,19 +181,12 @@ static void select_op_intersect(RTLIL::Design *design, RTLIL::Selection &lhs, co
 			lhs.selected_modules.insert(it.first);
 	}
 
-	std::vector<RTLIL::IdString> del_list;
-
-	for (auto &it : lhs.selected_modules)
-		if (rhs.selected_modules.count(it) == 0) {
-			if (rhs.selected_members.count(it) > 0)
-				for (auto &it2 : rhs.selected_members.at(it))
-					lhs.selected_members[it].insert(it2);
-			del_list.push_back(it);
-		}
-	for (auto &it : del_list)
-		lhs.selected_modules.erase(it);
+	for (auto it : lhs.selected_modules)
+		if (rhs.selected_modules.count(it) == 0 && rhs.selected_members.count(it) > 0)
+			lhs.selected_members[it] |= rhs.selected_members.at(it);
+	lhs.selected_modules &= rhs.selected_modules;
 
-	del_list.clear();
+	std::vector<RTLIL::IdString> del_list;
 	for (auto &it : lhs.selected_members) {
 		if (rhs.selected_modules.count(it.first) > 0)
 			continue;
@@ -208,12 +194,7 @@ static void select_op_intersect(RTLIL::Design *design, RTLIL::Selection &lhs, co
 			del_list.push_back(it.first);
 			continue;
 		}
-		std::vector<RTLIL::IdString> del_list2;
-		for (auto &it2 : it.second)
-			if (rhs.selected_members.at(it.first).count(it2) == 0)
-				del_list2.push_back(it2);
-		for (auto &it2 : del_list2)
-			it.second.erase(it2);
+		it.second &= rhs.selected_members.at(it.first);
 		if (it.second.size() == 0)
 			del_list.push_back(it.first);
 	}
@@ -254,10 +235,11 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 			continue;
 
 		RTLIL::Module *mod = mod_it.second;
+		RTLIL::IdSet &members = lhs.selected_members.at(mod->name);
 		std::set<RTLIL::Wire*> selected_wires;
 
 		for (auto &it : mod->wires)
-			if (lhs.selected_member(mod_it.first, it.first) && limits.count(it.first) == 0)
+			if (members.count(it.first) > 0 && limits.count(it.first) == 0)
 				selected_wires.insert(it.second);
 
 		for (auto &cell : mod->cells)
@@ -282,12 +264,12 @@ static int select_op_expand(RTLIL::Design *design, RTLIL::Selection &lhs, std::v
 			is_output = mode == 'x' || ct.cell_output(cell.second->type, conn.first);
 			for (auto &chunk : conn.second.chunks)
 				if (chunk.wire != NULL) {
-					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && lhs.selected_members[mod->name].count(cell.first) == 0)
+					if (max_objects != 0 && selected_wires.count(chunk.wire) > 0 && members.count(cell.first) == 0)
 						if (mode == 'x' || (mode == 'i' && is_output) || (mode == 'o' && is_input))
-							lhs.selected_members[mod->name].insert(cell.first), sel_objects++, max_objects--;
-					if (max_objects != 0 && lhs.selected_members[mod->name].count(cell.first) > 0 && limits.count(cell.first) == 0 && lhs.selected_members[mod->name].count(chunk.wire->name) == 0)
+							members.insert(cell.first), sel_objects++, max_objects--;
+					if (max_objects != 0 && members.count(cell.first) > 0 && limits.count(cell.first) == 0 && members.count(chunk.wire->name) == 0)
 						if (mode == 'x' || (mode == 'i' && is_input) || (mode == 'o' && is_output))
-							lhs.selected_members[mod->name].insert(chunk.wire->name), sel_objects++, max_objects--;
+							members.insert(chunk.wire->name), sel_objects++, max_objects--;
 				}
 		exclude_match:;
 		}
@@ -351,7 +333,7 @@ static void select_op_expand(RTLIL::Design *design, std::string arg, char mode)
 				if (str[0] == '@') {
 					str = RTLIL::escape_id(str.substr(1));
 					if (design->selection_vars.count(str) > 0) {
-						for (auto i1 : design->selection_vars.at(str).selected_members)
+						for (auto &i1 : design->selection_vars.at(str).selected_members)
 						for (auto i2 : i1.second)
 							limits.insert(i2);
 					}
@@ -620,7 +602,7 @@ void handle_extra_select_args(Pass *pass, std::vector<std::string> args, size_t
 }
 
 struct SelectPass : public Pass {
-	SelectPass() : Pass("select", "modify and view the list of selected objects") { }
+	SelectPass() : Pass("select", "modify and view the list of selected objects") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -926,11 +908,15 @@ struct SelectPass : public Pass {
 			RTLIL::Selection &sel = design->selection_stack.back();
 			if (sel.full_selection)
 				log("*\n");
-			for (auto &it : sel.selected_modules)
+			for (auto &it : sel.selected_modules.sorted())
 				log("%s\n", id2cstr(it));
+			std::vector<RTLIL::IdString> partial_modules;
 			for (auto &it : sel.selected_members)
-				for (auto &it2 : it.second)
-					log("%s/%s\n", id2cstr(it.first), id2cstr(it2));
+				partial_modules.push_back(it.first);
+			std::sort(partial_modules.begin(), partial_modules.end());
+			for (auto &it : partial_modules)
+				for (auto &it2 : sel.selected_members.at(it).sorted())
+					log("%s/%s\n", id2cstr(it), id2cstr(it2));
 			return;
 		}
 
@@ -940,7 +926,7 @@ struct SelectPass : public Pass {
 } SelectPass;
  
 struct CdPass : public Pass {
-	CdPass() : Pass("cd", "a shortcut for 'select -module <name>'") { }
+	CdPass() : Pass("cd", "a shortcut for 'select -module <name>'") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -995,7 +981,7 @@ struct CdPass : public Pass {
 } CdPass;
  
 struct LsPass : public Pass {
-	LsPass() : Pass("ls", "list modules or objects in modules") { }
+	LsPass() : Pass("ls", "list modules or objects in modules") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -0,0 +1,260 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ */
+
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/log.h"
+#include <map>
+
+namespace {
+
+// the memory estimates count the objects and the heap memory owned by their
+// members, but not the (shared) IdString pool and not the malloc overhead
+struct StatData
+{
+	int num_wires, num_wire_bits, num_pub_wires, num_pub_wire_bits;
+	int num_memories, num_memory_bits, num_processes, num_cells;
+	int num_chunks;
+	std::map<std::string, int> num_cells_by_type;
+
+	size_t mem_wires, mem_memories, mem_cells, mem_cell_ports, mem_cell_params;
+	size_t mem_connections, mem_processes, mem_containers, mem_arena;
+
+	StatData()
+	{
+		num_wires = num_wire_bits = num_pub_wires = num_pub_wire_bits = 0;
+		num_memories = num_memory_bits = num_processes = num_cells = 0;
+		num_chunks = 0;
+		mem_wires = mem_memories = mem_cells = mem_cell_ports = mem_cell_params = 0;
+		mem_connections = mem_processes = mem_containers = mem_arena = 0;
+	}
+
+	StatData &operator+=(const StatData &other)
+	{
+		num_wires += other.num_wires;
+		num_wire_bits += other.num_wire_bits;
+		num_pub_wires += other.num_pub_wires;
+		num_pub_wire_bits += other.num_pub_wire_bits;
+		num_memories += other.num_memories;
+		num_memory_bits += other.num_memory_bits;
+		num_processes += other.num_processes;
+		num_cells += other.num_cells;
+		num_chunks += other.num_chunks;
+		for (auto &it : other.num_cells_by_type)
+			num_cells_by_type[it.first] += it.second;
+		mem_wires += other.mem_wires;
+		mem_memories += other.mem_memories;
+		mem_cells += other.mem_cells;
+		mem_cell_ports += other.mem_cell_ports;
+		mem_cell_params += other.mem_cell_params;
+		mem_connections += other.mem_connections;
+		mem_processes += other.mem_processes;
+		mem_containers += other.mem_containers;
+		mem_arena += other.mem_arena;
+		return *this;
+	}
+
+	size_t const_size(const RTLIL::Const &data)
+	{
+		return data.str.size() + data.bits.capacity() * sizeof(RTLIL::State);
+	}
+
+	size_t attributes_size(const hashlib::dict<RTLIL::IdString, RTLIL::Const> &attributes)
+	{
+		size_t size = attributes.memory_usage();
+		for (auto &it : attributes)
+			size += const_size(it.second);
+		return size;
+	}
+
+	size_t sigspec_size(const RTLIL::SigSpec &sig)
+	{
+		size_t size = sig.chunks.capacity() * sizeof(RTLIL::SigChunk);
+		for (auto &chunk : sig.chunks)
+			if (chunk.wire == NULL)
+				size += const_size(chunk.data);
+		num_chunks += sig.chunks.size();
+		return size;
+	}
+
+	size_t sigsig_list_size(const std::vector<RTLIL::SigSig> &list)
+	{
+		size_t size = list.capacity() * sizeof(RTLIL::SigSig);
+		for (auto &it : list)
+			size += sigspec_size(it.first) + sigspec_size(it.second);
+		return size;
+	}
+
+	size_t case_size(const RTLIL::CaseRule *cs)
+	{
+		size_t size = cs->compare.capacity() * sizeof(RTLIL::SigSpec);
+		for (auto &sig : cs->compare)
+			size += sigspec_size(sig);
+		size += sigsig_list_size(cs->actions);
+		size += cs->switches.capacity() * sizeof(RTLIL::SwitchRule*);
+		for (auto sw : cs->switches) {
+			size += sizeof(RTLIL::SwitchRule) + attributes_size(sw->attributes) + sigspec_size(sw->signal);
+			size += sw->cases.capacity() * sizeof(RTLIL::CaseRule*);
+			for (auto it : sw->cases)
+				size += sizeof(RTLIL::CaseRule) + case_size(it);
+		}
+		return size;
+	}
+
+	StatData(RTLIL::Design *design, RTLIL::Module *module) : StatData()
+	{
+		for (auto &it : module->wires) {
+			if (!design->selected(module, it.second))
+				continue;
+			num_wires++;
+			num_wire_bits += it.second->width;
+			if (it.first[0] == '\\') {
+				num_pub_wires++;
+				num_pub_wire_bits += it.second->width;
+			}
+			mem_wires += sizeof(RTLIL::Wire) + sizeof(Arena::header_t) + attributes_size(it.second->attributes);
+		}
+
+		for (auto &it : module->memories) {
+			if (!design->selected(module, it.second))
+				continue;
+			num_memories++;
+			num_memory_bits += it.second->width * it.second->size;
+			mem_memories += sizeof(RTLIL::Memory) + attributes_size(it.second->attributes);
+		}
+
+		for (auto &it : module->cells) {
+			if (!design->selected(module, it.second))
+				continue;
+			RTLIL::Cell *cell = it.second;
+			num_cells++;
+			num_cells_by_type[cell->type]++;
+			mem_cells += sizeof(RTLIL::Cell) + sizeof(Arena::header_t) + attributes_size(cell->attributes);
+			mem_cell_ports += cell->connections.memory_usage();
+			for (auto &it2 : cell->connections)
+				mem_cell_ports += sigspec_size(it2.second);
+			mem_cell_params += cell->parameters.memory_usage();
+			for (auto &it2 : cell->parameters)
+				mem_cell_params += const_size(it2.second);
+		}
+
+		for (auto &it : module->processes) {
+			if (!design->selected(module, it.second))
+				continue;
+			RTLIL::Process *proc = it.second;
+			num_processes++;
+			mem_processes += sizeof(RTLIL::Process) + attributes_size(proc->attributes) + case_size(&proc->root_case);
+			mem_processes += proc->syncs.capacity() * sizeof(RTLIL::SyncRule*);
+			for (auto sync : proc->syncs)
+				mem_processes += sizeof(RTLIL::SyncRule) + sigspec_size(sync->signal) + sigsig_list_size(sync->actions);
+		}
+
+		if (design->selected_whole_module(module->name)) {
+			mem_connections += sigsig_list_size(module->connections);
+			mem_containers += sizeof(RTLIL::Module) + attributes_size(module->attributes);
+			mem_containers += module->wires.memory_usage() + module->memories.memory_usage();
+			mem_containers += module->cells.memory_usage() + module->processes.memory_usage();
+			if (module->arena != NULL)
+				mem_arena += module->arena->total_size;
+		}
+	}
+
+	void log_data()
+	{
+		log("   Number of wires:             %6d\n", num_wires);
+		log("   Number of wire bits:         %6d\n", num_wire_bits);
+		log("   Number of public wires:      %6d\n", num_pub_wires);
+		log("   Number of public wire bits:  %6d\n", num_pub_wire_bits);
+		log("   Number of memories:          %6d\n", num_memories);
+		log("   Number of memory bits:       %6d\n", num_memory_bits);
+		log("   Number of processes:         %6d\n", num_processes);
+		log("   Number of cells:             %6d\n", num_cells);
+		for (auto &it : num_cells_by_type)
+			log("     %-26s %6d\n", RTLIL::id2cstr(it.first), it.second);
+		log("   Number of SigChunks:         %6d\n", num_chunks);
+		log("\n");
+
+		size_t total = mem_wires + mem_memories + mem_cells + mem_cell_ports + mem_cell_params +
+				mem_connections + mem_processes + mem_containers;
+		log("   Estimated memory usage:      %8.1f kB\n", total / 1024.0);
+		log("     wires                      %8.1f kB\n", mem_wires / 1024.0);
+		log("     memories                   %8.1f kB\n", mem_memories / 1024.0);
+		log("     cells                      %8.1f kB\n", mem_cells / 1024.0);
+		log("     cell ports                 %8.1f kB\n", mem_cell_ports / 1024.0);
+		log("     cell parameters            %8.1f kB\n", mem_cell_params / 1024.0);
+		log("     connections                %8.1f kB\n", mem_connections / 1024.0);
+		log("     processes                  %8.1f kB\n", mem_processes / 1024.0);
+		log("     module containers          %8.1f kB\n", mem_containers / 1024.0);
+		if (mem_arena > 0)
+			log("   Arena blocks (wires, cells): %8.1f kB\n", mem_arena / 1024.0);
+	}
+};
+
+} /* namespace */
+
+struct StatPass : public Pass {
+	StatPass() : Pass("stat", "print some statistics") {
+		modifies_design = false;
+	}
+	virtual void help()
+	{
+		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
+		log("\n");
+		log("    stat [selection]\n");
+		log("\n");
+		log("Print some statistics (number of objects, cells by type, etc.) on the selected\n");
+		log("portion of the design, together with an estimate of the memory used by the\n");
+		log("RTLIL data structures. The memory estimate does not include the memory used for\n");
+		log("the names of the objects, which are shared by all modules.\n");
+		log("\n");
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Printing statistics.\n");
+
+		extra_args(args, 1, design);
+
+		StatData design_data;
+		int num_modules = 0;
+
+		for (auto &it : design->modules)
+		{
+			if (!design->selected_module(it.first))
+				continue;
+
+			StatData data(design, it.second);
+			log("\n");
+			log("=== %s%s ===\n", RTLIL::id2cstr(it.first), design->selected_whole_module(it.first) ? "" : " (partially selected)");
+			log("\n");
+			data.log_data();
+
+			design_data += data;
+			num_modules++;
+		}
+
+		if (num_modules > 1) {
+			log("\n");
+			log("=== design (%d modules) ===\n", num_modules);
+			log("\n");
+			design_data.log_data();
+		}
+
+		log("\n");
+	}
+} StatPass;
@@ -36,7 +36,7 @@ namespace
 	public:
 		std::set<RTLIL::IdString> cell_attr, wire_attr;
 
-		bool compareAttributes(const std::set<RTLIL::IdString> &attr, const std::map<RTLIL::IdString, RTLIL::Const> &needleAttr, const std::map<RTLIL::IdString, RTLIL::Const> &haystackAttr)
+		bool compareAttributes(const std::set<RTLIL::IdString> &attr, const hashlib::dict<RTLIL::IdString, RTLIL::Const> &needleAttr, const hashlib::dict<RTLIL::IdString, RTLIL::Const> &haystackAttr)
 		{
 			for (auto &it : attr) {
 				size_t nc = needleAttr.count(it), hc = haystackAttr.count(it);
@@ -59,7 +59,7 @@ namespace
 			{
 				RTLIL::Wire *lastNeedleWire = NULL;
 				RTLIL::Wire *lastHaystackWire = NULL;
-				std::map<RTLIL::IdString, RTLIL::Const> emptyAttr;
+				hashlib::dict<RTLIL::IdString, RTLIL::Const> emptyAttr;
 
 				for (auto &conn : needleCell->connections)
 				{
@@ -23,7 +23,7 @@
 #include <stdio.h>
 
 struct FsmPass : public Pass {
-	FsmPass() : Pass("fsm", "extract and optimize finite state machines") { }
+	FsmPass() : Pass("fsm", "extract and optimize finite state machines") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
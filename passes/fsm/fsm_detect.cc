@@ -109,7 +109,7 @@ static void detect_fsm(RTLIL::Wire *wire)
 }
 
 struct FsmDetectPass : public Pass {
-	FsmDetectPass() : Pass("fsm_detect", "finding FSMs in design") { }
+	FsmDetectPass() : Pass("fsm_detect", "finding FSMs in design") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
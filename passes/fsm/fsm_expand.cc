@@ -239,7 +239,7 @@ struct FsmExpand
 };
 
 struct FsmExpandPass : public Pass {
-	FsmExpandPass() : Pass("fsm_expand", "expand FSM cells by merging logic into it") { }
+	FsmExpandPass() : Pass("fsm_expand", "expand FSM cells by merging logic into it") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -50,7 +50,7 @@ std::string kiss_convert_signal(const RTLIL::SigSpec &sig) {
  * @param cell pointer to the FSM cell which should be exported.
  */
 void write_kiss2(struct RTLIL::Module *module, struct RTLIL::Cell *cell, std::string filename, bool origenc) {
-	std::map<RTLIL::IdString, RTLIL::Const>::iterator attr_it;
+	hashlib::dict<RTLIL::IdString, RTLIL::Const>::iterator attr_it;
 	FsmData fsm_data;
 	FsmData::transition_t tr;
 	std::ofstream kiss_file;
@@ -65,7 +65,7 @@ void write_kiss2(struct RTLIL::Module *module, struct RTLIL::Cell *cell, std::st
 	}
 	else {
 		kiss_name.assign(module->name);
-		kiss_name.append('-' + cell->name + ".kiss2");
+		kiss_name.append("-" + cell->name + ".kiss2");
 	}
 
 	log("\n");
@@ -120,7 +120,7 @@ void write_kiss2(struct RTLIL::Module *module, struct RTLIL::Cell *cell, std::st
  * only the KISS2 file format is supported.
  */
 struct FsmExportPass : public Pass {
-	FsmExportPass() : Pass("fsm_export", "exporting FSMs to KISS2 files") { }
+	FsmExportPass() : Pass("fsm_export", "exporting FSMs to KISS2 files") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -146,7 +146,7 @@ struct FsmExportPass : public Pass {
 	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
-		std::map<RTLIL::IdString, RTLIL::Const>::iterator attr_it;
+		hashlib::dict<RTLIL::IdString, RTLIL::Const>::iterator attr_it;
 		std::string arg;
 		bool flag_noauto = false;
 		std::string filename;
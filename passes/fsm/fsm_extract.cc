@@ -32,7 +32,8 @@
 static RTLIL::Module *module;
 static SigMap assign_map;
 typedef std::pair<std::string, std::string> sig2driver_entry_t;
-static SigSet<sig2driver_entry_t> sig2driver, sig2trigger;
+static SigBitIndex bit_index;
+static DenseSigSet<sig2driver_entry_t> sig2driver(&bit_index), sig2trigger(&bit_index);
 
 static bool find_states(RTLIL::SigSpec sig, const RTLIL::SigSpec &dff_out, RTLIL::SigSpec &ctrl, std::map<RTLIL::Const, int> &states, RTLIL::Const *reset_state = NULL)
 {
@@ -321,7 +322,7 @@ static void extract_fsm(RTLIL::Wire *wire)
 }
 
 struct FsmExtractPass : public Pass {
-	FsmExtractPass() : Pass("fsm_extract", "extracting FSMs in design") { }
+	FsmExtractPass() : Pass("fsm_extract", "extracting FSMs in design") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -356,6 +357,7 @@ struct FsmExtractPass : public Pass {
 
 			module = mod_it.second;
 			assign_map.set(module);
+			bit_index.set(module);
 
 			sig2driver.clear();
 			sig2trigger.clear();
@@ -384,6 +386,7 @@ struct FsmExtractPass : public Pass {
 		}
 
 		assign_map.clear();
+		bit_index.clear();
 		sig2driver.clear();
 		sig2trigger.clear();
 	}
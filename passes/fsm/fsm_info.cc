@@ -26,7 +26,7 @@
 #include <string.h>
 
 struct FsmInfoPass : public Pass {
-	FsmInfoPass() : Pass("fsm_info", "print information on finite state machines") { }
+	FsmInfoPass() : Pass("fsm_info", "print information on finite state machines") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
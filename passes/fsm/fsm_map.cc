@@ -170,7 +170,7 @@ static void map_fsm(RTLIL::Cell *fsm_cell, RTLIL::Module *module)
 	RTLIL::Wire *state_wire = new RTLIL::Wire;
 	state_wire->name = fsm_cell->parameters["\\NAME"].str;
 	while (module->count_id(state_wire->name) > 0)
-		state_wire->name += "_";
+		state_wire->name = state_wire->name + "_";
 	state_wire->width = fsm_data.state_bits;
 	module->add(state_wire);
 
@@ -345,7 +345,7 @@ static void map_fsm(RTLIL::Cell *fsm_cell, RTLIL::Module *module)
 }
 
 struct FsmMapPass : public Pass {
-	FsmMapPass() : Pass("fsm_map", "mapping FSMs to basic logic") { }
+	FsmMapPass() : Pass("fsm_map", "mapping FSMs to basic logic") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -269,7 +269,7 @@ void FsmData::optimize_fsm(RTLIL::Cell *cell, RTLIL::Module *module)
 }
 
 struct FsmOptPass : public Pass {
-	FsmOptPass() : Pass("fsm_opt", "optimize finite state machines") { }
+	FsmOptPass() : Pass("fsm_opt", "optimize finite state machines") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
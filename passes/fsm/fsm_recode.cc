@@ -103,7 +103,7 @@ static void fsm_recode(RTLIL::Cell *cell, RTLIL::Module *module, FILE *fm_set_fs
 }
 
 struct FsmRecodePass : public Pass {
-	FsmRecodePass() : Pass("fsm_recode", "recoding finite state machines") { }
+	FsmRecodePass() : Pass("fsm_recode", "recoding finite state machines") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
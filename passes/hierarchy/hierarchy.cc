@@ -150,7 +150,7 @@ static bool expand_module(RTLIL::Design *design, RTLIL::Module *module, bool fla
 		if (design->modules.at(cell->type)->get_bool_attribute("\\placeholder"))
 			continue;
 		RTLIL::Module *mod = design->modules[cell->type];
-		cell->type = mod->derive(design, cell->parameters);
+		cell->type = mod->derive(design, std::map<RTLIL::IdString, RTLIL::Const>(cell->parameters.begin(), cell->parameters.end()));
 		cell->parameters.clear();
 		did_something = true;
 	}
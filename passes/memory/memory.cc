@@ -23,7 +23,7 @@
 #include <stdio.h>
 
 struct MemoryPass : public Pass {
-	MemoryPass() : Pass("memory", "translate memories to basic cells") { }
+	MemoryPass() : Pass("memory", "translate memories to basic cells") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -106,7 +106,7 @@ static void handle_memory(RTLIL::Module *module, RTLIL::Memory *memory)
 	}
 
 	std::stringstream sstr;
-	sstr << "$mem$" << memory->name << "$" << (RTLIL::autoidx++);
+	sstr << "$mem$" << memory->name.str() << "$" << (RTLIL::autoidx++);
 
 	RTLIL::Cell *mem = new RTLIL::Cell;
 	mem->name = sstr.str();
@@ -176,7 +176,7 @@ static void handle_module(RTLIL::Design *design, RTLIL::Module *module)
 }
 
 struct MemoryCollectPass : public Pass {
-	MemoryCollectPass() : Pass("memory_collect", "creating multi-port memory cells") { }
+	MemoryCollectPass() : Pass("memory_collect", "creating multi-port memory cells") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -63,13 +63,14 @@ static void handle_cell(RTLIL::Module *module, RTLIL::Cell *cell)
 	}
 
 	// all write ports must share the same clock
-	RTLIL::SigSpec clocks = cell->connections["\\WR_CLK"];
-	RTLIL::Const clocks_pol = cell->parameters["\\WR_CLK_POLARITY"];
-	RTLIL::Const clocks_en = cell->parameters["\\WR_CLK_ENABLE"];
+	const RTLIL::SigSpec &clocks = cell->connections["\\WR_CLK"];
+	const RTLIL::Const &clocks_pol = cell->parameters["\\WR_CLK_POLARITY"];
+	const RTLIL::Const &clocks_en = cell->parameters["\\WR_CLK_ENABLE"];
+	const RTLIL::SigSpec &wr_en_all = cell->connections["\\WR_EN"];
 	RTLIL::SigSpec refclock;
 	RTLIL::State refclock_pol = RTLIL::State::Sx;
 	for (int i = 0; i < clocks.width; i++) {
-		RTLIL::SigSpec wr_en = cell->connections["\\WR_EN"].extract(i, 1);
+		RTLIL::SigSpec wr_en = wr_en_all.extract(i, 1);
 		if (wr_en.is_fully_const() && wr_en.as_int() == 0) {
 			static_ports.insert(i);
 			continue;
@@ -242,6 +243,15 @@ static void handle_cell(RTLIL::Module *module, RTLIL::Cell *cell)
 
 	log("  read interface: %d $dff and %d $mux cells.\n", count_dff, count_mux);
 
+	// the write port signals are the same for all memory words
+	int wr_ports = cell->parameters["\\WR_PORTS"].as_int();
+	std::vector<RTLIL::SigSpec> wr_addr_sigs, wr_data_sigs, wr_en_sigs;
+	for (int j = 0; j < wr_ports; j++) {
+		wr_addr_sigs.push_back(cell->connections["\\WR_ADDR"].extract(j*mem_abits, mem_abits));
+		wr_data_sigs.push_back(cell->connections["\\WR_DATA"].extract(j*mem_width, mem_width));
+		wr_en_sigs.push_back(cell->connections["\\WR_EN"].extract(j, 1));
+	}
+
 	for (int i = 0; i < mem_size; i++)
 	{
 		if (static_cells_map.count(i) > 0)
@@ -249,11 +259,11 @@ static void handle_cell(RTLIL::Module *module, RTLIL::Cell *cell)
 
 		RTLIL::SigSpec sig = data_reg_out[i];
 
-		for (int j = 0; j < cell->parameters["\\WR_PORTS"].as_int(); j++)
+		for (int j = 0; j < wr_ports; j++)
 		{
-			RTLIL::SigSpec wr_addr = cell->connections["\\WR_ADDR"].extract(j*mem_abits, mem_abits);
-			RTLIL::SigSpec wr_data = cell->connections["\\WR_DATA"].extract(j*mem_width, mem_width);
-			RTLIL::SigSpec wr_en = cell->connections["\\WR_EN"].extract(j, 1);
+			const RTLIL::SigSpec &wr_addr = wr_addr_sigs[j];
+			const RTLIL::SigSpec &wr_data = wr_data_sigs[j];
+			const RTLIL::SigSpec &wr_en = wr_en_sigs[j];
 
 			RTLIL::Cell *c = new RTLIL::Cell;
 			c->name = genid(cell->name, "$wreq", i, "", j);
@@ -328,7 +338,7 @@ static void handle_module(RTLIL::Design *design, RTLIL::Module *module)
 }
 
 struct MemoryMapPass : public Pass {
-	MemoryMapPass() : Pass("memory_map", "translate multiport memories to basic cells") { }
+	MemoryMapPass() : Pass("memory_map", "translate multiport memories to basic cells") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
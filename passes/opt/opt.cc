@@ -23,10 +23,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-bool OPT_DID_SOMETHING;
+std::atomic<bool> OPT_DID_SOMETHING;
 
 struct OptPass : public Pass {
-	OptPass() : Pass("opt", "perform simple optimizations") { }
+	OptPass() : Pass("opt", "perform simple optimizations") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -20,6 +20,7 @@
 #include "opt_status.h"
 #include "kernel/register.h"
 #include "kernel/sigtools.h"
+#include "kernel/modindex.h"
 #include "kernel/log.h"
 #include "kernel/celltypes.h"
 #include <stdlib.h>
@@ -30,23 +31,15 @@
 using RTLIL::id2cstr;
 
 static CellTypes ct, ct_reg;
-static int count_rm_cells, count_rm_wires;
+static std::atomic<int> count_rm_cells, count_rm_wires;
 
-static void rmunused_module_cells(RTLIL::Module *module, bool verbose)
+static bool rmunused_module_cells(RTLIL::Module *module, bool verbose)
 {
-	SigMap assign_map(module);
+	ModIndex *index = ModIndex::get(module);
 	std::set<RTLIL::Cell*, RTLIL::sort_by_name<RTLIL::Cell>> queue, unused;
 
-	SigSet<RTLIL::Cell*> wire2driver;
 	for (auto &it : module->cells) {
 		RTLIL::Cell *cell = it.second;
-		for (auto &it2 : cell->connections) {
-			if (!ct.cell_input(cell->type, it2.first)) {
-				RTLIL::SigSpec sig = it2.second;
-				assign_map.apply(sig);
-				wire2driver.insert(sig, cell);
-			}
-		}
 		if (cell->type == "$memwr" || cell->get_bool_attribute("\\keep"))
 			queue.insert(cell);
 		unused.insert(cell);
@@ -56,9 +49,7 @@ static void rmunused_module_cells(RTLIL::Module *module, bool verbose)
 		RTLIL::Wire *wire = it.second;
 		if (wire->port_output) {
 			std::set<RTLIL::Cell*> cell_list;
-			RTLIL::SigSpec sig = RTLIL::SigSpec(wire);
-			assign_map.apply(sig);
-			wire2driver.find(sig, cell_list);
+			index->query_drivers(RTLIL::SigSpec(wire), cell_list);
 			for (auto cell : cell_list)
 				queue.insert(cell);
 		}
@@ -73,9 +64,7 @@ static void rmunused_module_cells(RTLIL::Module *module, bool verbose)
 			for (auto &it : cell->connections) {
 				if (!ct.cell_output(cell->type, it.first)) {
 					std::set<RTLIL::Cell*> cell_list;
-					RTLIL::SigSpec sig = it.second;
-					assign_map.apply(sig);
-					wire2driver.find(sig, cell_list);
+					index->query_drivers(it.second, cell_list);
 					for (auto cell : cell_list) {
 						if (unused.count(cell) > 0)
 							new_queue.insert(cell);
@@ -88,15 +77,19 @@ static void rmunused_module_cells(RTLIL::Module *module, bool verbose)
 
 	for (auto cell : unused) {
 		if (verbose)
-			log("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
+			log_debug("  removing unused `%s' cell `%s'.\n", cell->type.c_str(), cell->name.c_str());
 		OPT_DID_SOMETHING = true;
-		module->cells.erase(cell->name);
+		module->remove(cell);
 		count_rm_cells++;
-		delete cell;
 	}
+
+	if (verbose && !unused.empty())
+		log("  removed %d unused cells.\n", int(unused.size()));
+
+	return !unused.empty();
 }
 
-static bool compare_signals(RTLIL::SigSpec &s1, RTLIL::SigSpec &s2, SigPool &regs, SigPool &conns)
+static bool compare_signals(RTLIL::SigSpec &s1, RTLIL::SigSpec &s2, const DenseSigPool &regs, const DenseSigPool &conns)
 {
 	assert(s1.width == 1);
 	assert(s2.width == 1);
@@ -142,10 +135,12 @@ static bool check_public_name(RTLIL::IdString id)
 	return true;
 }
 
-static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbose)
+// returns true if the module connections, cell connections or wires changed
+static bool rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool verbose)
 {
-	SigPool register_signals;
-	SigPool connected_signals;
+	SigBitIndex bit_index(module);
+	DenseSigPool register_signals(&bit_index);
+	DenseSigPool connected_signals(&bit_index);
 
 	if (!purge_mode)
 		for (auto &it : module->cells) {
@@ -158,7 +153,7 @@ static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool
 				connected_signals.add(it2.second);
 		}
 
-	SigMap assign_map(module);
+	SigMap assign_map = CachedSigMap::get(module);
 	for (auto &it : module->wires) {
 		RTLIL::Wire *wire = it.second;
 		for (int i = 0; i < wire->width; i++) {
@@ -168,14 +163,19 @@ static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool
 		}
 	}
 
-	module->connections.clear();
+	std::vector<RTLIL::SigSig> old_connections;
+	old_connections.swap(module->connections);
+	bool changed = false;
 
-	SigPool used_signals;
-	SigPool used_signals_nodrivers;
+	DenseSigPool used_signals(&bit_index);
+	DenseSigPool used_signals_nodrivers(&bit_index);
 	for (auto &it : module->cells) {
 		RTLIL::Cell *cell = it.second;
 		for (auto &it2 : cell->connections) {
-			assign_map.apply(it2.second);
+			RTLIL::SigSpec sig = assign_map(it2.second);
+			if (sig != it2.second)
+				changed = true;
+			it2.second = sig;
 			used_signals.add(it2.second);
 			if (!ct.cell_output(cell->type, it2.first))
 				used_signals_nodrivers.add(it2.second);
@@ -201,18 +201,14 @@ static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool
 			if (!used_signals.check_any(s2) && wire->port_id == 0) {
 				del_wires.push_back(wire);
 			} else {
-				s1.expand();
-				s2.expand();
-				assert(s1.chunks.size() == s2.chunks.size());
+				assert(s1.width == s2.width);
 				RTLIL::SigSig new_conn;
-				for (size_t i = 0; i < s1.chunks.size(); i++)
-					if (s1.chunks[i] != s2.chunks[i]) {
-						new_conn.first.append(s1.chunks[i]);
-						new_conn.second.append(s2.chunks[i]);
+				for (auto it1 = s1.begin(), it2 = s2.begin(); it1 != s1.end(); ++it1, ++it2)
+					if (*it1 != *it2) {
+						new_conn.first.append_bit(*it1);
+						new_conn.second.append_bit(*it2);
 					}
 				if (new_conn.first.width > 0) {
-					new_conn.first.optimize();
-					new_conn.second.optimize();
 					used_signals.add(new_conn.first);
 					used_signals.add(new_conn.second);
 					module->connections.push_back(new_conn);
@@ -225,11 +221,11 @@ static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool
 		RTLIL::SigSpec sig = assign_map(RTLIL::SigSpec(wire));
 		if (!used_signals_nodrivers.check_any(sig)) {
 			std::string unused_bits;
-			sig.expand();
-			for (size_t i = 0; i < sig.chunks.size(); i++) {
-				if (sig.chunks[i].wire == NULL)
+			std::vector<RTLIL::SigBit> bits = sig.to_sigbit_vector();
+			for (size_t i = 0; i < bits.size(); i++) {
+				if (bits[i].wire == NULL)
 					continue;
-				if (!used_signals_nodrivers.check_any(sig)) {
+				if (!used_signals_nodrivers.check_any(bits[i])) {
 					if (!unused_bits.empty())
 						unused_bits += " ";
 					unused_bits += stringf("%zd", i);
@@ -244,33 +240,44 @@ static void rmunused_module_signals(RTLIL::Module *module, bool purge_mode, bool
 		}
 	}
 
+	if (module->connections != old_connections)
+		changed = true;
+
 	int del_wires_count = 0;
 	for (auto wire : del_wires)
 		if (!used_signals.check_any(RTLIL::SigSpec(wire))) {
 			if (check_public_name(wire->name) && verbose) {
-				log("  removing unused non-port wire %s.\n", wire->name.c_str());
+				log_debug("  removing unused non-port wire %s.\n", wire->name.c_str());
 				del_wires_count++;
 			}
 			module->wires.erase(wire->name);
 			count_rm_wires++;
 			delete wire;
+			changed = true;
 		}
 
 	if (del_wires_count > 0)
 		log("  removed %d unused temporary wires.\n", del_wires_count);
+
+	return changed;
 }
 
-static void rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose)
+static bool rmunused_module(RTLIL::Module *module, bool purge_mode, bool verbose)
 {
 	if (verbose)
 		log("Finding unused cells or wires in module %s..\n", module->name.c_str());
 
-	rmunused_module_cells(module, verbose);
-	rmunused_module_signals(module, purge_mode, verbose);
+	bool removed_cells = rmunused_module_cells(module, verbose);
+	// cells are removed through the Module API, the signal cleanup edits the
+	// module directly and must tell the monitors if it changed anything
+	if (rmunused_module_signals(module, purge_mode, verbose))
+		module->notify_blackout();
+	return removed_cells;
 }
 
 struct OptCleanPass : public Pass {
-	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { }
+	bool purge_mode;
+	OptCleanPass() : Pass("opt_clean", "remove unused cells and wires") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -288,9 +295,22 @@ struct OptCleanPass : public Pass {
 		log("        also remove internal nets if they have a public name\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		if (!design->selected_whole_module(module->name)) {
+			if (design->selected(module))
+				log("Skipping module %s as it is only partially selected.\n", id2cstr(module->name));
+			return;
+		}
+		if (module->processes.size() > 0) {
+			log("Skipping module %s as it contains processes.\n", module->name.c_str());
+		} else {
+			rmunused_module(module, purge_mode, true);
+		}
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
-		bool purge_mode = false;
+		purge_mode = false;
 
 		log_header("Executing OPT_CLEAN pass (remove unused cells and wires).\n");
 		log_push();
@@ -313,18 +333,7 @@ struct OptCleanPass : public Pass {
 		ct_reg.setup_internals_mem();
 		ct_reg.setup_stdcells_mem();
 
-		for (auto &mod_it : design->modules) {
-			if (!design->selected_whole_module(mod_it.first)) {
-				if (design->selected(mod_it.second))
-					log("Skipping module %s as it is only partially selected.\n", id2cstr(mod_it.second->name));
-				continue;
-			}
-			if (mod_it.second->processes.size() > 0) {
-				log("Skipping module %s as it contains processes.\n", mod_it.second->name.c_str());
-			} else {
-				rmunused_module(mod_it.second, purge_mode, true);
-			}
-		}
+		execute_modules(design);
 
 		ct.clear();
 		ct_reg.clear();
@@ -333,7 +342,8 @@ struct OptCleanPass : public Pass {
 } OptCleanPass;
  
 struct CleanPass : public Pass {
-	CleanPass() : Pass("clean", "remove unused cells and wires") { }
+	bool purge_mode;
+	CleanPass() : Pass("clean", "remove unused cells and wires") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -349,9 +359,14 @@ struct CleanPass : public Pass {
 		log("in -purge mode between the commands.\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		if (design->selected_whole_module(module->name) && module->processes.size() == 0)
+			while (rmunused_module(module, purge_mode, false)) { }
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
-		bool purge_mode = false;
+		purge_mode = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -375,16 +390,10 @@ struct CleanPass : public Pass {
 		count_rm_cells = 0;
 		count_rm_wires = 0;
 
-		for (auto &mod_it : design->modules) {
-			if (design->selected_whole_module(mod_it.first) && mod_it.second->processes.size() == 0)
-				do {
-					OPT_DID_SOMETHING = false;
-					rmunused_module(mod_it.second, purge_mode, false);
-				} while (OPT_DID_SOMETHING);
-		}
+		execute_modules(design);
 
 		if (count_rm_cells > 0 || count_rm_wires > 0)
-			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells, count_rm_wires);
+			log("Removed %d unused cells and %d unused wires.\n", count_rm_cells.load(), count_rm_wires.load());
 
 		ct.clear();
 		ct_reg.clear();
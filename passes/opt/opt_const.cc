@@ -28,7 +28,7 @@
 #include <stdio.h>
 #include <set>
 
-static bool did_something;
+static thread_local bool did_something;
 
 void replace_cell(RTLIL::Module *module, RTLIL::Cell *cell, std::string info, std::string out_port, RTLIL::SigSpec out_val)
 {
@@ -38,9 +38,8 @@ void replace_cell(RTLIL::Module *module, RTLIL::Cell *cell, std::string info, st
 			module->name.c_str(), log_signal(Y), log_signal(out_val));
 	OPT_DID_SOMETHING = true;
 	// ILANG_BACKEND::dump_cell(stderr, "--> ", cell);
-	module->connections.push_back(RTLIL::SigSig(Y, out_val));
-	module->cells.erase(cell->name);
-	delete cell;
+	module->connect(RTLIL::SigSig(Y, out_val));
+	module->remove(cell);
 	did_something = true;
 }
 
@@ -49,7 +48,7 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 	if (!design->selected(module))
 		return;
 
-	SigMap assign_map(module);
+	const SigMap &assign_map = CachedSigMap::get(module);
 
 	std::vector<RTLIL::Cell*> cells;
 	cells.reserve(module->cells.size());
@@ -148,8 +147,11 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 		{
 			if (cell->parameters["\\A_WIDTH"].as_int() != cell->parameters["\\B_WIDTH"].as_int()) {
 				int width = std::max(cell->parameters["\\A_WIDTH"].as_int(), cell->parameters["\\B_WIDTH"].as_int());
-				cell->connections["\\A"].extend(width, cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool());
-				cell->connections["\\B"].extend(width, cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool());
+				RTLIL::SigSpec a = cell->connections["\\A"], b = cell->connections["\\B"];
+				a.extend(width, cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool());
+				b.extend(width, cell->parameters["\\A_SIGNED"].as_bool() && cell->parameters["\\B_SIGNED"].as_bool());
+				module->connect(cell, "\\A", a);
+				module->connect(cell, "\\B", b);
 				cell->parameters["\\A_WIDTH"] = width;
 				cell->parameters["\\B_WIDTH"] = width;
 			}
@@ -172,8 +174,8 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 			if (new_a.width != a.width) {
 				new_a.optimize();
 				new_b.optimize();
-				cell->connections["\\A"] = new_a;
-				cell->connections["\\B"] = new_b;
+				module->connect(cell, "\\A", new_a);
+				module->connect(cell, "\\B", new_b);
 				cell->parameters["\\A_WIDTH"] = new_a.width;
 				cell->parameters["\\B_WIDTH"] = new_b.width;
 			}
@@ -193,8 +195,8 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 			if (a.is_fully_const()) {
 				RTLIL::SigSpec tmp;
 				tmp = a, a = b, b = tmp;
-				cell->connections["\\A"] = a;
-				cell->connections["\\B"] = b;
+				module->connect(cell, "\\A", a);
+				module->connect(cell, "\\B", b);
 			}
 
 			if (b.is_fully_const()) {
@@ -202,10 +204,10 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 					RTLIL::SigSpec input = b;
 					ACTION_DO("\\Y", cell->connections["\\A"]);
 				} else {
-					cell->type = "$not";
+					module->disconnect(cell, "\\B");
+					module->retype(cell, "$not");
 					cell->parameters.erase("\\B_WIDTH");
 					cell->parameters.erase("\\B_SIGNED");
-					cell->connections.erase("\\B");
 				}
 				goto next_cell;
 			}
@@ -302,7 +304,7 @@ void replace_const_cells(RTLIL::Design *design, RTLIL::Module *module, bool cons
 }
 
 struct OptConstPass : public Pass {
-	OptConstPass() : Pass("opt_const", "perform const folding") { }
+	OptConstPass() : Pass("opt_const", "perform const folding") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -312,6 +314,16 @@ struct OptConstPass : public Pass {
 		log("This pass performs const folding on internal cell types with constant inputs.\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		do {
+			do {
+				did_something = false;
+				replace_const_cells(design, module, false);
+			} while (did_something);
+			replace_const_cells(design, module, true);
+		} while (did_something);
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header("Executing OPT_CONST pass (perform const folding).\n");
@@ -319,14 +331,7 @@ struct OptConstPass : public Pass {
 
 		extra_args(args, 1, design);
 
-		for (auto &mod_it : design->modules)
-			do {
-				do {
-					did_something = false;
-					replace_const_cells(design, mod_it.second, false);
-				} while (did_something);
-				replace_const_cells(design, mod_it.second, true);
-			} while (did_something);
+		execute_modules(design);
 
 		log_pop();
 	}
@@ -33,7 +33,7 @@ struct OptMuxtreeWorker
 {
 	RTLIL::Design *design;
 	RTLIL::Module *module;
-	SigMap assign_map;
+	const SigMap &assign_map;
 	int removed_count;
 
 	typedef std::pair<RTLIL::Wire*,int> bitDef_t;
@@ -65,7 +65,7 @@ struct OptMuxtreeWorker
 	std::vector<muxinfo_t> mux2info;
 
 	OptMuxtreeWorker(RTLIL::Design *design, RTLIL::Module *module) :
-			design(design), module(module), assign_map(module), removed_count(0)
+			design(design), module(module), assign_map(CachedSigMap::get(module)), removed_count(0)
 	{
 		log("Running muxtree optimizier on module %s..\n", module->name.c_str());
 
@@ -84,17 +84,17 @@ struct OptMuxtreeWorker
 			RTLIL::Cell *cell = cell_it.second;
 			if (cell->type == "$mux" || cell->type == "$pmux" || cell->type == "$safe_pmux")
 			{
-				RTLIL::SigSpec sig_a = cell->connections["\\A"];
-				RTLIL::SigSpec sig_b = cell->connections["\\B"];
-				RTLIL::SigSpec sig_s = cell->connections["\\S"];
-				RTLIL::SigSpec sig_y = cell->connections["\\Y"];
+				const RTLIL::SigSpec &sig_a = cell->connections["\\A"];
+				const RTLIL::SigSpec &sig_b = cell->connections["\\B"];
+				const RTLIL::SigSpec &sig_s = cell->connections["\\S"];
+				const RTLIL::SigSpec &sig_y = cell->connections["\\Y"];
 
 				muxinfo_t muxinfo;
 				muxinfo.cell = cell;
 
 				for (int i = 0; i < sig_s.width; i++) {
-					RTLIL::SigSpec sig = sig_b.extract(i*sig_a.width, sig_a.width);
-					RTLIL::SigSpec ctrl_sig = assign_map(sig_s.extract(i, 1));
+					RTLIL::SigSlice sig = sig_b.slice(i*sig_a.width, sig_a.width);
+					RTLIL::SigSpec ctrl_sig = assign_map(sig_s.slice(i, 1));
 					portinfo_t portinfo;
 					for (int idx : sig2bits(sig)) {
 						add_to_list(bit2info[idx].mux_users, mux2info.size());
@@ -186,15 +186,14 @@ struct OptMuxtreeWorker
 				continue;
 
 			if (live_ports.size() == 0) {
-				module->cells.erase(mi.cell->name);
-				delete mi.cell;
+				module->remove(mi.cell);
 				continue;
 			}
 
-			RTLIL::SigSpec sig_a = mi.cell->connections["\\A"];
-			RTLIL::SigSpec sig_b = mi.cell->connections["\\B"];
-			RTLIL::SigSpec sig_s = mi.cell->connections["\\S"];
-			RTLIL::SigSpec sig_y = mi.cell->connections["\\Y"];
+			const RTLIL::SigSpec &sig_a = mi.cell->connections["\\A"];
+			const RTLIL::SigSpec &sig_b = mi.cell->connections["\\B"];
+			const RTLIL::SigSpec &sig_s = mi.cell->connections["\\S"];
+			const RTLIL::SigSpec &sig_y = mi.cell->connections["\\Y"];
 
 			RTLIL::SigSpec sig_ports = sig_b;
 			sig_ports.append(sig_a);
@@ -202,29 +201,28 @@ struct OptMuxtreeWorker
 			if (live_ports.size() == 1)
 			{
 				RTLIL::SigSpec sig_in = sig_ports.extract(live_ports[0]*sig_a.width, sig_a.width);
-				module->connections.push_back(RTLIL::SigSig(sig_y, sig_in));
-				module->cells.erase(mi.cell->name);
-				delete mi.cell;
+				module->connect(RTLIL::SigSig(sig_y, sig_in));
+				module->remove(mi.cell);
 			}
 			else
 			{
 				RTLIL::SigSpec new_sig_a, new_sig_b, new_sig_s;
 
 				for (size_t i = 0; i < live_ports.size(); i++) {
-					RTLIL::SigSpec sig_in = sig_ports.extract(live_ports[i]*sig_a.width, sig_a.width);
+					RTLIL::SigSlice sig_in = sig_ports.slice(live_ports[i]*sig_a.width, sig_a.width);
 					if (i == live_ports.size()-1) {
-						new_sig_a = sig_in;
+						new_sig_a = RTLIL::SigSpec(sig_in);
 					} else {
 						new_sig_b.append(sig_in);
-						new_sig_s.append(sig_s.extract(live_ports[i], 1));
+						new_sig_s.append(sig_s.slice(live_ports[i], 1));
 					}
 				}
 
-				mi.cell->connections["\\A"] = new_sig_a;
-				mi.cell->connections["\\B"] = new_sig_b;
-				mi.cell->connections["\\S"] = new_sig_s;
+				module->connect(mi.cell, "\\A", new_sig_a);
+				module->connect(mi.cell, "\\B", new_sig_b);
+				module->connect(mi.cell, "\\S", new_sig_s);
 				if (new_sig_s.width == 1) {
-					mi.cell->type = "$mux";
+					module->retype(mi.cell, "$mux");
 					mi.cell->attributes.erase("\\S_WIDTH");
 				} else {
 					mi.cell->attributes["\\S_WIDTH"] = RTLIL::Const(new_sig_s.width);
@@ -255,14 +253,13 @@ struct OptMuxtreeWorker
 			list.push_back(value);
 	}
 
-	std::vector<int> sig2bits(RTLIL::SigSpec sig)
+	std::vector<int> sig2bits(const RTLIL::SigSlice &sig)
 	{
 		std::vector<int> results;
-		assign_map.apply(sig);
-		sig.expand();
-		for (auto &c : sig.chunks)
-			if (c.wire != NULL) {
-				bitDef_t bit(c.wire, c.offset);
+		for (auto b : sig) {
+			RTLIL::SigBit mapped = assign_map(b);
+			if (mapped.wire != NULL) {
+				bitDef_t bit(mapped.wire, mapped.offset);
 				if (bit2num.count(bit) == 0) {
 					bitinfo_t info;
 					info.num = bit2info.size();
@@ -273,6 +270,7 @@ struct OptMuxtreeWorker
 				}
 				results.push_back(bit2num[bit]);
 			}
+		}
 		return results;
 	}
 
@@ -398,7 +396,8 @@ struct OptMuxtreeWorker
 };
 
 struct OptMuxtreePass : public Pass {
-	OptMuxtreePass() : Pass("opt_muxtree", "eliminate dead trees in multiplexer trees") { }
+	std::atomic<int> total_count;
+	OptMuxtreePass() : Pass("opt_muxtree", "eliminate dead trees in multiplexer trees") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -412,26 +411,28 @@ struct OptMuxtreePass : public Pass {
 		log("This pass only operates on completely selected modules without processes.\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		if (!design->selected_whole_module(module->name)) {
+			if (design->selected(module))
+				log("Skipping module %s as it is only partially selected.\n", id2cstr(module->name));
+			return;
+		}
+		if (module->processes.size() > 0) {
+			log("Skipping module %s as it contains processes.\n", id2cstr(module->name));
+		} else {
+			OptMuxtreeWorker worker(design, module);
+			total_count += worker.removed_count;
+		}
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header("Executing OPT_MUXTREE pass (detect dead branches in mux trees).\n");
 		extra_args(args, 1, design);
 
-		int total_count = 0;
-		for (auto &mod_it : design->modules) {
-			if (!design->selected_whole_module(mod_it.first)) {
-				if (design->selected(mod_it.second))
-					log("Skipping module %s as it is only partially selected.\n", id2cstr(mod_it.second->name));
-				continue;
-			}
-			if (mod_it.second->processes.size() > 0) {
-				log("Skipping module %s as it contains processes.\n", id2cstr(mod_it.second->name));
-			} else {
-				OptMuxtreeWorker worker(design, mod_it.second);
-				total_count += worker.removed_count;
-			}
-		}
-		log("Removed %d multiplexer ports.\n", total_count);
+		total_count = 0;
+		execute_modules(design);
+		log("Removed %d multiplexer ports.\n", total_count.load());
 	}
 } OptMuxtreePass;
  
@@ -89,7 +89,7 @@ struct OptReduceWorker
 			total_count++;
 		}
 
-		cell->connections["\\A"] = new_sig_a;
+		module->connect(cell, "\\A", new_sig_a);
 		cell->parameters["\\A_WIDTH"] = RTLIL::Const(new_sig_a.width);
 		return;
 	}
@@ -119,20 +119,15 @@ struct OptReduceWorker
 
 			if (this_s.width > 1)
 			{
-				RTLIL::Wire *reduce_or_wire = new RTLIL::Wire;
-				reduce_or_wire->name = NEW_ID;
-				module->wires[reduce_or_wire->name] = reduce_or_wire;
-
-				RTLIL::Cell *reduce_or_cell = new RTLIL::Cell;
-				reduce_or_cell->name = NEW_ID;
-				reduce_or_cell->type = "$reduce_or";
-				reduce_or_cell->connections["\\A"] = this_s;
+				RTLIL::Wire *reduce_or_wire = module->addWire(NEW_ID);
+
+				RTLIL::Cell *reduce_or_cell = module->addCell(NEW_ID, "$reduce_or");
+				module->connect(reduce_or_cell, "\\A", this_s);
 				reduce_or_cell->parameters["\\A_WIDTH"] = RTLIL::Const(this_s.width);
 				reduce_or_cell->parameters["\\Y_WIDTH"] = RTLIL::Const(1);
-				module->cells[reduce_or_cell->name] = reduce_or_cell;
 
 				this_s = RTLIL::SigSpec(reduce_or_wire);
-				reduce_or_cell->connections["\\Y"] = this_s;
+				module->connect(reduce_or_cell, "\\Y", this_s);
 			}
 
 			new_sig_b.append(this_b);
@@ -149,26 +144,25 @@ struct OptReduceWorker
 
 		if (new_sig_s.width == 0)
 		{
-			module->connections.push_back(RTLIL::SigSig(cell->connections["\\Y"], cell->connections["\\A"]));
+			module->connect(RTLIL::SigSig(cell->connections["\\Y"], cell->connections["\\A"]));
 			assign_map.add(cell->connections["\\Y"], cell->connections["\\A"]);
-			module->cells.erase(cell->name);
-			delete cell;
+			module->remove(cell);
 		}
 		else
 		{
-			cell->connections["\\B"] = new_sig_b;
-			cell->connections["\\S"] = new_sig_s;
+			module->connect(cell, "\\B", new_sig_b);
+			module->connect(cell, "\\S", new_sig_s);
 			if (new_sig_s.width > 1) {
 				cell->parameters["\\S_WIDTH"] = RTLIL::Const(new_sig_s.width);
 			} else {
-				cell->type = "$mux";
+				module->retype(cell, "$mux");
 				cell->parameters.erase("\\S_WIDTH");
 			}
 		}
 	}
 
 	OptReduceWorker(RTLIL::Design *design, RTLIL::Module *module) :
-			design(design), module(module), assign_map(module)
+			design(design), module(module), assign_map(CachedSigMap::get(module))
 	{
 		log("  Optimizing cells in module %s.\n", module->name.c_str());
 
@@ -216,7 +210,8 @@ struct OptReduceWorker
 };
 
 struct OptReducePass : public Pass {
-	OptReducePass() : Pass("opt_reduce", "simplify large MUXes and AND/OR gates") { }
+	std::atomic<int> total_count;
+	OptReducePass() : Pass("opt_reduce", "simplify large MUXes and AND/OR gates") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -232,20 +227,22 @@ struct OptReducePass : public Pass {
 		log("input with the original control signals OR'ed together.\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		if (!design->selected(module))
+			return;
+		OptReduceWorker worker(design, module);
+		total_count += worker.total_count;
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header("Executing OPT_REDUCE pass (consolidate $*mux and $reduce_* inputs).\n");
 		extra_args(args, 1, design);
 
-		int total_count = 0;
-		for (auto &mod_it : design->modules) {
-			if (!design->selected(mod_it.second))
-				continue;
-			OptReduceWorker worker(design, mod_it.second);
-			total_count += worker.total_count;
-		}
+		total_count = 0;
+		execute_modules(design);
 
-		log("Performed a total of %d changes.\n", total_count);
+		log("Performed a total of %d changes.\n", total_count.load());
 	}
 } OptReducePass;
  
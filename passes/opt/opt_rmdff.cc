@@ -24,8 +24,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-static SigMap assign_map;
-static SigSet<RTLIL::Cell*> mux_drivers;
+static thread_local const SigMap *assign_map;
+static thread_local SigSet<RTLIL::Cell*> mux_drivers;
 
 static bool handle_dff(RTLIL::Module *mod, RTLIL::Cell *dff)
 {
@@ -68,25 +68,25 @@ static bool handle_dff(RTLIL::Module *mod, RTLIL::Cell *dff)
 	else
 		log_abort();
 
-	assign_map.apply(sig_d);
-	assign_map.apply(sig_q);
-	assign_map.apply(sig_c);
-	assign_map.apply(sig_r);
+	assign_map->apply(sig_d);
+	assign_map->apply(sig_q);
+	assign_map->apply(sig_c);
+	assign_map->apply(sig_r);
 
 	if (dff->type == "$dff" && mux_drivers.has(sig_d)) {
 		std::set<RTLIL::Cell*> muxes;
 		mux_drivers.find(sig_d, muxes);
 		for (auto mux : muxes) {
-			RTLIL::SigSpec sig_a = assign_map(mux->connections.at("\\A"));
-			RTLIL::SigSpec sig_b = assign_map(mux->connections.at("\\B"));
+			RTLIL::SigSpec sig_a = (*assign_map)(mux->connections.at("\\A"));
+			RTLIL::SigSpec sig_b = (*assign_map)(mux->connections.at("\\B"));
 			if (sig_a == sig_q && sig_b.is_fully_const()) {
 				RTLIL::SigSig conn(sig_q, sig_b);
-				mod->connections.push_back(conn);
+				mod->connect(conn);
 				goto delete_dff;
 			}
 			if (sig_b == sig_q && sig_a.is_fully_const()) {
 				RTLIL::SigSig conn(sig_q, sig_a);
-				mod->connections.push_back(conn);
+				mod->connect(conn);
 				goto delete_dff;
 			}
 		}
@@ -94,14 +94,14 @@ static bool handle_dff(RTLIL::Module *mod, RTLIL::Cell *dff)
 
 	if (sig_d.is_fully_const() && sig_r.width == 0) {
 		RTLIL::SigSig conn(sig_q, sig_d);
-		mod->connections.push_back(conn);
+		mod->connect(conn);
 		goto delete_dff;
 	}
 
 	if (sig_d == sig_q) {
 		if (sig_r.width > 0) {
 			RTLIL::SigSig conn(sig_q, val_rv);
-			mod->connections.push_back(conn);
+			mod->connect(conn);
 		}
 		goto delete_dff;
 	}
@@ -111,13 +111,13 @@ static bool handle_dff(RTLIL::Module *mod, RTLIL::Cell *dff)
 delete_dff:
 	log("Removing %s (%s) from module %s.\n", dff->name.c_str(), dff->type.c_str(), mod->name.c_str());
 	OPT_DID_SOMETHING = true;
-	mod->cells.erase(dff->name);
-	delete dff;
+	mod->remove(dff);
 	return true;
 }
 
 struct OptRmdffPass : public Pass {
-	OptRmdffPass() : Pass("opt_rmdff", "remove DFFs with constant inputs") { }
+	std::atomic<int> total_count;
+	OptRmdffPass() : Pass("opt_rmdff", "remove DFFs with constant inputs") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -128,54 +128,56 @@ struct OptRmdffPass : public Pass {
 		log("a constant driver.\n");
 		log("\n");
 	}
-	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
 	{
-		int total_count = 0;
-		log_header("Executing OPT_RMDFF pass (remove dff with constant values).\n");
+		if (!design->selected(module))
+			return;
 
-		extra_args(args, 1, design);
+		assign_map = &CachedSigMap::get(module);
+		mux_drivers.clear();
 
-		for (auto &mod_it : design->modules)
-		{
-			if (!design->selected(mod_it.second))
+		std::vector<std::string> dff_list;
+		for (auto &it : module->cells) {
+			if (it.second->type == "$mux" || it.second->type == "$pmux") {
+				if (it.second->connections.at("\\A").width == it.second->connections.at("\\B").width)
+					mux_drivers.insert((*assign_map)(it.second->connections.at("\\Y")), it.second);
 				continue;
-
-			assign_map.set(mod_it.second);
-			mux_drivers.clear();
-
-			std::vector<std::string> dff_list;
-			for (auto &it : mod_it.second->cells) {
-				if (it.second->type == "$mux" || it.second->type == "$pmux") {
-					if (it.second->connections.at("\\A").width == it.second->connections.at("\\B").width)
-						mux_drivers.insert(assign_map(it.second->connections.at("\\Y")), it.second);
-					continue;
-				}
-				if (!design->selected(mod_it.second, it.second))
-					continue;
-				if (it.second->type == "$_DFF_N_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_P_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_NN0_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_NN1_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_NP0_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_NP1_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_PN0_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_PN1_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_PP0_") dff_list.push_back(it.first);
-				if (it.second->type == "$_DFF_PP1_") dff_list.push_back(it.first);
-				if (it.second->type == "$dff") dff_list.push_back(it.first);
-				if (it.second->type == "$adff") dff_list.push_back(it.first);
 			}
+			if (!design->selected(module, it.second))
+				continue;
+			if (it.second->type == "$_DFF_N_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_P_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_NN0_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_NN1_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_NP0_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_NP1_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_PN0_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_PN1_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_PP0_") dff_list.push_back(it.first);
+			if (it.second->type == "$_DFF_PP1_") dff_list.push_back(it.first);
+			if (it.second->type == "$dff") dff_list.push_back(it.first);
+			if (it.second->type == "$adff") dff_list.push_back(it.first);
+		}
 
-			for (auto &id : dff_list) {
-				if (mod_it.second->cells.count(id) > 0 &&
-						handle_dff(mod_it.second, mod_it.second->cells[id]))
-					total_count++;
-			}
+		for (auto &id : dff_list) {
+			if (module->cells.count(id) > 0 &&
+					handle_dff(module, module->cells[id]))
+				total_count++;
 		}
 
-		assign_map.clear();
+		assign_map = NULL;
 		mux_drivers.clear();
-		log("Replaced %d DFF cells.\n", total_count);
+	}
+	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+	{
+		log_header("Executing OPT_RMDFF pass (remove dff with constant values).\n");
+
+		extra_args(args, 1, design);
+
+		total_count = 0;
+		execute_modules(design);
+
+		log("Replaced %d DFF cells.\n", total_count.load());
 	}
 } OptRmdffPass;
  
@@ -62,10 +62,12 @@ struct OptShareWorker
 
 		std::string hash_string = cell->type + "\n";
 
-		for (auto &it : cell->parameters)
+		std::map<RTLIL::IdString, RTLIL::Const> sorted_params(cell->parameters.begin(), cell->parameters.end());
+		for (auto &it : sorted_params)
 			hash_string += "P " + it.first + "=" + it.second.as_string() + "\n";
 
-		const std::map<RTLIL::IdString, RTLIL::SigSpec> *conn = &cell->connections;
+		std::map<RTLIL::IdString, RTLIL::SigSpec> sorted_conn(cell->connections.begin(), cell->connections.end());
+		const std::map<RTLIL::IdString, RTLIL::SigSpec> *conn = &sorted_conn;
 		std::map<RTLIL::IdString, RTLIL::SigSpec> alt_conn;
 
 		if (cell->type == "$and" || cell->type == "$or" || cell->type == "$xor" || cell->type == "$xnor" || cell->type == "$add" || cell->type == "$mul" ||
@@ -130,12 +132,14 @@ struct OptShareWorker
 #endif
 
 		if (cell1->parameters != cell2->parameters) {
-			lt = cell1->parameters < cell2->parameters;
+			std::map<RTLIL::IdString, RTLIL::Const> p1(cell1->parameters.begin(), cell1->parameters.end());
+			std::map<RTLIL::IdString, RTLIL::Const> p2(cell2->parameters.begin(), cell2->parameters.end());
+			lt = p1 < p2;
 			return true;
 		}
 
-		std::map<RTLIL::IdString, RTLIL::SigSpec> conn1 = cell1->connections;
-		std::map<RTLIL::IdString, RTLIL::SigSpec> conn2 = cell2->connections;
+		std::map<RTLIL::IdString, RTLIL::SigSpec> conn1(cell1->connections.begin(), cell1->connections.end());
+		std::map<RTLIL::IdString, RTLIL::SigSpec> conn2(cell2->connections.begin(), cell2->connections.end());
 
 		for (auto &it : conn1) {
 			if (ct.cell_output(cell1->type, it.first))
@@ -205,7 +209,7 @@ struct OptShareWorker
 	};
 
 	OptShareWorker(RTLIL::Design *design, RTLIL::Module *module, bool mode_nomux) :
-		design(design), module(module), assign_map(module)
+		design(design), module(module), assign_map(CachedSigMap::get(module))
 	{
 		total_count = 0;
 		ct.setup_internals();
@@ -214,13 +218,12 @@ struct OptShareWorker
 		ct.setup_stdcells_mem();
 
 		if (mode_nomux) {
-			ct.cell_types.erase("$mux");
-			ct.cell_types.erase("$pmux");
-			ct.cell_types.erase("$safe_pmux");
+			ct.cell_types.reset(CT_mux);
+			ct.cell_types.reset(CT_pmux);
+			ct.cell_types.reset(CT_safe_pmux);
 		}
 
 		log("Finding identical cells in module `%s'.\n", module->name.c_str());
-		assign_map.set(module);
 
 		bool did_something = true;
 		while (did_something)
@@ -247,15 +250,14 @@ struct OptShareWorker
 							RTLIL::SigSpec other_sig = sharemap[cell]->connections[it.first];
 							log("    Redirecting output %s: %s = %s\n", it.first.c_str(),
 									log_signal(it.second), log_signal(other_sig));
-							module->connections.push_back(RTLIL::SigSig(it.second, other_sig));
+							module->connect(RTLIL::SigSig(it.second, other_sig));
 							assign_map.add(it.second, other_sig);
 						}
 					}
 					log("    Removing %s cell `%s' from module `%s'.\n", cell->type.c_str(), cell->name.c_str(), module->name.c_str());
-					module->cells.erase(cell->name);
+					module->remove(cell);
 					OPT_DID_SOMETHING = true;
 					total_count++;
-					delete cell;
 				} else {
 					sharemap[cell] = cell;
 				}
@@ -265,7 +267,9 @@ struct OptShareWorker
 };
 
 struct OptSharePass : public Pass {
-	OptSharePass() : Pass("opt_share", "consolidate identical cells") { }
+	bool mode_nomux;
+	std::atomic<int> total_count;
+	OptSharePass() : Pass("opt_share", "consolidate identical cells") { monitored = true; modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -279,11 +283,18 @@ struct OptSharePass : public Pass {
 		log("        Do not merge MUX cells.\n");
 		log("\n");
 	}
+	virtual void execute_module(RTLIL::Design *design, RTLIL::Module *module)
+	{
+		if (!design->selected(module))
+			return;
+		OptShareWorker worker(design, module, mode_nomux);
+		total_count += worker.total_count;
+	}
 	virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
 	{
 		log_header("Executing OPT_SHARE pass (detect identical cells).\n");
 
-		bool mode_nomux = false;
+		mode_nomux = false;
 
 		size_t argidx;
 		for (argidx = 1; argidx < args.size(); argidx++) {
@@ -296,15 +307,10 @@ struct OptSharePass : public Pass {
 		}
 		extra_args(args, argidx, design);
 
-		int total_count = 0;
-		for (auto &mod_it : design->modules) {
-			if (!design->selected(mod_it.second))
-				continue;
-			OptShareWorker worker(design, mod_it.second, mode_nomux);
-			total_count += worker.total_count;
-		}
+		total_count = 0;
+		execute_modules(design);
 
-		log("Removed a total of %d cells.\n", total_count);
+		log("Removed a total of %d cells.\n", total_count.load());
 	}
 } OptSharePass;
  
@@ -20,7 +20,9 @@
 #ifndef OPT_STATUS_H
 #define OPT_STATUS_H
 
-extern bool OPT_DID_SOMETHING;
+#include <atomic>
+
+extern std::atomic<bool> OPT_DID_SOMETHING;
 
 #endif
 
@@ -23,7 +23,7 @@
 #include <stdio.h>
 
 struct ProcPass : public Pass {
-	ProcPass() : Pass("proc", "translate processes to netlists") { }
+	ProcPass() : Pass("proc", "translate processes to netlists") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -191,7 +191,7 @@ restart_proc_arst:
 }
 
 struct ProcArstPass : public Pass {
-	ProcArstPass() : Pass("proc_arst", "detect asynchronous resets") { }
+	ProcArstPass() : Pass("proc_arst", "detect asynchronous resets") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -131,7 +131,7 @@ static void proc_clean(RTLIL::Module *mod, RTLIL::Process *proc, int &total_coun
 }
 
 struct ProcCleanPass : public Pass {
-	ProcCleanPass() : Pass("proc_clean", "remove empty parts of processes") { }
+	ProcCleanPass() : Pass("proc_clean", "remove empty parts of processes") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
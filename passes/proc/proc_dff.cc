@@ -392,7 +392,7 @@ static void proc_dff(RTLIL::Module *mod, RTLIL::Process *proc, ConstEval &ce)
 }
 
 struct ProcDffPass : public Pass {
-	ProcDffPass() : Pass("proc_dff", "extract flip-flops from processes") { }
+	ProcDffPass() : Pass("proc_dff", "extract flip-flops from processes") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -221,7 +221,7 @@ static RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, RTLIL::CaseRule *cs
 						pgroups[i] = pgroups[i-1]+1;
 						extra_group_for_next_case = false;
 					}
-					for (auto pat : cs2->compare)
+					for (auto &pat : cs2->compare)
 						if (!pat.is_fully_const() || !pool.has_all(pat))
 							pgroups[i] = pgroups[i-1]+1;
 					if (cs2->compare.empty())
@@ -229,7 +229,7 @@ static RTLIL::SigSpec signal_to_mux_tree(RTLIL::Module *mod, RTLIL::CaseRule *cs
 					if (pgroups[i] != pgroups[i-1])
 						pool = BitPatternPool(sw->signal.width);
 				}
-				for (auto pat : cs2->compare)
+				for (auto &pat : cs2->compare)
 					if (!pat.is_fully_const())
 						extra_group_for_next_case = true;
 					else
@@ -279,7 +279,7 @@ static void proc_mux(RTLIL::Module *mod, RTLIL::Process *proc)
 }
 
 struct ProcMuxPass : public Pass {
-	ProcMuxPass() : Pass("proc_mux", "convert decision trees to multiplexers") { }
+	ProcMuxPass() : Pass("proc_mux", "convert decision trees to multiplexers") { modifies_selected_only = true; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
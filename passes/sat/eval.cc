@@ -116,7 +116,7 @@ struct BruteForceEquivChecker
 } /* namespace */
 
 struct EvalPass : public Pass {
-	EvalPass() : Pass("eval", "evaluate the circuit given an input") { }
+	EvalPass() : Pass("eval", "evaluate the circuit given an input") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
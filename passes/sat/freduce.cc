@@ -314,10 +314,9 @@ struct FreduceHelper
 				}
 			cell_inputs.sort_and_unify();
 			cell_outputs.sort_and_unify();
-			cell_inputs.expand();
-			for (auto &c : cell_inputs.chunks)
-				if (c.wire != NULL)
-					source_signals.insert(cell_outputs, c);
+			for (auto bit : cell_inputs)
+				if (bit.wire != NULL)
+					source_signals.insert(cell_outputs, bit);
 			if (!satgen.importCell(cell))
 				log_error("Failed to import cell to SAT solver: %s (%s)\n",
 						RTLIL::id2cstr(cell->name), RTLIL::id2cstr(cell->type));
@@ -420,7 +420,7 @@ static void print_qed()
 }
 
 struct SatPass : public Pass {
-	SatPass() : Pass("sat", "solve a SAT problem in the circuit") { }
+	SatPass() : Pass("sat", "solve a SAT problem in the circuit") { modifies_design = false; }
 	virtual void help()
 	{
 		//   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
@@ -387,8 +387,9 @@ static void dfflibmap(RTLIL::Design *design, RTLIL::Module *module)
 				sig = cell->connections[std::string("\\") + char(port.second - ('a' - 'A'))];
 				RTLIL::Cell *inv_cell = new RTLIL::Cell;
 				RTLIL::Wire *inv_wire = new RTLIL::Wire;
-				inv_cell->name = stringf("$dfflibmap$inv$%d", RTLIL::autoidx);
-				inv_wire->name = stringf("$dfflibmap$sig$%d", RTLIL::autoidx++);
+				int inv_idx = RTLIL::autoidx++;
+				inv_cell->name = stringf("$dfflibmap$inv$%d", inv_idx);
+				inv_wire->name = stringf("$dfflibmap$sig$%d", inv_idx);
 				inv_cell->type = "$_INV_";
 				inv_cell->connections[port.second == 'q' ? "\\Y" : "\\A"] = sig;
 				sig = RTLIL::SigSpec(inv_wire);
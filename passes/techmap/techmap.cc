@@ -27,7 +27,7 @@
 
 #include "passes/techmap/stdcells.inc"
 
-static void apply_prefix(std::string prefix, std::string &id)
+static void apply_prefix(std::string prefix, RTLIL::IdString &id)
 {
 	if (id[0] == '\\')
 		id = prefix + "." + id.substr(1);
@@ -40,7 +40,7 @@ static void apply_prefix(std::string prefix, RTLIL::SigSpec &sig, RTLIL::Module
 	for (size_t i = 0; i < sig.chunks.size(); i++) {
 		if (sig.chunks[i].wire == NULL)
 			continue;
-		std::string wire_name = sig.chunks[i].wire->name;
+		RTLIL::IdString wire_name = sig.chunks[i].wire->name;
 		apply_prefix(prefix, wire_name);
 		assert(module->wires.count(wire_name) > 0);
 		sig.chunks[i].wire = module->wires[wire_name];
@@ -50,6 +50,7 @@ static void apply_prefix(std::string prefix, RTLIL::SigSpec &sig, RTLIL::Module
 std::map<std::pair<RTLIL::IdString, std::map<RTLIL::IdString, RTLIL::Const>>, RTLIL::Module*> techmap_cache;
 std::map<RTLIL::Module*, bool> techmap_fail_cache;
 std::set<RTLIL::Module*> techmap_opt_cache;
+std::map<RTLIL::IdString, int> techmap_count;
 
 static bool techmap_fail_check(RTLIL::Module *module)
 {
@@ -72,7 +73,8 @@ static bool techmap_fail_check(RTLIL::Module *module)
 
 static void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Cell *cell, RTLIL::Module *tpl, RTLIL::Selection &new_members, bool flatten_mode)
 {
-	log("Mapping `%s.%s' using `%s'.\n", RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(tpl->name));
+	log_debug("Mapping `%s.%s' using `%s'.\n", RTLIL::id2cstr(module->name), RTLIL::id2cstr(cell->name), RTLIL::id2cstr(tpl->name));
+	techmap_count[tpl->name]++;
 
 	if (tpl->memories.size() != 0)
 		log_error("Technology map yielded memories -> this is not supported.\n");
@@ -85,12 +87,12 @@ static void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module,
 	for (auto &it : tpl->wires) {
 		if (it.second->port_id > 0)
 			positional_ports[stringf("$%d", it.second->port_id)] = it.first;
-		RTLIL::Wire *w = new RTLIL::Wire(*it.second);
-		apply_prefix(cell->name, w->name);
+		RTLIL::IdString w_name = it.second->name;
+		apply_prefix(cell->name, w_name);
+		RTLIL::Wire *w = module->addWire(w_name, it.second);
 		w->port_input = false;
 		w->port_output = false;
 		w->port_id = 0;
-		module->wires[w->name] = w;
 		design->select(module, w);
 		new_members.select(module, w);
 	}
@@ -137,15 +139,15 @@ static void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module,
 	}
 
 	for (auto &it : tpl->cells) {
-		RTLIL::Cell *c = new RTLIL::Cell(*it.second);
+		RTLIL::IdString c_name = it.second->name;
+		apply_prefix(cell->name, c_name);
+		RTLIL::Cell *c = module->addCell(c_name, it.second);
 		if (!flatten_mode && c->type.substr(0, 2) == "\\$")
 			c->type = c->type.substr(1);
-		apply_prefix(cell->name, c->name);
 		for (auto &it2 : c->connections) {
 			apply_prefix(cell->name, it2.second, module);
 			port_signal_map.apply(it2.second);
 		}
-		module->cells[c->name] = c;
 		design->select(module, c);
 		new_members.select(module, c);
 	}
@@ -163,6 +165,18 @@ static void techmap_module_worker(RTLIL::Design *design, RTLIL::Module *module,
 	delete cell;
 }
 
+static void log_techmap_count()
+{
+	int total = 0;
+	for (auto &it : techmap_count)
+		total += it.second;
+	if (total > 0)
+		log("Mapped %d cells:\n", total);
+	for (auto &it : techmap_count)
+		log("  %6d using `%s'\n", it.second, RTLIL::id2cstr(it.first));
+	techmap_count.clear();
+}
+
 static bool techmap_module(RTLIL::Design *design, RTLIL::Module *module, RTLIL::Design *map, std::set<RTLIL::Cell*> &handled_cells,
 		const std::map<RTLIL::IdString, std::set<RTLIL::IdString>> &celltypeMap, bool flatten_mode, bool opt_mode)
 {
@@ -193,7 +207,7 @@ static bool techmap_module(RTLIL::Design *design, RTLIL::Module *module, RTLIL::
 		{
 			std::string derived_name = tpl_name;
 			RTLIL::Module *tpl = map->modules[tpl_name];
-			std::map<RTLIL::IdString, RTLIL::Const> parameters = cell->parameters;
+			std::map<RTLIL::IdString, RTLIL::Const> parameters(cell->parameters.begin(), cell->parameters.end());
 
 			for (auto conn : cell->connections) {
 				if (conn.first.substr(0, 1) == "$")
@@ -355,6 +369,7 @@ struct TechmapPass : public Pass {
 		}
 
 		log("No more expansions possible.\n");
+		log_techmap_count();
 		techmap_cache.clear();
 		techmap_fail_cache.clear();
 		techmap_opt_cache.clear();
@@ -397,6 +412,7 @@ struct FlattenPass : public Pass {
 		}
 
 		log("No more expansions possible.\n");
+		log_techmap_count();
 		techmap_cache.clear();
 		techmap_fail_cache.clear();
 		techmap_opt_cache.clear();
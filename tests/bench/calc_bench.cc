@@ -0,0 +1,226 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Compare the native integer path of the arithmetic const_* functions in
+ *  kernel/calc.cc with the generic BigInteger implementation.
+ *
+ *  build: make tests/bench/calc_bench
+ *  usage: tests/bench/calc_bench [num_operands [num_rounds]]
+ *
+ */
+
+#include "kernel/rtlil.h"
+#include "libs/bigint/BigIntegerLibrary.hh"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// reference: the BigInteger code path from kernel/calc.cc
+
+static BigInteger const2big(const RTLIL::Const &val, bool as_signed)
+{
+	BigInteger result = 0, this_bit = 1;
+	for (size_t i = 0; i < val.bits.size(); i++) {
+		if (val.bits[i] == RTLIL::State::S1) {
+			if (as_signed && i+1 == val.bits.size())
+				result -= this_bit;
+			else
+				result += this_bit;
+		}
+		this_bit *= 2;
+	}
+	return result;
+}
+
+static RTLIL::Const big2const(const BigInteger &val, int result_len)
+{
+	BigUnsigned mag = val.getMagnitude();
+	RTLIL::Const result(0, result_len);
+
+	if (!mag.isZero())
+	{
+		if (val.getSign() < 0)
+		{
+			mag--;
+			for (int i = 0; i < result_len; i++)
+				result.bits[i] = mag.getBit(i) ? RTLIL::State::S0 : RTLIL::State::S1;
+		}
+		else
+		{
+			for (int i = 0; i < result_len; i++)
+				result.bits[i] = mag.getBit(i) ? RTLIL::State::S1 : RTLIL::State::S0;
+		}
+	}
+
+	return result;
+}
+
+static RTLIL::Const big_add(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	return big2const(const2big(arg1, signed1) + const2big(arg2, signed2), result_len);
+}
+
+static RTLIL::Const big_sub(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	return big2const(const2big(arg1, signed1) - const2big(arg2, signed2), result_len);
+}
+
+static RTLIL::Const big_mul(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	return big2const(const2big(arg1, signed1) * const2big(arg2, signed2), result_len);
+}
+
+static RTLIL::Const big_div(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	BigInteger a = const2big(arg1, signed1);
+	BigInteger b = const2big(arg2, signed2);
+	bool result_neg = (a.getSign() == BigInteger::negative) != (b.getSign() == BigInteger::negative);
+	a = a.getSign() == BigInteger::negative ? -a : a;
+	b = b.getSign() == BigInteger::negative ? -b : b;
+	return big2const(result_neg ? -(a / b) : (a / b), result_len);
+}
+
+static RTLIL::Const big_mod(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	BigInteger a = const2big(arg1, signed1);
+	BigInteger b = const2big(arg2, signed2);
+	bool result_neg = a.getSign() == BigInteger::negative;
+	a = a.getSign() == BigInteger::negative ? -a : a;
+	b = b.getSign() == BigInteger::negative ? -b : b;
+	return big2const(result_neg ? -(a % b) : (a % b), result_len);
+}
+
+static RTLIL::Const big_pow(const RTLIL::Const &arg1, const RTLIL::Const &arg2, bool signed1, bool signed2, int result_len)
+{
+	BigInteger a = const2big(arg1, signed1);
+	BigInteger b = const2big(arg2, signed2);
+	BigInteger y = 1;
+	if (b < 0 || a == 0)
+		y = 0;
+	else
+		for (; b > 0; b--)
+			y = y * a;
+	return big2const(y, result_len);
+}
+
+typedef RTLIL::Const (*const_func_t)(const RTLIL::Const&, const RTLIL::Const&, bool, bool, int);
+
+static RTLIL::Const random_const(int width, bool nonzero)
+{
+	RTLIL::Const c(RTLIL::State::S0, width);
+	do {
+		for (int i = 0; i < width; i++)
+			c.bits[i] = rand() % 2 ? RTLIL::State::S1 : RTLIL::State::S0;
+	} while (nonzero && c.as_bool() == false);
+	return c;
+}
+
+static double bench(const_func_t func, const std::vector<RTLIL::Const> &a, const std::vector<RTLIL::Const> &b,
+		bool is_signed, int result_len, int rounds, std::vector<RTLIL::Const> &results)
+{
+	results.clear();
+	double t = now();
+	for (int r = 0; r < rounds; r++)
+		for (size_t i = 0; i < a.size(); i++) {
+			RTLIL::Const y = func(a[i], b[i], is_signed, is_signed, result_len);
+			if (r == 0)
+				results.push_back(y);
+		}
+	return now() - t;
+}
+
+int main(int argc, char **argv)
+{
+	int num_operands = argc > 1 ? atoi(argv[1]) : 10000;
+	int num_rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+	// b_width is the width of the second operand relative to the first: half
+	// as wide for div and mod (so that the results are not mostly zero) and
+	// 4 bits for pow (larger exponents always overflow the native types)
+	struct {
+		const char *name;
+		const_func_t native_func, big_func;
+		int b_width_div, b_width_max;
+		bool b_nonzero;
+	} ops[] = {
+		{ "add", RTLIL::const_add, big_add, 1, 0, false },
+		{ "sub", RTLIL::const_sub, big_sub, 1, 0, false },
+		{ "mul", RTLIL::const_mul, big_mul, 1, 0, false },
+		{ "div", RTLIL::const_div, big_div, 2, 0, true },
+		{ "mod", RTLIL::const_mod, big_mod, 2, 0, true },
+		{ "pow", RTLIL::const_pow, big_pow, 1, 4, false },
+	};
+
+	// the last width is too wide for the native path and measures the overhead of trying it
+	int widths[] = { 8, 32, 64, 100, 200 };
+	int errors = 0;
+
+	printf("%d operand pairs, %d rounds, ns/op:\n", num_operands, num_rounds);
+	printf("  %-10s %6s %12s %12s %10s\n", "", "width", "BigInteger", "native", "speedup");
+
+	srand(42);
+	for (auto &op : ops)
+	for (int width : widths)
+	for (int is_signed = 0; is_signed < 2; is_signed++)
+	{
+		int b_width = op.b_width_max ? op.b_width_max : width / op.b_width_div;
+		std::vector<RTLIL::Const> a, b, big_results, native_results;
+		for (int i = 0; i < num_operands; i++) {
+			a.push_back(random_const(width, false));
+			b.push_back(random_const(b_width, op.b_nonzero));
+		}
+
+		// also check results that are narrower than the operands, and results that
+		// are wider than the native types (sign extension in native2const), only
+		// the first result length is timed
+		int result_lens[] = { width, width / 2, width + 70 };
+		double t_big = 0, t_native = 0;
+
+		for (int result_len : result_lens)
+		{
+			int rounds = result_len == width ? num_rounds : 1;
+			double t = bench(op.big_func, a, b, is_signed, result_len, rounds, big_results);
+			double t2 = bench(op.native_func, a, b, is_signed, result_len, rounds, native_results);
+			if (result_len == width)
+				t_big = t, t_native = t2;
+
+			for (size_t i = 0; i < a.size(); i++)
+				if (big_results[i] != native_results[i]) {
+					fprintf(stderr, "Mismatch for %s: %s %s %s (%d bits) -> %s != %s\n", op.name, is_signed ? "signed" : "unsigned",
+							a[i].as_string().c_str(), b[i].as_string().c_str(), result_len,
+							native_results[i].as_string().c_str(), big_results[i].as_string().c_str());
+					errors++;
+					break;
+				}
+		}
+
+		size_t num_ops = a.size() * num_rounds;
+		printf("  %-10s %6d %12.1f %12.1f %9.2fx\n", stringf("%s%s", is_signed ? "s" : "u", op.name).c_str(),
+				width, 1e9 * t_big / num_ops, 1e9 * t_native / num_ops, t_big / t_native);
+	}
+
+	return errors ? 1 : 0;
+}
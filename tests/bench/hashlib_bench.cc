@@ -0,0 +1,214 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Compare std::map and hashlib::dict for the RTLIL::Module containers,
+ *  and check that hashlib::flat_dict and hashlib::dict do not grow under
+ *  erase/insert churn.
+ *
+ *  build: make tests/bench/hashlib_bench
+ *  usage: tests/bench/hashlib_bench [num_objects [num_rounds]]
+ *
+ */
+
+#include "kernel/rtlil.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <algorithm>
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+template<typename M>
+static double bench_insert(M &container, const std::vector<RTLIL::IdString> &names, const std::vector<RTLIL::Wire*> &objects)
+{
+	double t = now();
+	for (size_t i = 0; i < names.size(); i++)
+		container[names[i]] = objects[i];
+	return now() - t;
+}
+
+template<typename M>
+static double bench_lookup(const M &container, const std::vector<RTLIL::IdString> &probes, int rounds, size_t &checksum)
+{
+	double t = now();
+	for (int r = 0; r < rounds; r++)
+		for (auto &name : probes) {
+			auto it = container.find(name);
+			if (it != container.end())
+				checksum += it->second->width;
+		}
+	return now() - t;
+}
+
+template<typename M>
+static double bench_iterate(const M &container, int rounds, size_t &checksum)
+{
+	double t = now();
+	for (int r = 0; r < rounds; r++)
+		for (auto &it : container)
+			checksum += it.second->width;
+	return now() - t;
+}
+
+template<typename M>
+static double bench_erase(M &container, const std::vector<RTLIL::IdString> &probes)
+{
+	double t = now();
+	for (auto &name : probes)
+		container.erase(name);
+	return now() - t;
+}
+
+// erase/insert churn as in opt_const and opt_reduce (e.g. a cell port that is
+// removed and connected again) or in ModIndex (the bits of a connection are
+// erased and inserted again) must not grow a flat_dict or a dict, and the
+// remaining elements must keep their insertion order
+template<typename C>
+static bool check_churn(C &container, const char *name, int max_size, int num_rounds)
+{
+	std::vector<std::pair<int, int>> reference;
+	size_t max_memory = 0;
+	int next_key = 0;
+
+	srand(42);
+	for (int r = 0; r < num_rounds; r++)
+	{
+		if (reference.size() < 2 || (int(reference.size()) < max_size && rand() % 2 == 0)) {
+			container[next_key] = r;
+			reference.push_back(std::pair<int, int>(next_key++, r));
+		} else {
+			int idx = rand() % reference.size();
+			container.erase(reference[idx].first);
+			reference.erase(reference.begin() + idx);
+		}
+
+		if (container.size() != reference.size() || !std::equal(container.begin(), container.end(), reference.begin())) {
+			fprintf(stderr, "%s: wrong contents after %d erase/insert operations\n", name, r + 1);
+			return false;
+		}
+		if (r == num_rounds / 10)
+			max_memory = 2 * container.memory_usage() + 1024;
+		if (r > num_rounds / 10 && container.memory_usage() > max_memory) {
+			fprintf(stderr, "%s: memory usage grows under erase/insert churn (%zd bytes after %d operations)\n",
+					name, container.memory_usage(), r + 1);
+			return false;
+		}
+	}
+
+	printf("%s erase/insert churn: %d operations ok, max. %zd bytes allocated\n", name, num_rounds, container.memory_usage());
+	return true;
+}
+
+static bool check_flat_dict_churn(int num_rounds)
+{
+	hashlib::flat_dict<int, int, 4> container;
+	if (!check_churn(container, "flat_dict", 40, num_rounds))
+		return false;
+
+	// the erased inline slots at the end are reused
+	hashlib::flat_dict<int, int, 4> small;
+	for (int r = 0; r < num_rounds; r++) {
+		small[r % 3] = r;
+		small.erase(r % 3);
+	}
+	small[0] = 0;
+	if (small.memory_usage() != 0) {
+		fprintf(stderr, "flat_dict: erased inline slots are not reused\n");
+		return false;
+	}
+	return true;
+}
+
+static bool check_dict_churn(int num_rounds)
+{
+	hashlib::dict<int, int> container;
+	return check_churn(container, "dict", 40, num_rounds);
+}
+
+static void report(const char *what, size_t ops, double t_map, double t_dict)
+{
+	printf("  %-10s %12.1f %12.1f %9.2fx\n", what, 1e9 * t_map / ops, 1e9 * t_dict / ops, t_map / t_dict);
+}
+
+int main(int argc, char **argv)
+{
+	int num_objects = argc > 1 ? atoi(argv[1]) : 1000000;
+	int num_rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+	// names as generated by the frontends and by NEW_ID
+	std::vector<RTLIL::IdString> names;
+	std::vector<RTLIL::Wire*> objects;
+	for (int i = 0; i < num_objects; i++) {
+		if (i % 4 == 0)
+			names.push_back(stringf("\\data_bus_%d", i));
+		else
+			names.push_back(stringf("$auto$bench.cc:%d:main$%d", 100 + i % 7, i));
+		RTLIL::Wire *wire = new RTLIL::Wire;
+		wire->name = names.back();
+		wire->width = 1 + i % 32;
+		objects.push_back(wire);
+	}
+
+	std::vector<RTLIL::IdString> probes = names;
+	srand(42);
+	std::random_shuffle(probes.begin(), probes.end());
+	for (int i = 0; i < num_objects / 4; i++)
+		probes.push_back(stringf("\\missing_%d", i));
+
+	std::map<RTLIL::IdString, RTLIL::Wire*> map_wires;
+	RTLIL::Module *module = new RTLIL::Module;
+	size_t map_checksum = 0, dict_checksum = 0;
+
+	printf("%d objects, %d rounds, ns/op:\n", num_objects, num_rounds);
+	printf("  %-10s %12s %12s %10s\n", "", "std::map", "dict", "speedup");
+
+	double t_map = bench_insert(map_wires, names, objects);
+	double t_dict = bench_insert(module->wires, names, objects);
+	report("insert", names.size(), t_map, t_dict);
+
+	t_map = bench_lookup(map_wires, probes, num_rounds, map_checksum);
+	t_dict = bench_lookup(module->wires, probes, num_rounds, dict_checksum);
+	report("lookup", probes.size() * num_rounds, t_map, t_dict);
+
+	t_map = bench_iterate(map_wires, num_rounds, map_checksum);
+	t_dict = bench_iterate(module->wires, num_rounds, dict_checksum);
+	report("iterate", names.size() * num_rounds, t_map, t_dict);
+
+	t_map = bench_erase(map_wires, probes);
+	t_dict = bench_erase(module->wires, probes);
+	report("erase", probes.size(), t_map, t_dict);
+
+	if (map_checksum != dict_checksum) {
+		fprintf(stderr, "Checksum mismatch: %zd != %zd\n", map_checksum, dict_checksum);
+		return 1;
+	}
+
+	if (!check_flat_dict_churn(100000) || !check_dict_churn(100000))
+		return 1;
+
+	for (auto wire : objects)
+		delete wire;
+	delete module;
+	return 0;
+}
@@ -0,0 +1,415 @@
+/*
+ *  yosys -- Yosys Open SYnthesis Suite
+ *
+ *  Copyright (C) 2012  Clifford Wolf <clifford@clifford.at>
+ *
+ *  Permission to use, copy, modify, and/or distribute this software for any
+ *  purpose with or without fee is hereby granted, provided that the above
+ *  copyright notice and this permission notice appear in all copies.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ *  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ *  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ *  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ *  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ *  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ *  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *
+ *  ---
+ *
+ *  Measure the SigSpec, SigMap, SigPool, const_*, CellTypes and selection
+ *  primitives that dominate the run time of most passes, on a synthetic module with
+ *  wires of realistic widths and signals concatenated from slices of them.
+ *  The in-place operations (optimize, expand, replace) work on fresh copies
+ *  of the signals in every round, the copies are not included in the times.
+ *
+ *  build: make tests/bench/rtlil_bench
+ *  usage: tests/bench/rtlil_bench [num_signals [num_rounds]]
+ *
+ */
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include "kernel/celltypes.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+// the results of all operations are folded into this, so that none of them
+// can be optimized away
+static size_t checksum;
+
+static void report(const char *what, size_t ops, double t)
+{
+	printf("  %-28s %10zd %10.1f\n", what, ops, 1e9 * t / ops);
+}
+
+// measures body() num_rounds times, calling setup() untimed before each round
+template<typename S, typename B>
+static void bench(const char *what, size_t ops_per_round, int num_rounds, S setup, B body)
+{
+	double t = 0;
+	for (int r = 0; r < num_rounds; r++) {
+		setup();
+		double start = now();
+		body();
+		t += now() - start;
+	}
+	report(what, ops_per_round * num_rounds, t);
+}
+
+static RTLIL::SigSpec random_slice(const std::vector<RTLIL::Wire*> &wires)
+{
+	RTLIL::Wire *wire = wires[rand() % wires.size()];
+	int width = 1 + rand() % wire->width;
+	return RTLIL::SigSpec(wire, width, rand() % (wire->width - width + 1));
+}
+
+// a signal as found on a cell port: mostly one or a few wire slices, some
+// constant bits, between 1 and 64 bits wide
+static RTLIL::SigSpec random_signal(const std::vector<RTLIL::Wire*> &wires)
+{
+	RTLIL::SigSpec sig;
+	int num_parts = rand() % 4 == 0 ? 2 + rand() % 4 : 1;
+	for (int i = 0; i < num_parts; i++) {
+		if (i > 0 && rand() % 4 == 0)
+			sig.append(RTLIL::SigSpec(rand() % 2 ? RTLIL::State::S1 : RTLIL::State::S0, 1 + rand() % 8));
+		else
+			sig.append(random_slice(wires));
+	}
+	if (sig.width > 64)
+		sig = sig.extract(0, 64);
+	sig.optimize();
+	return sig;
+}
+
+static RTLIL::SigSpec random_subset(const RTLIL::SigSpec &sig)
+{
+	RTLIL::SigSpec subset;
+	for (auto bit : sig)
+		if (bit.wire != NULL && rand() % 2)
+			subset.append_bit(bit);
+	return subset;
+}
+
+static RTLIL::Const random_const(int width)
+{
+	RTLIL::Const c(RTLIL::State::S0, width);
+	for (int i = 0; i < width; i++)
+		c.bits[i] = rand() % 2 ? RTLIL::State::S1 : RTLIL::State::S0;
+	return c;
+}
+
+static void bench_sigspec(const std::vector<RTLIL::SigSpec> &signals, const std::vector<RTLIL::Wire*> &wires, int num_rounds)
+{
+	size_t n = signals.size();
+	std::vector<RTLIL::SigSpec> work, expanded, patterns, withs;
+
+	for (auto &sig : signals) {
+		RTLIL::SigSpec sig_expanded = sig;
+		sig_expanded.expand();
+		expanded.push_back(sig_expanded);
+		patterns.push_back(random_subset(sig));
+		RTLIL::SigSpec with;
+		while (with.width < patterns.back().width)
+			with.append(random_slice(wires));
+		withs.push_back(with.extract(0, patterns.back().width));
+	}
+
+	bench("SigSpec::optimize", n, num_rounds, [&]() { work = expanded; }, [&]() {
+		for (auto &sig : work) {
+			sig.optimize();
+			checksum += sig.chunks.size();
+		}
+	});
+
+	bench("SigSpec::expand", n, num_rounds, [&]() { work = signals; }, [&]() {
+		for (auto &sig : work) {
+			sig.expand();
+			checksum += sig.chunks.size();
+		}
+	});
+
+	bench("SigSpec::extract(pattern)", n, num_rounds, []() { }, [&]() {
+		for (size_t i = 0; i < n; i++)
+			checksum += signals[i].extract(patterns[i]).width;
+	});
+
+	bench("SigSpec::extract(ofs,len)", n, num_rounds, []() { }, [&]() {
+		for (size_t i = 0; i < n; i++) {
+			const RTLIL::SigSpec &sig = signals[i];
+			checksum += sig.extract(i % sig.width, (sig.width - i % sig.width + 1) / 2).chunks.size();
+		}
+	});
+
+	bench("SigSpec::replace(pattern)", n, num_rounds, [&]() { work = signals; }, [&]() {
+		for (size_t i = 0; i < n; i++) {
+			work[i].replace(patterns[i], withs[i]);
+			checksum += work[i].chunks.size();
+		}
+	});
+
+	bench("SigSpec::replace(ofs)", n, num_rounds, [&]() { work = signals; }, [&]() {
+		for (size_t i = 0; i < n; i++) {
+			const RTLIL::SigSpec &with = withs[i].width > 0 ? withs[i] : signals[i];
+			work[i].replace(0, with.extract(0, std::min(with.width, work[i].width)));
+			checksum += work[i].chunks.size();
+		}
+	});
+
+	// the same part of the signal as above, read through a SigSlice without a copy
+	bench("SigSlice iterate(ofs,len)", n, num_rounds, []() { }, [&]() {
+		for (size_t i = 0; i < n; i++) {
+			const RTLIL::SigSpec &sig = signals[i];
+			for (auto bit : sig.slice(i % sig.width, (sig.width - i % sig.width + 1) / 2))
+				checksum += bit.offset;
+		}
+	});
+
+	bench("SigSpec::replace(ofs,slice)", n, num_rounds, [&]() { work = signals; }, [&]() {
+		for (size_t i = 0; i < n; i++) {
+			const RTLIL::SigSpec &with = withs[i].width > 0 ? withs[i] : signals[i];
+			work[i].replace(0, with.slice(0, std::min(with.width, work[i].width)));
+			checksum += work[i].chunks.size();
+		}
+	});
+
+	// concatenations of a few signals, as built for the ports of $concat or $pmux cells
+	bench("SigSpec::append", n, num_rounds, []() { }, [&]() {
+		RTLIL::SigSpec sig;
+		for (size_t i = 0; i < n; i++) {
+			if (i % 8 == 0)
+				checksum += sig.chunks.size(), sig = RTLIL::SigSpec();
+			sig.append(signals[i]);
+		}
+	});
+
+	bench("SigSpec::operator==", n, num_rounds, []() { }, [&]() {
+		for (size_t i = 0; i < n; i++)
+			checksum += signals[i] == expanded[i];
+	});
+
+	size_t num_bits = 0;
+	for (auto &sig : signals)
+		num_bits += sig.width;
+
+	bench("SigSpec iterate (per bit)", num_bits, num_rounds, []() { }, [&]() {
+		for (auto &sig : signals)
+			for (auto bit : sig)
+				checksum += bit.offset;
+	});
+}
+
+static void bench_sigtools(RTLIL::Module *module, const std::vector<RTLIL::SigSpec> &signals, int num_rounds)
+{
+	size_t n = signals.size(), num_bits = 0;
+	for (auto &sig : signals)
+		num_bits += sig.width;
+
+	SigMap sigmap;
+	bench("SigMap::set (per conn)", module->connections.size(), num_rounds, []() { }, [&]() {
+		sigmap.set(module);
+	});
+
+	std::vector<RTLIL::SigSpec> work;
+	bench("SigMap::apply", n, num_rounds, [&]() { work = signals; }, [&]() {
+		for (auto &sig : work) {
+			sigmap.apply(sig);
+			checksum += sig.chunks.size();
+		}
+	});
+
+	// half of the signals are added to the pools, the other half is
+	// checked against them
+	SigPool pool;
+	bench("SigPool::add (per bit)", num_bits / 2, num_rounds, [&]() { pool.clear(); }, [&]() {
+		for (size_t i = 0; i < n; i += 2)
+			pool.add(signals[i]);
+	});
+
+	bench("SigPool::check_any", n, num_rounds, []() { }, [&]() {
+		for (auto &sig : signals)
+			checksum += pool.check_any(sig);
+	});
+
+	SigBitIndex index(module);
+	DenseSigPool dense_pool(&index);
+	bench("DenseSigPool::add (per bit)", num_bits / 2, num_rounds, [&]() { dense_pool.clear(); }, [&]() {
+		for (size_t i = 0; i < n; i += 2)
+			dense_pool.add(signals[i]);
+	});
+
+	bench("DenseSigPool::check_any", n, num_rounds, []() { }, [&]() {
+		for (auto &sig : signals)
+			checksum += dense_pool.check_any(sig);
+	});
+}
+
+static void bench_const(int num_operands, int num_rounds)
+{
+	typedef RTLIL::Const (*const_func_t)(const RTLIL::Const&, const RTLIL::Const&, bool, bool, int);
+
+	struct {
+		const char *name;
+		const_func_t func;
+	} ops[] = {
+		{ "not", RTLIL::const_not },
+		{ "and", RTLIL::const_and },
+		{ "xor", RTLIL::const_xor },
+		{ "reduce_or", RTLIL::const_reduce_or },
+		{ "logic_and", RTLIL::const_logic_and },
+		{ "shl", RTLIL::const_shl },
+		{ "eq", RTLIL::const_eq },
+		{ "lt", RTLIL::const_lt },
+		{ "add", RTLIL::const_add },
+		{ "mul", RTLIL::const_mul },
+	};
+
+	int widths[] = { 1, 8, 32, 64 };
+
+	for (int width : widths)
+	{
+		// the shift amount is kept small to get a non-trivial result
+		std::vector<RTLIL::Const> a, b, shift;
+		for (int i = 0; i < num_operands; i++) {
+			a.push_back(random_const(width));
+			b.push_back(random_const(width));
+			shift.push_back(RTLIL::Const(rand() % (width + 1), 8));
+		}
+
+		for (auto &op : ops) {
+			const std::vector<RTLIL::Const> &arg2 = op.func == RTLIL::const_shl ? shift : b;
+			bench(stringf("const_%s %d", op.name, width).c_str(), num_operands, num_rounds, []() { }, [&]() {
+				for (int i = 0; i < num_operands; i++)
+					checksum += op.func(a[i], arg2[i], false, false, width).bits.size();
+			});
+		}
+	}
+}
+
+static void bench_celltypes(RTLIL::Design *design, int num_lookups, int num_rounds)
+{
+	CellTypes ct(design);
+	std::vector<std::string> types = { "$and", "$mux", "$dff", "$_AND_", "$_DFF_P_", "$memrd", "$fsm", "\\bench_top", "\\unknown" };
+	std::vector<std::string> ports = { "\\A", "\\B", "\\Y", "\\Q", "\\S", "\\CLK", "\\DATA" };
+
+	std::vector<std::pair<std::string, std::string>> probes;
+	for (int i = 0; i < num_lookups; i++)
+		probes.push_back(std::pair<std::string, std::string>(types[rand() % types.size()], ports[rand() % ports.size()]));
+
+	bench("CellTypes::cell_known", probes.size(), num_rounds, []() { }, [&]() {
+		for (auto &it : probes)
+			checksum += ct.cell_known(it.first);
+	});
+
+	bench("CellTypes::cell_output", probes.size(), num_rounds, []() { }, [&]() {
+		for (auto &it : probes)
+			checksum += ct.cell_output(it.first, it.second);
+	});
+
+	bench("CellTypes::cell_input", probes.size(), num_rounds, []() { }, [&]() {
+		for (auto &it : probes)
+			checksum += ct.cell_input(it.first, it.second);
+	});
+
+	RTLIL::Const a = random_const(32), b = random_const(32);
+	bench("CellTypes::eval $add 32", probes.size(), num_rounds, []() { }, [&]() {
+		for (size_t i = 0; i < probes.size(); i++)
+			checksum += ct.eval("$add", a, b, false, false, 32).bits.size();
+	});
+}
+
+static void bench_idstring(int num_lookups, int num_rounds)
+{
+	const char *names[] = { "\\A", "\\B", "\\Y", "\\S", "\\A_WIDTH", "\\B_WIDTH", "\\Y_WIDTH", "\\A_SIGNED" };
+
+	bench("IdString(const char*)", num_lookups, num_rounds, []() { }, [&]() {
+		for (int i = 0; i < num_lookups; i++)
+			checksum += RTLIL::IdString(names[i % 8]).index_;
+	});
+}
+
+static void bench_selection(RTLIL::Design *design, RTLIL::Module *module, int num_rounds)
+{
+	RTLIL::Selection sel(false);
+	for (auto &it : module->wires)
+		if (rand() % 2)
+			sel.selected_members[module->name].insert(it.first);
+	design->selection_stack.push_back(sel);
+
+	bench("Design::selected (partial)", module->wires.size(), num_rounds, []() { }, [&]() {
+		for (auto &it : module->wires)
+			checksum += design->selected(module, it.second);
+	});
+
+	RTLIL::Selection other(false);
+	for (auto &it : module->wires)
+		if (rand() % 2)
+			other.selected_members[module->name].insert(it.first);
+
+	RTLIL::IdSet work;
+	bench("IdSet::operator&=", module->wires.size(), num_rounds, [&]() { work = sel.selected_members.at(module->name); }, [&]() {
+		work &= other.selected_members.at(module->name);
+		checksum += work.size();
+	});
+
+	design->selection_stack.pop_back();
+}
+
+int main(int argc, char **argv)
+{
+	int num_signals = argc > 1 ? atoi(argv[1]) : 10000;
+	int num_rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+	srand(42);
+
+	RTLIL::Design *design = new RTLIL::Design;
+	RTLIL::Module *module = new RTLIL::Module;
+	module->name = "\\bench_top";
+	design->modules[module->name] = module;
+
+	// wire widths as found in typical designs: mostly single bits, some buses
+	int bus_widths[] = { 1, 1, 1, 1, 2, 4, 8, 8, 16, 32, 64 };
+	std::vector<RTLIL::Wire*> wires;
+	for (int i = 0; i < num_signals; i++)
+		wires.push_back(module->addWire(stringf("\\w%d", i), bus_widths[rand() % 11]));
+
+	// connect a quarter of the wire bits to other wires, so that SigMap has
+	// something to do
+	for (int i = 0; i < num_signals / 4; i++) {
+		RTLIL::SigSpec lhs = random_slice(wires), rhs = random_slice(wires);
+		int width = std::min(lhs.width, rhs.width);
+		module->connect(RTLIL::SigSig(lhs.extract(0, width), rhs.extract(0, width)));
+	}
+
+	std::vector<RTLIL::SigSpec> signals;
+	for (int i = 0; i < num_signals; i++)
+		signals.push_back(random_signal(wires));
+
+	size_t num_bits = 0, num_chunks = 0;
+	for (auto &sig : signals)
+		num_bits += sig.width, num_chunks += sig.chunks.size();
+
+	printf("%d signals (%.1f bits, %.2f chunks avg), %d rounds:\n", num_signals,
+			double(num_bits) / num_signals, double(num_chunks) / num_signals, num_rounds);
+	printf("  %-28s %10s %10s\n", "", "ops", "ns/op");
+
+	bench_sigspec(signals, wires, num_rounds);
+	bench_sigtools(module, signals, num_rounds);
+	bench_const(num_signals / 10, num_rounds);
+	bench_celltypes(design, num_signals, num_rounds);
+	bench_idstring(num_signals, num_rounds);
+	bench_selection(design, module, num_rounds);
+
+	printf("checksum: %zx\n", checksum);
+
+	delete design;
+	return 0;
+}
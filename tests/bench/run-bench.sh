@@ -0,0 +1,151 @@
+#!/bin/bash
+#
+# Run a fixed synthesis script over the bundled test designs and over
+# synthetic designs of increasing size (created by the gen_design command
+# with some hierarchy, memories and FSMs), record the time and memory spent per
+# pass and compare the results against a stored baseline.
+#
+# usage: run-bench.sh [-o results_file] [-b baseline_file] [-s "scales"] [-r repeat] [-t tolerance] [-u]
+#
+#   -o results_file   write the results to this file (default: results.tsv)
+#   -b baseline_file  compare against this file (default: baseline.tsv)
+#   -s scales         number of cells in the synthetic designs (default: "250 1000")
+#   -r repeat         run everything this many times and keep the fastest time (default: 1)
+#   -t tolerance      relative slowdown that counts as a regression (default: 0.2)
+#   -u                store the results as the new baseline
+#
+# The results file has one line per suite and pass with the number of calls,
+# the wall time spent in the pass itself (without nested passes) and the
+# growth of the peak RSS during the pass. The line with the pass name TOTAL
+# has the number of yosys runs, the total wall time and the largest peak RSS
+# of all runs of the suite.
+#
+# The exit status is 1 if a pass or a suite is slower than the baseline by
+# more than the tolerance, or if the peak RSS of a suite grew by more than
+# the tolerance. Entries that took less than 0.25 seconds in the baseline are
+# ignored because their timing is too noisy.
+
+set -e
+shopt -s nullglob
+cd "$(dirname "$0")"
+
+results=results.tsv
+baseline=baseline.tsv
+scales="250 1000"
+repeat=1
+tolerance=0.2
+update_baseline=false
+
+while getopts "o:b:s:r:t:u" opt; do
+	case "$opt" in
+		o) results="$OPTARG" ;;
+		b) baseline="$OPTARG" ;;
+		s) scales="$OPTARG" ;;
+		r) repeat="$OPTARG" ;;
+		t) tolerance="$OPTARG" ;;
+		u) update_baseline=true ;;
+		*) sed -n '7,15p' "$0" >&2; exit 1 ;;
+	esac
+done
+
+yosys=../../yosys
+script="hierarchy; proc; opt; memory; opt; fsm; opt; techmap; opt; clean"
+gen_script="hierarchy -top gen_top; memory; flatten; hierarchy -top gen_top; opt; fsm; opt; techmap; opt; clean"
+gen_options="-depth 1 -branch 4 -unique -memories 1 -fsms 1"
+workdir=bench_work
+rm -rf $workdir
+mkdir -p $workdir
+
+# run_suite <name> <script> <files...>: one yosys run per file (or file group separated by ',')
+# run_suite <name> <script> "": a single yosys run without input files
+run_suite() {
+	local suite=$1 script=$2 runs=0 failed=0 start end
+	shift 2
+	start=$(date +%s%N)
+	for group; do
+		runs=$((runs+1))
+		if ! $yosys -q -P $workdir/$suite.$runs.json -p "$script" ${group//,/ } > /dev/null 2> $workdir/$suite.$runs.err; then
+			failed=$((failed+1))
+			rm -f $workdir/$suite.$runs.json
+		fi
+	done
+	end=$(date +%s%N)
+	[ $failed -eq 0 ] || echo "$suite: $failed of $runs runs failed (see $workdir/$suite.*.err)" >&2
+	echo "$suite: $runs runs in $(awk -v ns=$((end-start)) 'BEGIN { printf "%.2f", ns*1e-9 }') s" >&2
+
+	cat $workdir/$suite.*.json /dev/null | awk -v suite=$suite -v runs=$runs -v wall_ns=$((end-start)) '
+		/"peak_rss_kb":/ { gsub(/[^0-9]/, "", $2); if ($2+0 > peak) peak = $2+0 }
+		/"name":/ {
+			match($0, /"name": "[^"]*"/); name = substr($0, RSTART+9, RLENGTH-10)
+			match($0, /"calls": [0-9]+/); calls[name] += substr($0, RSTART+9, RLENGTH-9)
+			match($0, /"self_wall_ns": [0-9-]+/); wall[name] += substr($0, RSTART+16, RLENGTH-16)
+			match($0, /"rss_growth_kb": [0-9-]+/); rss[name] += substr($0, RSTART+17, RLENGTH-17)
+		}
+		END {
+			for (name in calls)
+				printf "%s\t%s\t%d\t%.4f\t%d\n", suite, name, calls[name], wall[name]*1e-9, rss[name]
+			printf "%s\tTOTAL\t%d\t%.4f\t%d\n", suite, runs, wall_ns*1e-9, peak
+		}' | sort -k2,2 >> $workdir/results.$rep.tsv
+	rm -f $workdir/$suite.*.json
+}
+
+for ((rep = 1; rep <= repeat; rep++)); do
+	run_suite simple "$script" ../simple/*.v
+	run_suite hana "$script" $(ls ../hana/*.v | grep -v hana_vlib.v)
+	run_suite asicworld "$script" $(ls ../asicworld/*.v | grep -v _tb.v)
+	run_suite i2c "$script" ../i2c_bench/i2c_master_top.v,../i2c_bench/i2c_master_bit_ctrl.v,../i2c_bench/i2c_master_byte_ctrl.v
+	for n in $scales; do
+		run_suite gen_$n "gen_design -cells $n $gen_options; $gen_script" ""
+	done
+done
+
+# keep the fastest time and the largest memory of all repetitions
+{
+	echo -e "# suite\tpass\tcalls\tself_wall_s\trss_kb"
+	cat $workdir/results.*.tsv | awk -F '\t' '
+		{
+			key = $1 "\t" $2
+			if (!(key in wall)) { order[n++] = key; calls[key] = $3; wall[key] = $4; rss[key] = $5 }
+			if ($4 < wall[key]) wall[key] = $4
+			if ($5 > rss[key]) rss[key] = $5
+		}
+		END {
+			for (i = 0; i < n; i++)
+				printf "%s\t%d\t%.4f\t%d\n", order[i], calls[order[i]], wall[order[i]], rss[order[i]]
+		}'
+} > $results
+echo "Results written to $results." >&2
+
+if $update_baseline; then
+	cp $results $baseline
+	echo "Stored results as new baseline $baseline." >&2
+	exit 0
+fi
+
+if [ ! -f $baseline ]; then
+	echo "No baseline $baseline found, run 'make bench-baseline' to create one." >&2
+	exit 0
+fi
+
+awk -v tol=$tolerance -F '\t' '
+	/^#/ { next }
+	FNR == NR { base_wall[$1 "\t" $2] = $4; base_rss[$1 "\t" $2] = $5; next }
+	($1 "\t" $2) in base_wall {
+		key = $1 "\t" $2
+		if (base_wall[key] >= 0.25 && $4 > base_wall[key] * (1 + tol)) {
+			printf "SLOWER  %-12s %-16s %8.3f s -> %8.3f s (%+.0f%%)\n", $1, $2, base_wall[key], $4, 100*($4/base_wall[key]-1)
+			regressions++
+		} else if (base_wall[key] >= 0.25 && $4 < base_wall[key] * (1 - tol))
+			printf "faster  %-12s %-16s %8.3f s -> %8.3f s (%+.0f%%)\n", $1, $2, base_wall[key], $4, 100*($4/base_wall[key]-1)
+		if ($2 == "TOTAL" && base_rss[key] > 0 && $5 > base_rss[key] * (1 + tol)) {
+			printf "BIGGER  %-12s %-16s %8d kB -> %8d kB (%+.0f%%)\n", $1, "peak RSS", base_rss[key], $5, 100*($5/base_rss[key]-1)
+			regressions++
+		}
+	}
+	END {
+		if (regressions > 0) {
+			printf "%d regressions compared to the baseline.\n", regressions
+			exit 1
+		}
+		print "No regressions compared to the baseline."
+	}' $baseline $results
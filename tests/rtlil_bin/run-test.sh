@@ -0,0 +1,76 @@
+#!/bin/bash
+#
+# Round-trip test for the binary RTLIL checkpoint format: every design in
+# tests/simple is written with write_rtlil_bin and read back with
+# read_rtlil_bin, and the ilang dumps before and after must be identical.
+# Then truncated and corrupted copies of the checkpoints are read, which must
+# fail with an error message and not crash. The same goes for a process with
+# more nested cases than the reader accepts.
+#
+
+set -e
+cd "$(dirname "$0")"
+make -C ../.. yosys
+yosys=../../yosys
+
+rm -rf work
+mkdir -p work
+
+for fn in ../simple/*.v; do
+	bn=$(basename $fn .v)
+	echo -n "Testing $bn.."
+	$yosys -q -p "read_verilog $fn; hierarchy; proc; opt; memory -nomap; write_ilang work/$bn.il; write_rtlil_bin work/$bn.rtlb"
+	$yosys -q -p "read_rtlil_bin work/$bn.rtlb; write_ilang work/$bn.rt.il"
+	if ! cmp -s work/$bn.il work/$bn.rt.il; then
+		echo " ERROR: round trip changes the design:"
+		diff -u work/$bn.il work/$bn.rt.il | head -20
+		exit 1
+	fi
+
+	size=$(stat -c %s work/$bn.rtlb)
+	for ((i = 1; i < 16; i++)); do
+		offset=$((size * i / 16))
+		head -c $offset work/$bn.rtlb > work/$bn.trunc.rtlb
+		cp work/$bn.rtlb work/$bn.corrupt.rtlb
+		printf '\xff\xff\xff\x7f' | dd of=work/$bn.corrupt.rtlb bs=1 seek=$offset conv=notrunc 2> /dev/null
+		for f in work/$bn.trunc.rtlb work/$bn.corrupt.rtlb; do
+			status=0
+			$yosys -q -p "read_rtlil_bin $f" > work/$bn.log 2>&1 || status=$?
+			if [ $status -gt 1 ]; then
+				echo " ERROR: reading $f (modified at offset $offset) crashed with status $status:"
+				tail -n 5 work/$bn.log
+				exit 1
+			fi
+		done
+	done
+	echo " ok."
+done
+
+# u64 value: write a little endian 64 bit integer
+u64() {
+	local i
+	for ((i = 0; i < 8; i++)); do
+		printf '\\x%02x' $((($1 >> (8*i)) & 255))
+	done
+}
+
+# module \m with a process \p whose case rules are nested 100000 levels deep:
+# each level is a case (no compares, no actions, one switch) holding a switch
+# (no attributes, empty signal, one case)
+echo -n "Testing deep_case.."
+{
+	printf 'YSRTLBIN'; printf "$(u64 1)" | head -c 4; printf "$(u64 0)" | head -c 4
+	printf "$(u64 48)$(u64 1)$(u64 56)$(u64 2)"
+	printf "$(u64 64)"
+	printf '\x02\\m\x00\x02\\p\x00'
+	printf '\x00\x00\x00\x00\x00\x01\x01\x00'
+	printf '\x00\x00\x01\x00\x00\x01%.0s' $(seq 100000)
+} > work/deep_case.rtlb
+status=0
+$yosys -q -p "read_rtlil_bin work/deep_case.rtlb" > work/deep_case.log 2>&1 || status=$?
+if [ $status -ne 1 ] || ! grep -q "truncated or corrupt" work/deep_case.log; then
+	echo " ERROR: reading deeply nested cases failed with status $status:"
+	tail -n 5 work/deep_case.log
+	exit 1
+fi
+echo " ok."